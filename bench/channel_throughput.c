@@ -0,0 +1,67 @@
+/* Messages per second between two isolates, one sending and one receiving on a channel.
+ *
+ * usage: ant_channel_bench [messages per run] [channel capacity]
+ * Each run sends a different kind of message. f64arrays are moved and the list of the same
+ * size is copied, the difference between the two is what the move saves. Received values live
+ * until the isolate ends, so the large messages are sent fewer times.
+ */
+
+#include "isolate.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct {
+   const char *name;
+   const char *setup;     /* runs once in the sending isolate */
+   const char *message;   /* expression sent each time */
+   int32_t     divisor;   /* of the messages per run */
+}Workload;
+
+static const Workload workloads[] = {
+   {"number",          "",                                                     "i",              1},
+   {"string",          "let word = \"message\";",                              "word",           1},
+   {"f64array(1024)",  "",                                                     "f64array(1024)", 64},
+   {"list(1024)",      "let items = []; for j in 0..1024 { push(items, j); }", "items",          64},
+};
+
+static double now_seconds(void);
+
+int main(int ac, char *av[]) {
+   int32_t count    = ac > 1 ? atoi(av[1]) : 200000;
+   int32_t capacity = ac > 2 ? atoi(av[2]) : 1024;
+   char sender[512];
+   char receiver[256];
+
+   printf("messages per run: %d, channel capacity: %d\n", count, capacity);
+
+   for (size_t w = 0; w < sizeof(workloads) / sizeof(workloads[0]); w++) {
+      int32_t messages = count / workloads[w].divisor;
+
+      snprintf(receiver, sizeof(receiver),
+               "let ch = isolate_channel(); for i in 0..%d { receive(ch); }", messages);
+      snprintf(sender, sizeof(sender),
+               "let ch = isolate_channel(); %s for i in 0..%d { send(ch, %s); }",
+               workloads[w].setup, messages, workloads[w].message);
+
+      Channel *channel = ant_channel.new(capacity);
+      double start     = now_seconds();
+
+      Isolate *to   = ant_isolate.start(receiver, channel);
+      Isolate *from = ant_isolate.start(sender, channel);
+      bool ok       = ant_isolate.join(from) & ant_isolate.join(to);
+
+      double elapsed = now_seconds() - start;
+      ant_channel.release(channel);
+
+      printf("%-16s %12.0f messages/s  %s\n", workloads[w].name, messages / elapsed, ok ? "" : "errors");
+   }
+
+   return 0;
+}
+
+static double now_seconds(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
@@ -0,0 +1,393 @@
+/* Nanoseconds per operation of the runtime data structures, one subsystem at a time.
+ *
+ * usage: ant_micro_bench [scale]
+ * Each benchmark runs its loop a few times and keeps the fastest run, so the figure is what the
+ * code costs with warm caches. The scale multiplies the iterations, 1 takes about a second.
+ * Objects made by a run are released after it, outside of the timing, so each run starts from
+ * the same context.
+ */
+
+#include "chunk.h"
+#include "context.h"
+#include "lines.h"
+#include "scanner.h"
+#include "strings.h"
+#include "table.h"
+#include "upvalues.h"
+#include "utils.h"
+#include "value.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define REPEATS 5
+#define KEY_COUNT 1024
+#define UPVALUE_SLOTS 8
+
+typedef struct {
+   const char  *name;
+   double     (*run)(int64_t iterations);   /* returns the bytes processed, 0 for none */
+   int64_t      iterations;
+}Benchmark;
+
+static double bench_table_set(int64_t iterations);
+static double bench_table_get(int64_t iterations);
+static double bench_table_find(int64_t iterations);
+static double bench_string_new_interned(int64_t iterations);
+static double bench_string_new(int64_t iterations);
+static double bench_string_concat(int64_t iterations);
+static double bench_hash_short(int64_t iterations);
+static double bench_hash_long(int64_t iterations);
+static double bench_scan_token(int64_t iterations);
+static double bench_scan_generated(int64_t iterations);
+static double bench_chunk_write(int64_t iterations);
+static double bench_line_write(int64_t iterations);
+static double bench_line_get(int64_t iterations);
+static double bench_capture_upvalue(int64_t iterations);
+
+static double now_ns(void);
+static void make_keys(void);
+static void make_generated(void);
+
+static const Benchmark benchmarks[] = {
+   {"table set",                 bench_table_set,           4000000},
+   {"table get",                 bench_table_get,           8000000},
+   {"table find",                bench_table_find,          4000000},
+   {"string new, interned",      bench_string_new_interned, 4000000},
+   {"string new",                bench_string_new,          1000000},
+   {"string concat",             bench_string_concat,       1000000},
+   {"hash, 16 bytes",            bench_hash_short,          8000000},
+   {"hash, 4 KB",                bench_hash_long,           40000},
+   {"scanner scan_token",        bench_scan_token,          2000000},
+   {"scanner, generated code",   bench_scan_generated,      2000000},
+   {"chunk write",               bench_chunk_write,         8000000},
+   {"line write",                bench_line_write,          8000000},
+   {"line get",                  bench_line_get,            2000000},
+   {"upvalue capture",           bench_capture_upvalue,     4000000},
+};
+
+static ObjectString *keys[KEY_COUNT];
+static char long_text[4096];
+static char generated[65536];
+static volatile uint64_t sink;
+
+int main(int ac, char *av[]) {
+   double scale = ac > 1 ? atof(av[1]) : 1;
+
+   AntContext *context = ant_context.new();
+   ant_context.make_current(context);
+   make_keys();
+   make_generated();
+
+   printf("%-24s %12s %12s\n", "benchmark", "ns/op", "MB/s");
+
+   for (size_t b = 0; b < sizeof(benchmarks) / sizeof(benchmarks[0]); b++) {
+      int64_t iterations = (int64_t)(benchmarks[b].iterations * scale);
+      iterations         = iterations < 1 ? 1 : iterations;
+      double best        = -1;
+      double bytes       = 0;
+
+      for (int32_t r = 0; r < REPEATS; r++) {
+         Object *mark   = ant_context.mark(context);
+         double start   = now_ns();
+         bytes          = benchmarks[b].run(iterations);
+         double elapsed = now_ns() - start;
+         best           = best < 0 || elapsed < best ? elapsed : best;
+         ant_context.release(context, mark);
+      }
+
+      printf("%-24s %12.2f", benchmarks[b].name, best / iterations);
+
+      if (bytes > 0) {
+         printf(" %12.1f", bytes / (best / 1e9) / 1e6);
+      }
+
+      printf("\n");
+   }
+
+   ant_context.free(context);
+   return 0;
+}
+
+/* interned keys like the names of globals, hits and misses alike */
+
+static void make_keys(void) {
+   char name[32];
+
+   for (int32_t i = 0; i < KEY_COUNT; i++) {
+      int32_t length = snprintf(name, sizeof(name), "key_%d", i);
+      keys[i]        = ant_string.new(name, length);
+   }
+
+   for (size_t i = 0; i < sizeof(long_text); i++) {
+      long_text[i] = (char)('a' + i % 26);
+   }
+}
+
+/* */
+
+static double bench_table_set(int64_t iterations) {
+   Table table;
+   ant_table.init(&table);
+
+   for (int64_t i = 0; i < iterations; i++) {
+      ant_table.set(&table, keys[i & (KEY_COUNT - 1)], ant_value.from_number((double)i));
+   }
+
+   ant_table.free(&table);
+   return 0;
+}
+
+/* */
+
+static double bench_table_get(int64_t iterations) {
+   Table table;
+   ant_table.init(&table);
+
+   for (int32_t i = 0; i < KEY_COUNT; i += 2) {
+      ant_table.set(&table, keys[i], ant_value.from_number(i));
+   }
+
+   Value value;
+   uint64_t found = 0;
+
+   for (int64_t i = 0; i < iterations; i++) {
+      found += ant_table.get(&table, keys[i & (KEY_COUNT - 1)], &value);
+   }
+
+   sink = found;
+   ant_table.free(&table);
+   return 0;
+}
+
+/* the lookup interning does, by chars and hash */
+
+static double bench_table_find(int64_t iterations) {
+   Table *strings = &CURRENT_CONTEXT()->strings;
+   uint64_t found = 0;
+
+   for (int64_t i = 0; i < iterations; i++) {
+      ObjectString *key = keys[i & (KEY_COUNT - 1)];
+      found += ant_table.find(strings, key->chars, key->length, key->hash) != NULL;
+   }
+
+   sink = found;
+   return 0;
+}
+
+/* */
+
+static double bench_string_new_interned(int64_t iterations) {
+   uint64_t total = 0;
+
+   for (int64_t i = 0; i < iterations; i++) {
+      ObjectString *key = keys[i & (KEY_COUNT - 1)];
+      total += ant_string.new(key->chars, key->length)->length;
+   }
+
+   sink = total;
+   return 0;
+}
+
+/* strings not interned yet, each one allocated, hashed and added to the strings table */
+
+static double bench_string_new(int64_t iterations) {
+   char text[32];
+   uint64_t total = 0;
+
+   for (int64_t i = 0; i < iterations; i++) {
+      int32_t length = snprintf(text, sizeof(text), "fresh_%ld", (long)i);
+      total += ant_string.new(text, length)->length;
+   }
+
+   sink = total;
+   return 0;
+}
+
+/* */
+
+static double bench_string_concat(int64_t iterations) {
+   uint64_t total = 0;
+
+   for (int64_t i = 0; i < iterations; i++) {
+      Value a = ant_value.from_object(STRING_AS_OBJECT(keys[i & (KEY_COUNT - 1)]));
+      Value b = ant_value.from_object(STRING_AS_OBJECT(keys[(i >> 10) & (KEY_COUNT - 1)]));
+      total += ant_string.concat(a, b)->length;
+   }
+
+   sink = total;
+   return 0;
+}
+
+/* */
+
+static double bench_hash_short(int64_t iterations) {
+   uint64_t total = 0;
+
+   for (int64_t i = 0; i < iterations; i++) {
+      total += ant_utils.hash(long_text + (i & 255), 16);
+   }
+
+   sink = total;
+   return 16.0 * iterations;
+}
+
+/* */
+
+static double bench_hash_long(int64_t iterations) {
+   uint64_t total = 0;
+
+   for (int64_t i = 0; i < iterations; i++) {
+      long_text[0] = (char)i;
+      total += ant_utils.hash(long_text, sizeof(long_text));
+   }
+
+   sink = total;
+   return (double)sizeof(long_text) * iterations;
+}
+
+/* tokens of a source the size of a small script, scanned over and over */
+
+static double bench_scan_token(int64_t iterations) {
+   static const char *source =
+      "fn fib(n) {\n"
+      "   if (n < 2) return n;   # base case\n"
+      "   return fib(n - 2) + fib(n - 1);\n"
+      "}\n"
+      "let words = {\"one\": 1, \"two\": 2.5};\n"
+      "for i in 0..100 { words[\"w${i}\"] = fib(i / 10); }\n"
+      "while (true) { print \"done\"; }\n";
+
+   Scanner scanner;
+   ant_scanner.init(&scanner, source);
+   double bytes = 0;
+
+   for (int64_t i = 0; i < iterations; i++) {
+      Token token = ant_scanner.scan_token(&scanner);
+
+      if (token.type == TOKEN_EOF) {
+         bytes += (double)strlen(source);
+         ant_scanner.init(&scanner, source);
+      }
+   }
+
+   return bytes;
+}
+
+/* the shape of machine generated scripts: deep indentation, long names, numbers and comments */
+
+static void make_generated(void) {
+   size_t length = 0;
+
+   for (int32_t i = 0; length + 160 < sizeof(generated); i++) {
+      length += (size_t)snprintf(generated + length, sizeof(generated) - length,
+                                 "            let generated_value_%d = previous_result_%d * 1234567 + %d.25;   # step %d\n",
+                                 i, i / 2, i, i);
+   }
+}
+
+/* */
+
+static double bench_scan_generated(int64_t iterations) {
+   Scanner scanner;
+   ant_scanner.init(&scanner, generated);
+   double bytes = 0;
+
+   for (int64_t i = 0; i < iterations; i++) {
+      Token token = ant_scanner.scan_token(&scanner);
+
+      if (token.type == TOKEN_EOF) {
+         bytes += (double)strlen(generated);
+         ant_scanner.init(&scanner, generated);
+      }
+   }
+
+   return bytes;
+}
+
+/* a new line every 8 bytes and a new column every byte, a run per byte at worst */
+
+static double bench_chunk_write(int64_t iterations) {
+   Chunk chunk;
+   ant_chunk.init(&chunk);
+
+   for (int64_t i = 0; i < iterations; i++) {
+      ant_chunk.write(&chunk, (uint8_t)i, (int32_t)(i >> 3) + 1, (int32_t)(i & 7) + 1);
+   }
+
+   ant_chunk.free(&chunk);
+   return 0;
+}
+
+/* */
+
+static double bench_line_write(int64_t iterations) {
+   Lines lines;
+   ant_line.init(&lines);
+
+   for (int64_t i = 0; i < iterations; i++) {
+      ant_line.write(&lines, (int32_t)(i >> 3) + 1, (int32_t)(i & 7) + 1, (int32_t)i);
+   }
+
+   ant_line.free(&lines);
+   return 0;
+}
+
+/* lookups spread over a function of 64K bytes of code, like stack traces and profilers do */
+
+static double bench_line_get(int64_t iterations) {
+   const int32_t code_size = 65536;
+
+   Lines lines;
+   ant_line.init(&lines);
+
+   for (int32_t i = 0; i < code_size; i++) {
+      ant_line.write(&lines, (i >> 3) + 1, (i & 7) + 1, i);
+   }
+
+   uint64_t total = 0;
+
+   for (int64_t i = 0; i < iterations; i++) {
+      total += ant_line.get(&lines, (int32_t)((i * 40503) & (code_size - 1)));
+   }
+
+   sink = total;
+   ant_line.free(&lines);
+   return 0;
+}
+
+/* closures capturing the same locals of a frame: a new upvalue, then open ones found again */
+
+static double bench_capture_upvalue(int64_t iterations) {
+   Value slots[UPVALUE_SLOTS];
+   UpvalueList open = {NULL};
+   uint64_t total   = 0;
+
+   for (int32_t i = 0; i < UPVALUE_SLOTS; i++) {
+      slots[i] = ant_value.from_number(i);
+   }
+
+   for (int64_t i = 0; i < iterations; i++) {
+      int32_t slot = (int32_t)(i % UPVALUE_SLOTS);
+      total += (uintptr_t)ant_upvalues.capture(&open, &slots[slot]) & 1;
+
+      /* the frame returns every 64 captures */
+      if ((i & 63) == 63) {
+         ant_upvalues.close(&open, &slots[0]);
+      }
+   }
+
+   ant_upvalues.close(&open, &slots[0]);
+   sink = total;
+   return 0;
+}
+
+/* */
+
+static double now_ns(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
@@ -0,0 +1,58 @@
+/* Speedup of parallel_map and parallel_reduce over a numeric workload as threads are added.
+ *
+ * usage: ant_parallel_bench [items] [max threads]
+ * Each item runs a loop of floating point work in Ant, so the time goes to the interpreter
+ * and not to passing results back. The pool is restarted with each thread count and the time
+ * of one thread is the baseline, speedup can't go past the number of cores.
+ */
+
+#include "parallel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+static const char *workload =
+   "let items = []; for i in 0..%d { push(items, i); }"
+   "fn work(x) { let y = x; for j in 0..200 { y = y * 0.5 + j; } return y; }"
+   "fn add(a, b) { return a + b; }"
+   "let mapped = parallel_map(items, work);"
+   "let total = parallel_reduce(mapped, add, 0);";
+
+static double now_seconds(void);
+
+int main(int ac, char *av[]) {
+   int32_t items       = ac > 1 ? atoi(av[1]) : 20000;
+   long cores          = sysconf(_SC_NPROCESSORS_ONLN);
+   int32_t max_threads = ac > 2 ? atoi(av[2]) : (cores < 4 ? 4 : (int32_t)cores);
+   char source[512];
+   double baseline = 0;
+
+   snprintf(source, sizeof(source), workload, items);
+   printf("items: %d, cores: %ld\n", items, cores);
+
+   for (int32_t threads = 1; threads <= max_threads; threads *= 2) {
+      if (!ant_parallel.start(threads)) {
+         return 1;
+      }
+
+      VM *vm       = ant_vm.new();
+      double start = now_seconds();
+      bool ok      = ant_vm.interpret(vm, source) == INTERPRET_OK;
+      double elapsed = now_seconds() - start;
+
+      ant_vm.free(vm);
+      ant_parallel.stop();
+
+      baseline = threads == 1 ? elapsed : baseline;
+      printf("%3d threads %10.3f s  %6.2fx  %s\n", threads, elapsed, baseline / elapsed, ok ? "" : "errors");
+   }
+
+   return 0;
+}
+
+static double now_seconds(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
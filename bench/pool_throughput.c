@@ -0,0 +1,83 @@
+/* Scripts per second through ant_pool for 1, 2, 4 .. up to the core count.
+ *
+ * usage: ant_pool_bench [script.ant] [scripts per run]
+ * Without a script a small built-in workload is used. The script should not print.
+ */
+
+#include "pool.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+static const char *default_script =
+   "fn fib(n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }\n"
+   "let words = {};\n"
+   "for i in 0..200 { words[\"w${i / 8}\"] = i; }\n"
+   "let total = fib(15) + length(words);\n";
+
+static char *read_file(const char *path);
+static double now_seconds(void);
+
+int main(int ac, char *av[]) {
+   char *source   = ac > 1 ? read_file(av[1]) : NULL;
+   int32_t count  = ac > 2 ? atoi(av[2]) : 2000;
+   int32_t cores  = (int32_t)sysconf(_SC_NPROCESSORS_ONLN);
+   double base    = 0;
+
+   printf("cores: %d, scripts per run: %d\n", cores, count);
+
+   for (int32_t threads = 1; ; threads *= 2) {
+      if (threads > cores) threads = cores;
+
+      AntPool *pool = ant_pool.new(threads);
+      double start = now_seconds();
+
+      for (int32_t i = 0; i < count; i++) {
+         ant_pool.submit(pool, source != NULL ? source : default_script);
+      }
+
+      ant_pool.wait(pool);
+      double elapsed = now_seconds() - start;
+      PoolStats stats = ant_pool.stats(pool);
+      ant_pool.free(pool);
+
+      double rate = count / elapsed;
+      if (base == 0) base = rate;
+
+      printf("threads: %3d  %10.0f scripts/s  speedup: %5.2fx  ok: %lld  errors: %lld  cache misses: %lld\n",
+             threads, rate, rate / base, (long long)stats.ok,
+             (long long)(stats.compile_errors + stats.runtime_errors), (long long)stats.cache_misses);
+
+      if (threads == cores) break;
+   }
+
+   free(source);
+   return 0;
+}
+
+static double now_seconds(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static char *read_file(const char *path) {
+   FILE *file = fopen(path, "rb");
+
+   if (file == NULL) {
+      fprintf(stderr, "Error: Could not open file: %s\n", path);
+      exit(74);
+   }
+
+   fseek(file, 0L, SEEK_END);
+   size_t size = ftell(file);
+   rewind(file);
+
+   char *buffer = malloc(size + 1);
+   size_t read  = fread(buffer, 1, size, file);
+   buffer[read] = '\0';
+
+   fclose(file);
+   return buffer;
+}
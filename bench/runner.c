@@ -0,0 +1,290 @@
+/* Runs the workload scripts with the interpreter and reports their timings as JSON.
+ *
+ * usage: ant_bench_runner [--runs N] [--baseline file] [--threshold percent] [--output file] ant workload...
+ * Each workload runs once to warm the bytecode cache and the file system, then N times.
+ * The JSON on stdout, or in the output file, has the median and p95 wall time and the peak
+ * RSS of each workload, one workload per line, so saving it gives the baseline of a later run.
+ * With a baseline, workloads whose median time or peak RSS grew past the threshold are
+ * reported on stderr and the runner exits with 1.
+ *
+ * The baseline is read before the first workload runs, and the output file only replaced
+ * once every workload ran, so both can be the same file.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#define MAX_RUNS 1000
+#define NAME_MAX_LENGTH 64
+
+typedef struct {
+   char   name[NAME_MAX_LENGTH];
+   double median_ms;
+   double p95_ms;
+   long   peak_rss_kb;
+   int    failed_runs;
+}Result;
+
+static int    run_once(const char *ant, const char *path, double *elapsed_ms, long *rss_kb);
+static void   measure(const char *ant, const char *path, int runs, Result *result);
+static void   workload_name(const char *path, char *name);
+static Result *read_baseline(const char *path, int *count);
+static int    compare(Result *results, int count, Result *baseline, int baseline_count, double threshold);
+static double percent_change(double value, double base);
+static int    compare_doubles(const void *a, const void *b);
+static double now_ms(void);
+
+int main(int ac, char *av[]) {
+   int runs             = 10;
+   double threshold     = 10;
+   const char *baseline = NULL;
+   const char *output   = NULL;
+   int arg              = 1;
+
+   for (; arg < ac && strncmp(av[arg], "--", 2) == 0; arg += 2) {
+      if (arg + 1 >= ac) {
+         fprintf(stderr, "Error: %s expects a value\n", av[arg]);
+         return 2;
+      }
+
+      if (strcmp(av[arg], "--runs") == 0) {
+         runs = atoi(av[arg + 1]);
+      } else if (strcmp(av[arg], "--baseline") == 0) {
+         baseline = av[arg + 1];
+      } else if (strcmp(av[arg], "--threshold") == 0) {
+         threshold = atof(av[arg + 1]);
+      } else if (strcmp(av[arg], "--output") == 0) {
+         output = av[arg + 1];
+      } else {
+         fprintf(stderr, "Error: Unknown option %s\n", av[arg]);
+         return 2;
+      }
+   }
+
+   if (ac - arg < 2 || runs < 1 || runs > MAX_RUNS) {
+      fprintf(stderr, "Usage: ant_bench_runner [--runs 1..%d] [--baseline file] [--threshold percent] [--output file] ant workload...\n", MAX_RUNS);
+      return 2;
+   }
+
+   Result *base_results = NULL;
+   int base_count       = 0;
+
+   if (baseline != NULL && (base_results = read_baseline(baseline, &base_count)) == NULL) {
+      fprintf(stderr, "Error: Could not open baseline: %s\n", baseline);
+      return 2;
+   }
+
+   char temp_path[PATH_MAX];
+   FILE *out = stdout;
+
+   if (output != NULL) {
+      snprintf(temp_path, sizeof(temp_path), "%s.tmp", output);
+
+      if ((out = fopen(temp_path, "w")) == NULL) {
+         fprintf(stderr, "Error: Could not open output: %s\n", temp_path);
+         free(base_results);
+         return 2;
+      }
+   }
+
+   const char *ant = av[arg++];
+   int count       = ac - arg;
+   Result *results = calloc(count, sizeof(Result));
+
+   fprintf(out, "{\"runs\": %d, \"workloads\": [\n", runs);
+
+   for (int i = 0; i < count; i++) {
+      measure(ant, av[arg + i], runs, &results[i]);
+      fprintf(out, "  {\"name\": \"%s\", \"median_ms\": %.3f, \"p95_ms\": %.3f, \"peak_rss_kb\": %ld, \"failed_runs\": %d}%s\n",
+             results[i].name, results[i].median_ms, results[i].p95_ms, results[i].peak_rss_kb,
+             results[i].failed_runs, i + 1 < count ? "," : "");
+      fflush(out);
+   }
+
+   fprintf(out, "]}\n");
+
+   int status = 0;
+
+   if (output != NULL && (fclose(out) != 0 || rename(temp_path, output) != 0)) {
+      fprintf(stderr, "Error: Could not write output: %s\n", output);
+      status = 1;
+   }
+
+   for (int i = 0; i < count; i++) {
+      status |= results[i].failed_runs > 0;
+   }
+
+   if (base_results != NULL) {
+      status |= compare(results, count, base_results, base_count, threshold);
+   }
+
+   free(base_results);
+   free(results);
+   return status;
+}
+
+/* the peak RSS is the largest of all runs, the output of the script is dropped */
+
+static void measure(const char *ant, const char *path, int runs, Result *result) {
+   double times[MAX_RUNS];
+   double elapsed;
+   long rss;
+
+   workload_name(path, result->name);
+   result->failed_runs = run_once(ant, path, &elapsed, &rss) != 0;
+   result->peak_rss_kb = 0;
+
+   for (int i = 0; i < runs; i++) {
+      result->failed_runs += run_once(ant, path, &times[i], &rss) != 0;
+      result->peak_rss_kb  = rss > result->peak_rss_kb ? rss : result->peak_rss_kb;
+   }
+
+   qsort(times, runs, sizeof(double), compare_doubles);
+
+   int p95_index     = (95 * runs + 99) / 100 - 1;
+   result->median_ms = runs % 2 == 1 ? times[runs / 2] : (times[runs / 2 - 1] + times[runs / 2]) / 2;
+   result->p95_ms    = times[p95_index < 0 ? 0 : p95_index];
+}
+
+/* the exit status of the script, -1 when it could not run or was killed */
+
+static int run_once(const char *ant, const char *path, double *elapsed_ms, long *rss_kb) {
+   double start = now_ms();
+   pid_t pid    = fork();
+
+   *elapsed_ms = 0;
+   *rss_kb     = 0;
+
+   if (pid < 0) {
+      return -1;
+   }
+
+   if (pid == 0) {
+      int null = open("/dev/null", O_WRONLY);
+      dup2(null, STDOUT_FILENO);
+      execl(ant, ant, path, (char *)NULL);
+      _exit(127);
+   }
+
+   int status;
+   struct rusage usage;
+
+   if (wait4(pid, &status, 0, &usage) < 0) {
+      return -1;
+   }
+
+   *elapsed_ms = now_ms() - start;
+   *rss_kb     = usage.ru_maxrss;
+   return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+/* bench/workloads/recursion.ant -> recursion */
+
+static void workload_name(const char *path, char *name) {
+   const char *base = strrchr(path, '/');
+   base             = base == NULL ? path : base + 1;
+
+   size_t length = strcspn(base, ".");
+   length        = length < NAME_MAX_LENGTH - 1 ? length : NAME_MAX_LENGTH - 1;
+
+   memcpy(name, base, length);
+   name[length] = '\0';
+}
+
+/* reads back the lines printed by main, NULL when the file can't be opened */
+
+static Result *read_baseline(const char *path, int *count) {
+   FILE *file = fopen(path, "r");
+
+   if (file == NULL) {
+      return NULL;
+   }
+
+   char line[512];
+   int capacity    = 8;
+   Result *results = malloc(capacity * sizeof(Result));
+   *count          = 0;
+
+   while (fgets(line, sizeof(line), file) != NULL) {
+      Result base = {0};
+
+      if (sscanf(line, " {\"name\": \"%63[^\"]\", \"median_ms\": %lf, \"p95_ms\": %lf, \"peak_rss_kb\": %ld",
+                 base.name, &base.median_ms, &base.p95_ms, &base.peak_rss_kb) != 4) {
+         continue;
+      }
+
+      if (*count == capacity) {
+         capacity *= 2;
+         results   = realloc(results, capacity * sizeof(Result));
+      }
+
+      results[(*count)++] = base;
+   }
+
+   fclose(file);
+   return results;
+}
+
+/* workloads missing from the baseline are skipped */
+
+static int compare(Result *results, int count, Result *baseline, int baseline_count, double threshold) {
+   int regressions = 0;
+
+   fprintf(stderr, "%-16s %12s %12s %8s %12s %12s %8s\n",
+           "workload", "base ms", "ms", "change", "base rss kb", "rss kb", "change");
+
+   for (int b = 0; b < baseline_count; b++) {
+      Result base = baseline[b];
+
+      for (int i = 0; i < count; i++) {
+         if (strcmp(results[i].name, base.name) != 0) {
+            continue;
+         }
+
+         double time_change = percent_change(results[i].median_ms, base.median_ms);
+         double rss_change  = percent_change((double)results[i].peak_rss_kb, (double)base.peak_rss_kb);
+         bool regressed     = time_change > threshold || rss_change > threshold;
+
+         fprintf(stderr, "%-16s %12.3f %12.3f %+7.1f%% %12ld %12ld %+7.1f%% %s\n",
+                 base.name, base.median_ms, results[i].median_ms, time_change,
+                 base.peak_rss_kb, results[i].peak_rss_kb, rss_change, regressed ? "REGRESSION" : "");
+         regressions += regressed;
+      }
+   }
+
+   if (regressions > 0) {
+      fprintf(stderr, "%d workloads regressed by more than %.1f%%\n", regressions, threshold);
+   }
+
+   return regressions > 0;
+}
+
+/* 0 when the base is 0, a failed or empty baseline entry can't be compared against */
+
+static double percent_change(double value, double base) {
+   return base > 0 ? (value / base - 1) * 100 : 0;
+}
+
+/* */
+
+static int compare_doubles(const void *a, const void *b) {
+   double x = *(const double *)a;
+   double y = *(const double *)b;
+   return (x > y) - (x < y);
+}
+
+/* */
+
+static double now_ms(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
@@ -0,0 +1,37 @@
+#ifndef ANT_ALLOC_SITES_H
+#define ANT_ALLOC_SITES_H
+
+#include "common.h"
+#include "object.h"
+#include "vm.h"
+
+#include <stdio.h>
+
+/* Objects allocated per Ant line, for ant --alloc-sites path and allocation_sites(limit).
+ *
+ * While started, allocate_object counts each object and its size against the function and line
+ * of the running frame of the VM and the type of the object, strings add their chars. Storage
+ * grown later, the items of lists or the entries of maps, is not counted. Allocations with no
+ * frame are the compiler's. Only the context of the started VM records, not isolates or workers.
+ *
+ * run() syncs frame->ip after each instruction, so during an instruction it points at it, and
+ * during a native at the instruction after the call, which is nearly always on the same line.
+ */
+
+typedef struct AllocationSites AllocationSites;
+
+typedef struct {
+   void   (*start)(VM *vm);
+   void   (*stop)(VM *vm);
+
+   /* from the allocation paths, on the sites of the current context */
+   void   (*record)(AllocationSites *sites, ObjectType type, size_t bytes, int32_t objects);
+
+   /* sites by bytes, at most limit. report is a list of maps, nil when not started */
+   void   (*print)(VM *vm, FILE *file, int32_t limit);
+   Value  (*report)(VM *vm, int32_t limit);
+}AllocSitesAPI;
+
+extern const AllocSitesAPI ant_alloc_sites;
+
+#endif // ANT_ALLOC_SITES_H
@@ -0,0 +1,35 @@
+#ifndef ANT_BYTECODE_CACHE_H
+#define ANT_BYTECODE_CACHE_H
+
+#include "common.h"
+#include "vm.h"
+
+/* Compiled scripts saved next to their source, `script.ant` -> `script.antc`.
+ *
+ * The file holds the global names and the whole function tree: code, line tables and
+ * constants, nested functions inline. Upvalue descriptors are part of the code after OP_CLOSURE.
+ * Loading maps the file and the chunks point at their code and lines in place,
+ * only strings and functions are allocated.
+ *
+ * A cache is ignored when its format version, opcode count, source hash or global names
+ * do not match, the caller compiles and saves a new one.
+ */
+
+#define BYTECODE_CACHE_SUFFIX "c"
+
+typedef struct BytecodeFile BytecodeFile;
+
+typedef struct {
+   /* NULL on a missing or stale cache. On success *file must outlive every function loaded from it */
+   ObjectFunction*   (*load)(VM *vm, const char *path, const char *source, BytecodeFile **file);
+
+   /* writes to a temporary file and renames it over path, returns false on any IO error */
+   bool              (*save)(VM *vm, const char *path, ObjectFunction *script, const char *source);
+
+   /* unmaps the file, call after the VM that loaded from it was freed */
+   void              (*close)(BytecodeFile *file);
+}BytecodeCacheAPI;
+
+extern const BytecodeCacheAPI ant_bytecode_cache;
+
+#endif // ANT_BYTECODE_CACHE_H
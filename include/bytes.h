@@ -0,0 +1,60 @@
+#ifndef ANT_BYTES_H
+#define ANT_BYTES_H
+
+#include "common.h"
+
+/* Helpers for the binary files the interpreter writes and maps back: bytecode caches and heap images,
+ * and the mapping of source files.
+ *
+ * Fields are native endian uint32 and byte runs are padded to 4 bytes, so arrays of int32
+ * inside a mapped file can be used in place. A writer or reader that failed stays failed,
+ * callers check ok once at the end.
+ */
+
+typedef struct {
+   uint8_t *bytes;
+   int32_t count;
+   int32_t capacity;
+   bool ok;
+}ByteWriter;
+
+typedef struct {
+   const uint8_t *at;
+   const uint8_t *end;
+   bool ok;
+}ByteReader;
+
+typedef struct {
+   void *data;
+   size_t size;
+}MappedFile;
+
+typedef struct {
+   void            (*init_writer)(ByteWriter *writer);
+   void            (*free_writer)(ByteWriter *writer);
+   void            (*write)(ByteWriter *writer, const void *bytes, int32_t length);
+   void            (*write_u32)(ByteWriter *writer, uint32_t value);
+   void            (*write_padded)(ByteWriter *writer, const void *bytes, int32_t length);
+
+   /* writes to a temporary file and renames it over path, readers never see a partial file */
+   bool            (*save)(ByteWriter *writer, const char *path);
+
+   void            (*init_reader)(ByteReader *reader, const MappedFile *file);
+
+   /* return NULL and fail the reader past the end of the data */
+   const uint8_t*  (*read)(ByteReader *reader, int32_t length);
+   const uint8_t*  (*read_padded)(ByteReader *reader, int32_t length);
+   uint32_t        (*read_u32)(ByteReader *reader);
+
+   /* read-only private mapping, false if the file is missing or shorter than min_size */
+   bool            (*map)(const char *path, size_t min_size, MappedFile *file);
+
+   /* read-only mapping of a source file for the scanner to run on in place, followed by at
+    * least one '\0'. Empty files map to an empty string, size is the length mapped */
+   bool            (*map_source)(const char *path, MappedFile *file);
+   void            (*unmap)(MappedFile *file);
+}BytesAPI;
+
+extern const BytesAPI ant_bytes;
+
+#endif // ANT_BYTES_H
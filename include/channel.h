@@ -0,0 +1,55 @@
+#ifndef ANT_CHANNEL_H
+#define ANT_CHANNEL_H
+
+#include "object.h"
+
+/* Bounded queues carrying values between isolates, see isolate.h.
+ *
+ * The channel lives outside every heap and is counted, each isolate holding it has an
+ * ObjectChannel with one reference. Values are turned into messages that belong to no heap:
+ *
+ *   - strings are shared, the receiver points at the same chars, see ant_string.share
+ *   - f64arrays are moved, the sender's array is left empty and the receiver gets its buffer
+ *   - channels are shared, nil, booleans and numbers are copied
+ *   - lists and maps are copied, their items travel by the rules above
+ *
+ * Functions and fibers can't be sent. send blocks while the channel is full and receive
+ * while it is empty, the whole isolate thread waits, fibers included.
+ */
+
+typedef struct Channel Channel;
+
+struct ObjectChannel {
+   Object    object;
+   Channel*  channel;
+};
+
+struct VM;
+
+typedef struct {
+   /* the caller holds the one reference */
+   Channel*        (*new)(int32_t capacity);
+   void            (*retain)(Channel *channel);
+   void            (*release)(Channel *channel);
+
+   /* takes over a reference, the object releases it when freed */
+   ObjectChannel*  (*wrap)(Channel *channel);
+   ObjectChannel*  (*from_value)(Value value);
+   Object*         (*as_object)(ObjectChannel *object);
+
+   /* true once queued, false if the channel is closed, undefined after a runtime error */
+   Value           (*send)(struct VM *vm, Channel *channel, Value value);
+
+   /* the oldest message, nil once the channel is closed and empty */
+   Value           (*receive)(struct VM *vm, Channel *channel);
+
+   /* wakes everyone waiting, messages already queued can still be received */
+   void            (*close)(Channel *channel);
+   int32_t         (*print)(ObjectChannel *object);
+}ChannelAPI;
+
+const extern ChannelAPI ant_channel;
+
+#define CHANNEL_AS_OBJECT(object) ((Object*)(object))
+#define CHANNEL_FROM_VALUE(value) ((ObjectChannel*)VALUE_AS_OBJECT(value))
+#endif // ANT_CHANNEL_H
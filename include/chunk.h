@@ -21,14 +21,26 @@ typedef enum {
   OP_LESS,               /* no operand */
   OP_PRINT,              /* no operand */
   OP_POP,                /* no operand */
+  OP_BUILD_STRING,       /* 8-bit operand: number of parts on the stack */
+
+  OP_LIST,               /* no operand */
+  OP_LIST_APPEND,        /* no operand */
+  OP_MAP,                /* no operand */
+  OP_MAP_INSERT,         /* no operand */
+  OP_INDEX_GET,          /* no operand */
+  OP_INDEX_SET,          /* no operand */
 
   OP_CLOSURE,            /*  8-bit operand  + a pair of bytes per upvalue in func->upvalue_count */
   OP_CLOSURE_LONG,       /*  24-bit operand + a pair of bytes per upvalue in func->upvalue_count */
 
   OP_CALL,               /* 8-bit operand  */
+  OP_IMPORT,             /* no operand, the path on the stack. Skips the OP_IMPORT_END after it once loaded */
+  OP_IMPORT_END,         /* no operand */
   OP_JUMP,               /* 16-bit operand */
   OP_JUMP_IF_FALSE,      /* 16-bit operand */
   OP_LOOP,               /* 16-bit operand */
+  OP_FOR_RANGE,          /* 8-bit local slot + 16-bit operand */
+  OP_FOR_STEP,           /* 8-bit local slot + 16-bit operand */
 
   OP_SET_UPVALUE,        /*  8-bit operand */
   OP_GET_UPVALUE,        /*  8-bit operand */
@@ -54,13 +66,13 @@ typedef enum {
  * @brief Represents a chunk of bytecode in antlang interpreter.
  *
  * Contains bytecode instructions, constants used in the bytecode, 
- * and line number information for error reporting.
+ * and line and column information for error reporting.
  */
 typedef struct {
-    int32_t    capacity;                  /**< The total allocated capacity for the bytecode and associated data. */
+    int32_t    capacity;                  /**< The total allocated capacity for the bytecode and associated data. 0 with code set when borrowed from a bytecode cache. */
     int32_t    count;                     /**< The current number of bytecode instructions in the chunk. */
     ValueArray constants;                 /**< An array of constants used in the bytecode. */
-    Lines      lines;                     /**< Mapping of each bytecode instruction to its line number in the source code. */
+    Lines      lines;                     /**< Mapping of each bytecode instruction to its line and column in the source code. */
     uint8_t*   code;                      /**< The array of bytecode instructions. */
 } Chunk;
 
@@ -77,9 +89,10 @@ typedef struct AntChunk {
    * @param byte byte to write
    * @param chunk chunk to write to
    * @param line line number of the byte
+   * @param column column of the token the byte was compiled from
    * @details This function will automatically resize the internal array of instructions if the capacity is exceeded.
    */
-  void (*write)(Chunk *chunk, uint8_t byte, int32_t line);
+  void (*write)(Chunk *chunk, uint8_t byte, int32_t line, int32_t column);
   bool (*patch_16bits)(Chunk *chunk, int32_t offset, int32_t value);
 
   /**
@@ -95,17 +108,18 @@ typedef struct AntChunk {
    * @param chunk the chunk to write to
    * @param value the constant value to write
    * @param line the line number of the constant
+   * @param column the column of the constant
    * @returns the index of the constant in the chunk's constant array. If < 0, an error occurred.
    */
-  bool (*write_constant)      (Chunk *chunk, Value value, int32_t line);
-  bool (*write_closure)       (Chunk *chunk, Value value, int32_t line);
-  bool (*write_define_global) (Chunk *chunk, int32_t global_index, int32_t line);
-  bool (*write_get_global)    (Chunk *chunk, int32_t global_index, int32_t line);
-  bool (*write_set_global)    (Chunk *chunk, int32_t global_index, int32_t line);
-  bool (*write_get_local)     (Chunk *chunk, int32_t local_index, int32_t line);
-  bool (*write_set_local)     (Chunk *chunk, int32_t local_index, int32_t line);
-  bool (*write_get_upvalue)   (Chunk *chunk, int32_t upvalue_index, int32_t line);
-  bool (*write_set_upvalue)   (Chunk *chunk, int32_t upvalue_index, int32_t line);
+  bool (*write_constant)      (Chunk *chunk, Value value, int32_t line, int32_t column);
+  bool (*write_closure)       (Chunk *chunk, Value value, int32_t line, int32_t column);
+  bool (*write_define_global) (Chunk *chunk, int32_t global_index, int32_t line, int32_t column);
+  bool (*write_get_global)    (Chunk *chunk, int32_t global_index, int32_t line, int32_t column);
+  bool (*write_set_global)    (Chunk *chunk, int32_t global_index, int32_t line, int32_t column);
+  bool (*write_get_local)     (Chunk *chunk, int32_t local_index, int32_t line, int32_t column);
+  bool (*write_set_local)     (Chunk *chunk, int32_t local_index, int32_t line, int32_t column);
+  bool (*write_get_upvalue)   (Chunk *chunk, int32_t upvalue_index, int32_t line, int32_t column);
+  bool (*write_set_upvalue)   (Chunk *chunk, int32_t upvalue_index, int32_t line, int32_t column);
 } AntChunkAPI;
 
 extern AntChunkAPI ant_chunk;
@@ -4,6 +4,7 @@
 #include "parser.h"
 #include "locals.h"
 #include "compilation_upvalues.h"
+#include "value_array.h"
 
 typedef enum {
   PREC_NONE       = 0,  /* Lowest precedence */
@@ -34,10 +35,16 @@ typedef struct Compiler {
   ObjectFunction *func;
   CompilationType type;
   struct Compiler *enclosing;
+  const char *module;        /* path the global names of a module go under, NULL for scripts */
+  int32_t builtin_count;     /* globals a module sees by their own name, the natives */
+  ValueArray exports;        /* global indices the module defines, it returns them as a map */
 } Compiler;
 
 typedef struct AntCompiler {
   void            (*init)(Compiler *compiler, CompilationType type);
+
+  /* a script with globals of its own, see module.h */
+  void            (*init_module)(Compiler *compiler, const char *path, int32_t builtin_count);
   ObjectFunction* (*compile)(Compiler *compiler, const char *source);
 } AntCompilerAPI;
 
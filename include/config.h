@@ -9,6 +9,10 @@
 // #define DEBUG_TRACE_PARSER
 // Requires DEBUG_TRACE_PARSER will trace tokens
 // #define DEBUG_TRACE_PARSER_VERBOSE 
+// Counts opcodes and opcode pairs for ant --stats, see stats.h
+// #define DEBUG_OPCODE_STATS
+// Records calls for ant --trace, see trace.h
+// #define DEBUG_TRACE_EVENTS
 
 /* Constants */
 #define CONST_24BITS 3
@@ -30,6 +34,18 @@
 #define OPTION_TABLE_LOAD_FACTOR 0.79 // Load factor for hash table
 #define OPTION_MAX_NUM_PARAMS 255
 #define OPTION_DISASSEMBLE_COLUMN_WITDH 50
+#define OPTION_INTERPOLATION_MAX_DEPTH 8
+#define OPTION_INTERPOLATION_MAX_PARTS 255
+#define OPTION_POOL_MAX_THREADS 256
+#define OPTION_POOL_CACHE_BUCKETS 64
+#define OPTION_EVENT_LOOP_BATCH 64
+#define OPTION_READ_CHUNK 65536
+#define OPTION_MESSAGE_DEPTH_MAX 64
+#define OPTION_PRINT_DEPTH_MAX 64 // lists and maps nested deeper print as [...] and {...}
+#define OPTION_PARALLEL_CHUNKS_PER_THREAD 8
+#define OPTION_PROFILE_INTERVAL_US 1000 // CPU time between samples of ant --profile
+#define OPTION_PROFILE_DEPTH_MAX 256
+#define OPTION_TRACE_EVENTS 262144 // ring of ant --trace, a power of 2
 
 
 #endif // ANT_CONFIG_H
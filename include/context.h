@@ -0,0 +1,46 @@
+#ifndef ANT_CONTEXT_H
+#define ANT_CONTEXT_H
+
+#include "common.h"
+#include "table.h"
+#include "var_mapping.h"
+#include "memory.h"
+
+/* The interpreter state reached from allocation paths rather than through the VM:
+ * the interned strings, the globals mapping and the heap.
+ *
+ * Each VM owns a context and makes it current on the thread running it.
+ * Allocations, interning and the mapping go through the current context,
+ * so one VM per thread can run in the same process.
+ */
+
+typedef struct AntContext {
+   Table               strings;
+   VarMapping          mapping;
+   GarbageCollection   garbage;
+
+   /* NULL unless allocations are counted per line, see alloc_sites.h */
+   struct AllocationSites*  sites;
+
+   /* read-only strings of a shared compiled program, interning looks there first */
+   struct AntContext*  parent;
+}AntContext;
+
+typedef struct {
+   AntContext*  (*new)(void);
+   void         (*free)(AntContext *context);
+   void         (*make_current)(AntContext *context);
+
+   /* release frees every object allocated after mark was taken */
+   Object*      (*mark)(AntContext *context);
+   void         (*release)(AntContext *context, Object *mark);
+}ContextAPI;
+
+extern const ContextAPI ant_context;
+
+/* read directly rather than through the API as allocation and interning are hot paths */
+extern _Thread_local AntContext *ant_current_context;
+
+#define CURRENT_CONTEXT() (ant_current_context)
+
+#endif // ANT_CONTEXT_H
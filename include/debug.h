@@ -17,6 +17,9 @@ typedef struct AntDebug {
   int (*disassemble_instruction)(Compiler *compiler, Chunk *frame_chunk, int32_t offset);
   void (*trace_parsing)(const char *func_name, int32_t depth, const char *format, ...);
   void (*trace_tokens)(Token prev, Token current, int32_t depth);
+
+  /* "OP_ADD" for OP_ADD, "OP_UNKNOWN" past the last opcode */
+  const char *(*opcode_name)(uint8_t instruction);
 } DebugAPI;
 
 extern DebugAPI ant_debug;
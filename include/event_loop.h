@@ -0,0 +1,47 @@
+#ifndef ANT_EVENT_LOOP_H
+#define ANT_EVENT_LOOP_H
+
+#include "common.h"
+#include "vm.h"
+
+/* Event loop of a VM, on epoll and non-blocking fds.
+ *
+ * A native that would block parks the running fiber in the loop and switches back to its caller.
+ * When the fd is ready or the timer expires the loop finishes the operation and resumes the fiber
+ * with the result, through ant_vm.run_fiber. The root cannot be parked, a wait on the root runs
+ * the loop, and with it the other fibers, until its own operation is done.
+ *
+ * Operations are tried once before waiting, so a ready fd costs no switch. They evaluate to nil
+ * when they fail. Regular files cannot be polled with epoll, they are read in chunks with a turn
+ * of the loop between chunks.
+ *
+ * Scripts end by running the loop until nothing waits on it, see execute in vm.c.
+ */
+
+typedef struct EventLoop EventLoop;
+
+typedef struct {
+   /* each returns undefined after a runtime error and nil when it parked the fiber,
+    * the result then comes with the resume */
+   Value  (*sleep)(VM *vm, double ms);
+   Value  (*read_file)(VM *vm, ObjectString *path);
+   Value  (*connect)(VM *vm, int32_t port);
+   Value  (*read)(VM *vm, int32_t fd);
+   Value  (*write)(VM *vm, int32_t fd, ObjectString *data);
+
+   /* starts the closure as a new fiber after ms */
+   Value  (*spawn)(VM *vm, ObjectClosure *closure, double ms);
+
+   /* the fiber waiting on fd, if any, gets nil */
+   void   (*close)(VM *vm, int32_t fd);
+
+   /* runs until nothing waits, false after a runtime error */
+   bool   (*drain)(VM *vm);
+
+   /* drops every wait, the fibers are not resumed */
+   void   (*free)(VM *vm);
+}EventLoopAPI;
+
+extern const EventLoopAPI ant_event_loop;
+
+#endif // ANT_EVENT_LOOP_H
@@ -0,0 +1,28 @@
+#ifndef ANT_F64_ARRAY_H
+#define ANT_F64_ARRAY_H
+
+#include "object.h"
+
+/* Fixed length array of unboxed doubles. 
+ * Values are stored contiguously so the numeric natives can run vectorized kernels over them,
+ * and the VM boxes / unboxes directly on OP_INDEX_GET / OP_INDEX_SET.
+ */
+
+struct ObjectF64Array {
+   Object  object;
+   int32_t length;
+   double* values;
+};
+
+typedef struct {
+   ObjectF64Array*  (*new)(int32_t length);
+   ObjectF64Array*  (*from_value)(Value value);
+   Object*          (*as_object)(ObjectF64Array *array);
+   int32_t          (*print)(ObjectF64Array *array);
+}F64ArrayAPI;
+
+const extern F64ArrayAPI ant_f64_array;
+
+#define F64_ARRAY_AS_OBJECT(array) ((Object*)(array))
+#define F64_ARRAY_FROM_VALUE(value) ((ObjectF64Array*)VALUE_AS_OBJECT(value))
+#endif // ANT_F64_ARRAY_H
@@ -0,0 +1,38 @@
+#ifndef ANT_F64_KERNELS_H
+#define ANT_F64_KERNELS_H
+
+#include "common.h"
+
+/* Numeric kernels over contiguous doubles used by the f64array natives.
+ *
+ * The API starts with the portable scalar kernels. detect() swaps in the SSE2 or AVX2
+ * versions when the cpu supports them, so it must run once before any VM executes.
+ *
+ * NOTE: vectorized reductions (sum, dot) add in a different order than the scalar loop,
+ *       results may differ in the last bits.
+ */
+
+typedef struct {
+   void    (*detect)(void);
+   const char* (*name)(void);
+
+   double  (*sum)(const double *x, int32_t n);
+   double  (*dot)(const double *x, const double *y, int32_t n);
+   double  (*min)(const double *x, int32_t n);
+   double  (*max)(const double *x, int32_t n);
+
+   /* x = k * x */
+   void    (*scale)(double *x, double k, int32_t n);
+   /* y = a * x + y */
+   void    (*axpy)(double a, const double *x, double *y, int32_t n);
+
+   /* out = a <op> b */
+   void    (*add)(const double *a, const double *b, double *out, int32_t n);
+   void    (*sub)(const double *a, const double *b, double *out, int32_t n);
+   void    (*mul)(const double *a, const double *b, double *out, int32_t n);
+   void    (*div)(const double *a, const double *b, double *out, int32_t n);
+}F64KernelAPI;
+
+extern F64KernelAPI ant_f64_kernels;
+
+#endif // ANT_F64_KERNELS_H
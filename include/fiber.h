@@ -0,0 +1,77 @@
+#ifndef ANT_FIBER_H
+#define ANT_FIBER_H
+
+#include "object.h"
+#include "closure.h"
+#include "stack.h"
+#include "upvalues.h"
+
+/* Fibers are coroutines. Each fiber owns its value stack and call frames and the VM runs one
+ * at a time. Switching saves the frame count and open upvalues of the running fiber and points
+ * the VM at the stack and frames of the other one, no threads involved.
+ *
+ * resume(fiber, value) runs the fiber until it yields or returns and evaluates to that value.
+ * Inside the fiber, yield(value) suspends it and evaluates to the value of the next resume.
+ * The first resume passes its value to the fiber function when it takes a parameter.
+ *
+ * resume and yield are natives, so the fiber switched away from ends with the native call
+ * result on top of its stack. That slot is overwritten with the value it gets back.
+ */
+
+typedef struct {
+   ObjectClosure*  closure;  /* All functions are closures */
+   Value*          slots;    /* first slot of the call frame */
+   uint8_t*        ip;       /* return address */
+}CallFrame;
+
+typedef enum {
+   FIBER_NEW,
+   FIBER_SUSPENDED,
+   FIBER_RUNNING,   /* running or waiting on a fiber it resumed */
+   FIBER_WAITING,   /* parked in the event loop, only the loop resumes it */
+   FIBER_DONE,
+}FiberState;
+
+struct ObjectFiber {
+   Object               object;
+   ObjectClosure*       closure;        /* NULL for the root fiber running scripts */
+   Stack                stack;
+   CallFrame*           frames;
+   int32_t              frame_max;
+   int32_t              frame_count;    /* saved when switching away */
+   UpvalueList          open_upvalues;  /* saved when switching away */
+   struct ObjectFiber*  caller;         /* resumed this fiber, NULL when not running */
+   FiberState           state;
+};
+
+struct VM;
+
+typedef struct {
+   /* NULL closure makes the root fiber of a VM, with the full stack size */
+   ObjectFiber*  (*new)(ObjectClosure *closure);
+   ObjectFiber*  (*from_value)(Value value);
+   Object*       (*as_object)(ObjectFiber *fiber);
+
+   /* false after reporting a runtime error */
+   bool          (*resume)(struct VM *vm, ObjectFiber *fiber, Value value);
+   bool          (*yield)(struct VM *vm, Value value);
+
+   /* yield with nil, parking the fiber until the event loop resumes it. Not on the root */
+   void          (*wait)(struct VM *vm);
+
+   /* the running fiber returned from its function, back to the caller with the result */
+   void          (*finish)(struct VM *vm, Value result);
+
+   /* after a runtime error, drops every running fiber and switches back to the root */
+   void          (*unwind)(struct VM *vm);
+
+   /* releases the stack and frames, the object stays valid as a finished fiber */
+   void          (*release)(ObjectFiber *fiber);
+   int32_t       (*print)(ObjectFiber *fiber);
+}FiberAPI;
+
+const extern FiberAPI ant_fiber;
+
+#define FIBER_AS_OBJECT(fiber) ((Object*)(fiber))
+#define FIBER_FROM_VALUE(value) ((ObjectFiber*)VALUE_AS_OBJECT(value))
+#endif // ANT_FIBER_H
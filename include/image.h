@@ -0,0 +1,33 @@
+#ifndef ANT_IMAGE_H
+#define ANT_IMAGE_H
+
+#include "common.h"
+#include "vm.h"
+
+/* Heap images: the state of a VM after a script ran, restored into a new VM
+ * without running the script again.
+ *
+ * The image holds every object of the VM heap, the globals and the mapping of their names.
+ * Objects are numbered by type and references are written as numbers. Restoring maps the file,
+ * allocates the objects and relocates the references through the number to pointer table.
+ * Code and line tables are used in place from the mapped file, like the bytecode cache.
+ *
+ * Natives are not written, references to them are by position in the natives table and
+ * resolve to the natives of the VM restoring the image.
+ */
+
+typedef struct HeapImage HeapImage;
+
+typedef struct {
+   /* the VM must be idle, between runs. False if it is not or on IO errors */
+   bool        (*snapshot)(VM *vm, const char *path);
+
+   /* the VM must be new. NULL on a missing or incompatible image, nothing is restored then.
+    * The image must outlive the VM */
+   HeapImage*  (*restore)(VM *vm, const char *path);
+   void        (*close)(HeapImage *image);
+}HeapImageAPI;
+
+extern const HeapImageAPI ant_image;
+
+#endif // ANT_IMAGE_H
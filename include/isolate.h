@@ -0,0 +1,35 @@
+#ifndef ANT_ISOLATE_H
+#define ANT_ISOLATE_H
+
+#include "common.h"
+#include "channel.h"
+#include "vm.h"
+
+/* Isolates run scripts in parallel, each on a thread of its own with a VM of its own.
+ *
+ * Nothing is shared between their heaps, they only talk through channels, see channel.h.
+ * isolate(path, channel) starts the script at path and isolate_channel() returns the channel
+ * inside it, nil in the script that was not started as an isolate.
+ *
+ * A script ends by waiting for the isolates it started, see execute in vm.c. An isolate left
+ * waiting on a channel nobody sends to or closes keeps its parent waiting as well.
+ */
+
+typedef struct Isolate Isolate;
+
+typedef struct {
+   /* the source is copied, the isolate holds a reference to the channel, which can be NULL.
+    * NULL if the thread can't start */
+   Isolate*  (*start)(const char *source, Channel *channel);
+
+   /* waits for the script to end and frees the isolate, false after compile or runtime errors */
+   bool      (*join)(Isolate *isolate);
+
+   /* starts the script at path as an isolate the VM joins, false after a runtime error */
+   bool      (*spawn)(VM *vm, ObjectString *path, Channel *channel);
+   void      (*join_all)(VM *vm);
+}IsolateAPI;
+
+extern const IsolateAPI ant_isolate;
+
+#endif // ANT_ISOLATE_H
@@ -4,25 +4,38 @@
 #include "common.h"
 
 /**
- * @brief Represents a mapping between a range of bytecode instructions and a line number in the source code.
+ * @brief Runs of bytecode between two checkpoints of the line table.
+ *
+ * Lookups binary search the checkpoints, then decode at most this many runs.
+ */
+#define LINE_CHECKPOINT_RUNS 16
+
+/**
+ * @brief A decoded run of the line table, kept every LINE_CHECKPOINT_RUNS runs.
  */
 typedef struct {
-    int32_t start;  /**< The starting index in the bytecode array where this line range begins. */
-    int32_t end;    /**< The ending index in the bytecode array where this line range ends. */
-    int32_t number; /**< The line number in the source code corresponding to this range of bytecode. */
-} Line;
+    int32_t start;    /**< The index in the bytecode array where the run begins. */
+    int32_t number;   /**< The line number of the run. */
+    int32_t column;   /**< The column of the run. */
+    int32_t next;     /**< The offset in the encoded runs of the run after this one. */
+} LineCheckpoint;
 
 /**
- * @brief Represents a collection of line mappings for a chunk of bytecode.
+ * @brief Maps the bytecode of a chunk back to lines and columns of the source code.
  *
- * This structure holds an array of `Line` structures, each representing a range of bytecode
- * instructions and their corresponding line number in the source code. It's used to associate
- * each instruction in a chunk of bytecode with a specific line in the source code.
+ * Consecutive bytes compiled from the same token share a run. Each run is encoded as three
+ * varints: how many bytes after the previous run it starts, its line as a signed difference
+ * with the line of the previous run, and its column. Most runs take three bytes.
  */
 typedef struct {
-    int32_t capacity; /**< The total allocated capacity for the lines array. */
-    int32_t count;    /**< The current number of line mappings in the lines array. */
-    Line *lines;      /**< The array of `Line` structures representing line mappings. */
+    int32_t capacity;                /**< The total allocated capacity for the encoded runs. 0 with runs set when borrowed from a bytecode cache. */
+    int32_t count;                   /**< The number of bytes of encoded runs. */
+    uint8_t *runs;                   /**< The encoded runs. */
+    int32_t checkpoint_capacity;     /**< The total allocated capacity for the checkpoints, 0 when borrowed. */
+    int32_t checkpoint_count;        /**< The number of checkpoints. */
+    LineCheckpoint *checkpoints;     /**< The first run and every LINE_CHECKPOINT_RUNS runs after it, by start. */
+    int32_t run_count;               /**< The number of runs written, only while writing. */
+    LineCheckpoint last;             /**< The last run written, only while writing. */
 } Lines;
 
 
@@ -36,21 +49,30 @@ typedef struct AntLine {
     */
    void (*init)(Lines *lines);
    /**
-    * @brief Writes a line number association for a given chunk index, dynamically growing the array if needed.
+    * @brief Writes a line and column association for a given chunk index, dynamically growing the runs if needed.
     * @param lines Pointer to the Lines structure.
     * @param line Line number in the source code.
-    * @param chunk_index Index in the bytecode array.
-    * @details This function will automatically resize the internal array of lines if the capacity is exceeded.
+    * @param column Column in the source code.
+    * @param chunk_index Index in the bytecode array, one past the previous one written.
     */
-   void (*write)(Lines *lines, int32_t line, int32_t chunk_index);
+   void (*write)(Lines *lines, int32_t line, int32_t column, int32_t chunk_index);
 
    /**
     * @brief Retrieves the source code line number for a bytecode index.
     * @param lines Pointer to the Lines structure.
     * @param chunk_index Index in the bytecode array.
     * @return Line number in the source code.
+    * @details O(log n) in the number of runs.
+    */
+   int32_t (*get)(const Lines *lines, int32_t chunk_index);
+
+   /**
+    * @brief Retrieves the source code column for a bytecode index.
+    * @param lines Pointer to the Lines structure.
+    * @param chunk_index Index in the bytecode array.
+    * @return Column in the source code, 0 when unknown.
     */
-   int32_t (*get)(Lines *lines, int32_t chunk_index);
+   int32_t (*column)(const Lines *lines, int32_t chunk_index);
 
    /**
     * @brief Frees resources in a Lines structure.
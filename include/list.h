@@ -0,0 +1,29 @@
+#ifndef ANT_LIST_H
+#define ANT_LIST_H
+
+#include "object.h"
+#include "value_array.h"
+
+/* Lists are contiguous, growable arrays of values. 
+ * Indexing is done directly by the VM (OP_INDEX_GET / OP_INDEX_SET) for speed.
+ */
+
+struct ObjectList {
+   Object object;
+   ValueArray items;
+};
+
+typedef struct {
+   ObjectList*  (*new)(void);
+   ObjectList*  (*from_value)(Value value);
+   Object*      (*as_object)(ObjectList *list);
+   void         (*append)(ObjectList *list, Value value);
+   bool         (*pop)(ObjectList *list, Value *value);
+   int32_t      (*print)(ObjectList *list, bool debug);
+}ListAPI;
+
+const extern ListAPI ant_list;
+
+#define LIST_AS_OBJECT(list) ((Object*)(list))
+#define LIST_FROM_VALUE(value) ((ObjectList*)VALUE_AS_OBJECT(value))
+#endif // ANT_LIST_H
@@ -0,0 +1,33 @@
+#ifndef ANT_MAP_H
+#define ANT_MAP_H
+
+#include "object.h"
+#include "table.h"
+
+/* Maps are hash tables from any hashable value to a value.
+ * They reuse the same Table as string interning and the globals mapping.
+ * Indexing is done directly by the VM (OP_INDEX_GET / OP_INDEX_SET), missing keys read as nil.
+ */
+
+struct ObjectMap {
+   Object object;
+   Table table;
+   int32_t count; /* live keys, the table count includes tombstones */
+};
+
+typedef struct {
+   ObjectMap*   (*new)(void);
+   ObjectMap*   (*from_value)(Value value);
+   Object*      (*as_object)(ObjectMap *map);
+   void         (*set)(ObjectMap *map, Value key, Value value);
+   bool         (*get)(ObjectMap *map, Value key, Value *value);
+   bool         (*delete)(ObjectMap *map, Value key);
+   bool         (*next)(ObjectMap *map, int32_t *cursor, Value *key, Value *value);
+   int32_t      (*print)(ObjectMap *map, bool debug);
+}MapAPI;
+
+const extern MapAPI ant_map;
+
+#define MAP_AS_OBJECT(map) ((Object*)(map))
+#define MAP_FROM_VALUE(value) ((ObjectMap*)VALUE_AS_OBJECT(value))
+#endif // ANT_MAP_H
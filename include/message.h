@@ -0,0 +1,60 @@
+#ifndef ANT_MESSAGE_H
+#define ANT_MESSAGE_H
+
+#include "strings.h"
+#include "channel.h"
+
+/* Values on their way from one heap to another, used by channels between isolates and by the
+ * parallel natives between worker VMs and the VM waiting on them.
+ *
+ * A message belongs to no heap. It is encoded on the thread of the heap the value comes from
+ * and decoded on the thread of the heap it goes to, see channel.h for what each type becomes.
+ */
+
+typedef enum {
+   MESSAGE_NIL,
+   MESSAGE_BOOL,
+   MESSAGE_NUMBER,
+   MESSAGE_STRING,
+   MESSAGE_F64ARRAY,
+   MESSAGE_LIST,
+   MESSAGE_MAP,
+   MESSAGE_CHANNEL,
+}MessageType;
+
+/* what encoding does to f64arrays */
+typedef enum {
+   MESSAGE_MOVE,   /* the buffer goes with the message, the array is left empty */
+   MESSAGE_COPY,   /* for arrays the encoding thread does not own, they are only read */
+}MessageMode;
+
+typedef struct Message {
+   MessageType  type;
+   int32_t      count;   /* f64array length, list items or map entries */
+   union {
+      bool             boolean;
+      double           number;
+      SharedChars*     string;
+      double*          values;
+      struct Message*  items;   /* maps alternate keys and values */
+      Channel*         channel;
+   }as;
+}Message;
+
+struct VM;
+
+typedef struct {
+   /* reports a runtime error on behalf of the native name if the value can't be encoded */
+   bool     (*check)(struct VM *vm, Value value, const char *name);
+
+   /* only on checked values. A zeroed message is nil */
+   Message  (*encode)(Value value, MessageMode mode);
+
+   /* takes over everything the message holds */
+   Value    (*decode)(Message *message);
+   void     (*free)(Message *message);
+}MessageAPI;
+
+extern const MessageAPI ant_message;
+
+#endif // ANT_MESSAGE_H
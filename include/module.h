@@ -0,0 +1,34 @@
+#ifndef ANT_MODULE_H
+#define ANT_MODULE_H
+
+#include "common.h"
+#include "closure.h"
+#include "vm.h"
+
+/* import "path" runs the script at path once per VM and evaluates to a map of its globals,
+ * as they were when the script ended. Functions of the module keep using the globals themselves.
+ *
+ * A module has globals of its own: the compiler maps each of its names but the natives to
+ * `path:name`, so two modules, or a module and the script, never see each other's globals.
+ * Paths are relative to the working directory, like isolate(). A module is read and compiled
+ * the first time an import of it runs, later imports return the same exports without touching
+ * the file. Imports in a cycle are a runtime error, the exports of a module only exist once
+ * its whole script ran.
+ *
+ * The VM keeps path -> exports in vm->modules, the closure of the module while it runs.
+ */
+
+typedef struct {
+   /* true with the exports of a module that already ran */
+   bool            (*find)(VM *vm, ObjectString *path, Value *exports);
+
+   /* compiles the module into a closure for the VM to call. NULL after a runtime error */
+   ObjectClosure*  (*load)(VM *vm, ObjectString *path);
+
+   /* the module returned its exports */
+   void            (*loaded)(VM *vm, ObjectString *path, Value exports);
+}ModuleAPI;
+
+extern const ModuleAPI ant_module;
+
+#endif // ANT_MODULE_H
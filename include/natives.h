@@ -5,18 +5,29 @@
 #include "value.h"
 #include "vm.h"
 
-typedef Value (*NativeFunction)(int32_t arg_count, Value *args);
+/* Natives signal a runtime error by calling ant_vm.runtime_error and returning undefined */
+typedef Value (*NativeFunction)(VM *vm, int32_t arg_count, Value *args);
 
 struct ObjectNative {
   Object object;
   NativeFunction func;
+  int32_t arity;
 };
 
 typedef struct {
    Object*        (*as_object)(ObjectNative *native);
-   ObjectNative*  (*new)(NativeFunction func);
+   ObjectNative*  (*new)(NativeFunction func, int32_t arity);
    ObjectNative*  (*from_value)(Value value);
    void           (*register_all)(VM *vm);
+
+   /* only adds the names to the current mapping, for contexts that compile but never run */
+   void           (*register_names)(void);
+
+   /* position in the natives table, -1 if unknown */
+   int32_t        (*index)(ObjectNative *native);
+
+   /* as registered, "native" if unknown */
+   const char*    (*name)(ObjectNative *native);
    int32_t        (*print)(void);
 }ObjectNativeAPI;
 
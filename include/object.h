@@ -10,6 +10,11 @@ typedef enum {
   OBJ_CLOSURE =  2,
   OBJ_NATIVE =   3,
   OBJ_UPVALUE =  4,
+  OBJ_LIST =     5,
+  OBJ_F64ARRAY = 6,
+  OBJ_MAP =      7,
+  OBJ_FIBER =    8,
+  OBJ_CHANNEL =  9,
 } ObjectType;
 
 struct Object {
@@ -19,11 +24,19 @@ struct Object {
 
 typedef struct ObjectAPI {
   ObjectType     (*type)         (Value value);
+  const char*    (*type_name)    (ObjectType type);
   bool           (*is_string)    (Value value);
   bool           (*is_function)  (Value value);
   bool           (*is_closure)   (Value value);
   bool           (*is_native)    (Value value);
+  bool           (*is_list)      (Value value);
+  bool           (*is_map)       (Value value);
   int32_t        (*print)        (Value value, bool debug);
+
+  /* lists and maps being printed or stringified, false when the object already is one of them
+   * (a cycle) or they are nested deeper than OPTION_PRINT_DEPTH_MAX. leave pops the last entered */
+  bool           (*enter)        (Object* object);
+  void           (*leave)        (void);
   Object*        (*allocate)     (size_t size, ObjectType object_type);
   void           (*free)         (Object* object);
 }ObjectAPI;
@@ -35,6 +48,11 @@ typedef struct ObjectAPI {
 #define OBJECT_IS_CLOSURE(value)    (OBJECT_IS_TYPE((value), OBJ_CLOSURE))
 #define OBJECT_IS_UPVALUE(value)    (OBJECT_IS_TYPE((value), OBJ_UPVALUE))
 #define OBJECT_IS_NATIVE(value)     (OBJECT_IS_TYPE((value), OBJ_NATIVE))
+#define OBJECT_IS_LIST(value)       (OBJECT_IS_TYPE((value), OBJ_LIST))
+#define OBJECT_IS_F64ARRAY(value)   (OBJECT_IS_TYPE((value), OBJ_F64ARRAY))
+#define OBJECT_IS_MAP(value)        (OBJECT_IS_TYPE((value), OBJ_MAP))
+#define OBJECT_IS_FIBER(value)      (OBJECT_IS_TYPE((value), OBJ_FIBER))
+#define OBJECT_IS_CHANNEL(value)    (OBJECT_IS_TYPE((value), OBJ_CHANNEL))
 
 extern ObjectAPI ant_object;
 #endif // ANT_OBJECT_H
@@ -0,0 +1,40 @@
+#ifndef ANT_PARALLEL_H
+#define ANT_PARALLEL_H
+
+#include "common.h"
+#include "list.h"
+#include "closure.h"
+#include "vm.h"
+
+/* parallel_map(list, fn) and parallel_reduce(list, fn, initial) on a work-stealing pool.
+ *
+ * The list is split in chunks spread over the deques of the workers, a worker out of chunks
+ * steals from the others. Each worker has a VM of its own running fn with the context of the
+ * calling VM as read-only parent, the calling VM waits so nothing changes it meanwhile.
+ * Results come back as messages, see message.h, and are rebuilt in the heap of the caller.
+ *
+ * fn must be pure, which is documented rather than enforced:
+ *   - items, upvalues and globals are shared with every worker, they must not be modified
+ *   - assignments to globals stay in the worker VM and are lost after the chunk
+ *   - it must return values that can be passed between threads, so no functions or fibers
+ *   - it must not import modules, the worker VM would map their globals over the copied ones
+ *
+ * parallel_reduce reduces each chunk from its own copy of initial, then folds the chunk
+ * results with fn. So fn must be associative and initial its identity, like 0 for a sum.
+ * Neither native can be called from inside fn.
+ */
+
+typedef struct {
+   /* a new list, undefined after a runtime error */
+   Value  (*map)(VM *vm, ObjectList *list, ObjectClosure *closure);
+   Value  (*reduce)(VM *vm, ObjectList *list, ObjectClosure *closure, Value initial);
+
+   /* the first parallel call starts a thread per core unless start picked another count.
+    * stop waits for running jobs, the next call starts the pool again */
+   bool   (*start)(int32_t thread_count);
+   void   (*stop)(void);
+}ParallelAPI;
+
+extern const ParallelAPI ant_parallel;
+
+#endif // ANT_PARALLEL_H
@@ -0,0 +1,48 @@
+#ifndef ANT_PERF_H
+#define ANT_PERF_H
+
+#include "common.h"
+#include "functions.h"
+
+#include <stdio.h>
+
+/* Hardware counters of a script through perf_event_open, ant --perf[=functions] path.
+ *
+ * The counters are task clock, cycles, instructions, branch misses and L1d read misses, user
+ * space only, in one group read with a single syscall. Each one that can't be opened, on a VM
+ * without a PMU or with perf_event_paranoid too high, is reported as n/a and the others still
+ * count. Only the thread running the script is counted, not isolates or parallel workers.
+ *
+ * With functions the VM also reads the group when a call starts, when a frame returns and when
+ * a native returns, and charges what was counted since the previous read to the function that
+ * was running: self counts, natives included in their caller. A read is a syscall, so the
+ * counts include some of that cost, the split between functions matters more than the totals.
+ */
+
+typedef struct PerfSession PerfSession;
+
+#define PERF_SYNC(vm, is_call)                                                 \
+  do {                                                                         \
+    if ((vm)->perf != NULL) {                                                  \
+      ant_perf.sync((vm)->perf, (vm)->frame_count > 0 ?                        \
+                    (vm)->frames[(vm)->frame_count - 1].closure->func : NULL,  \
+                    (is_call));                                                \
+    }                                                                          \
+  } while (false)
+
+typedef struct {
+   /* NULL when no counter at all could be opened. Counting starts right away */
+   PerfSession*  (*open)(bool functions);
+
+   /* charges the counts since the last sync to the function running until now, then running
+    * is the function on top of the frames, a new call of it when is_call */
+   void          (*sync)(PerfSession *session, ObjectFunction *running, bool is_call);
+
+   /* stops counting and prints the totals, then the functions by cycles, limit rows */
+   void          (*report)(PerfSession *session, FILE *file, int32_t limit);
+   void          (*close)(PerfSession *session);
+}PerfAPI;
+
+extern const PerfAPI ant_perf;
+
+#endif // ANT_PERF_H
@@ -0,0 +1,37 @@
+#ifndef ANT_POOL_H
+#define ANT_POOL_H
+
+#include "common.h"
+
+/* Runs scripts concurrently, one VM per worker thread.
+ *
+ * Each distinct source is compiled once into a shared cache, in a context of its own.
+ * Once compiled the entry is never modified, workers use its context as a read-only parent
+ * and free everything they allocated after each script.
+ *
+ * Scripts are isolated: globals defined by one script are not visible to the next.
+ */
+
+typedef struct AntPool AntPool;
+
+typedef struct {
+   int64_t ok;
+   int64_t compile_errors;
+   int64_t runtime_errors;
+   int64_t cache_hits;
+   int64_t cache_misses;
+}PoolStats;
+
+typedef struct {
+   AntPool*    (*new)(int32_t thread_count);
+   void        (*free)(AntPool *pool);   /* waits for queued scripts */
+
+   /* the source is copied, returns false if the pool is shutting down */
+   bool        (*submit)(AntPool *pool, const char *source);
+   void        (*wait)(AntPool *pool);
+   PoolStats   (*stats)(AntPool *pool);
+}AntPoolAPI;
+
+extern const AntPoolAPI ant_pool;
+
+#endif // ANT_POOL_H
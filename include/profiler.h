@@ -0,0 +1,43 @@
+#ifndef ANT_PROFILER_H
+#define ANT_PROFILER_H
+
+#include "common.h"
+#include "vm.h"
+
+/* Sampling profiler of the functions of a script, ant --profile file path.
+ *
+ * An ITIMER_PROF timer raises SIGPROF every OPTION_PROFILE_INTERVAL_US of CPU time, in any
+ * thread of the process. The handler only counts the tick in vm->sample_ticks, the stack is read
+ * by run() at its next safepoint, a call, a return or a loop back edge, where the frames are
+ * consistent. So the sample lands on the line of that instruction, in the right function, and
+ * weighs every tick counted since the last one. Time in natives is charged to the line calling
+ * them, workers of the parallel natives included.
+ *
+ * Samples are the frames of the running fiber and of the fibers that resumed it, as folded
+ * stacks: one line per distinct stack, root first, `script:12;fib:3;fib:4 27`. That is the
+ * input of flamegraph.pl and of speedscope. Only one VM is profiled at a time.
+ */
+
+#define PROFILE_SAFEPOINT(vm, frame, ip)                                        \
+  do {                                                                          \
+    if (atomic_load_explicit(&(vm)->sample_ticks, memory_order_relaxed) > 0) { \
+      (frame)->ip = (ip);                                                       \
+      ant_profiler.sample(vm);                                                  \
+    }                                                                           \
+  } while (false)
+
+typedef struct {
+   /* false when the timer could not be set */
+   bool  (*start)(VM *vm);
+   void  (*stop)(VM *vm);
+
+   /* records the stack of vm once per tick counted, frame->ip of the running frame synced */
+   void  (*sample)(VM *vm);
+
+   /* writes the folded stacks and drops them, false when the file can't be written */
+   bool  (*write)(const char *path);
+}ProfilerAPI;
+
+extern const ProfilerAPI ant_profiler;
+
+#endif // ANT_PROFILER_H
@@ -0,0 +1,32 @@
+#ifndef ANT_PROGRAM_H
+#define ANT_PROGRAM_H
+
+#include "common.h"
+#include "vm.h"
+
+/* A script compiled once and executed any number of times, on any VM.
+ *
+ * The program owns a context of its own holding the compiled functions and constants.
+ * It is never modified after compile, a running VM uses it as a read-only parent,
+ * so the same program can run on several VMs and threads at once.
+ */
+
+typedef struct AntProgram AntProgram;
+
+typedef enum {
+   PROGRAM_GLOBALS_FRESH,     /* reset the VM first, nothing from earlier runs is visible */
+   PROGRAM_GLOBALS_PERSIST,   /* keep globals from the previous run of the same program */
+}ProgramGlobals;
+
+typedef struct {
+   /* returns NULL on compile errors, the source is not needed once this returns */
+   AntProgram*       (*compile)(const char *source);
+   void              (*free)(AntProgram *program);
+
+   /* globals only persist across runs of the same program, running another one starts fresh */
+   InterpretResult   (*run)(VM *vm, const AntProgram *program, ProgramGlobals globals);
+}AntProgramAPI;
+
+extern const AntProgramAPI ant_program;
+
+#endif // ANT_PROGRAM_H
@@ -1,11 +1,19 @@
 #ifndef ANT_SCANNER_H
 #define ANT_SCANNER_H
 #include "common.h"
+#include "config.h"
 #include "token.h"
 typedef struct {
    const char* start;
    const char* current;
+   const char* line_start;
    int32_t line;
+   int32_t column;   /* of start */
+
+   /* string interpolation: braces[depth - 1] counts the '{' opened inside the
+    * innermost "${ ... }" so we know which '}' resumes the string */
+   int32_t interpolation_depth;
+   int32_t braces[OPTION_INTERPOLATION_MAX_DEPTH];
 }Scanner;
 
 typedef struct AntScanner{
@@ -8,36 +8,41 @@
 /* NOTE:
  * Stack operations are extremely performance
  * macro use is toto avoid function call overhead.
+ *
+ * The macros work on a `Stack *stack` that must be in scope.
+ * run() keeps it in a register, everything else takes it from the VM.
  */
 
 typedef struct {
-   Value       slots[OPTION_STACK_MAX]; 
+   Value*      slots;  /* allocated separately, each fiber owns one */
    Value*      top;    
+   Value*      end;
 } Stack;
 
-extern Stack stack;
-void print_stack(void);
+void print_stack(Stack *stack);
+void init_stack(Stack *stack, int32_t capacity);
+void free_stack(Stack *stack);
 
 #define STACK_PUSH(value) do { \
-    if ((stack.top - stack.slots) >= OPTION_STACK_MAX) { \
+    if (stack->top >= stack->end) { \
         fprintf(stderr, "Stack overflow\n"); \
         exit(11); \
     } \
-    *stack.top++ = (value); \
+    *stack->top++ = (value); \
 } while (0)
 
 #define STACK_POP() ( \
-    (stack.top == stack.slots) ? \
-        (fprintf(stderr, "Stack underflow\n"), exit(11), stack.slots[0]) : \
-        (*--stack.top) \
+    (stack->top == stack->slots) ? \
+        (fprintf(stderr, "Stack underflow\n"), exit(11), stack->slots[0]) : \
+        (*--stack->top) \
 )
 
-#define STACK_PEEK(distance) (*(stack.top - 1 - (distance)))
-#define STACK_RESET() (stack.top = stack.slots)
-#define STACK_SET_TOP(top) (stack.top = (top))
-#define STACK_TOP() (stack.top)
-#define STACK_DECREMENT_TOP(by) (stack.top -= (by))
-#define STACK_OVERFLOW(index) (stack.slots == stack.top || (index) == OPTION_STACK_MAX || stack.top < &stack.slots[(index)])
-#define STACK_AT(index) (stack.slots[(index)])
-#define STACK_PRINT() print_stack()
+#define STACK_PEEK(distance) (*(stack->top - 1 - (distance)))
+#define STACK_RESET() (stack->top = stack->slots)
+#define STACK_SET_TOP(new_top) (stack->top = (new_top))
+#define STACK_TOP() (stack->top)
+#define STACK_DECREMENT_TOP(by) (stack->top -= (by))
+#define STACK_OVERFLOW(index) (stack->slots == stack->top || stack->slots + (index) == stack->end || stack->top < &stack->slots[(index)])
+#define STACK_AT(index) (stack->slots[(index)])
+#define STACK_PRINT() print_stack(stack)
 #endif
@@ -0,0 +1,72 @@
+#ifndef ANT_STATS_H
+#define ANT_STATS_H
+
+#include "common.h"
+#include "config.h"
+#include "chunk.h"
+
+#include <stdio.h>
+
+/* Opcode counters for deciding on superinstructions, built by make stats.
+ *
+ * With DEBUG_OPCODE_STATS defined run() counts every instruction it dispatches, and every pair
+ * of an instruction with the one dispatched before it, in the stats of its VM. On x86 it also
+ * reads the time stamp counter at each dispatch and charges the cycles since the previous one
+ * to the previous opcode, dispatch included. Natives and the code they run are charged to
+ * OP_CALL. Without the define the recording macro is empty and vm->stats stays NULL.
+ *
+ * ant --stats[=file] path prints the histogram to stderr when the script ends, or writes it as
+ * JSON to file. Only the VM of the script is reported, not the VMs of isolates or workers.
+ */
+
+#define STATS_OPCODE_COUNT (OP_CONSTANT_LONG + 1)
+
+#if defined(DEBUG_OPCODE_STATS) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define STATS_HAS_CYCLES true
+#define STATS_READ_CYCLES() __rdtsc()
+#else
+#define STATS_HAS_CYCLES false
+#define STATS_READ_CYCLES() 0
+#endif
+
+typedef struct OpcodeStats {
+   uint64_t  counts[STATS_OPCODE_COUNT];
+   uint64_t  pairs[STATS_OPCODE_COUNT][STATS_OPCODE_COUNT];   /* [previous][next] */
+   uint64_t  cycles[STATS_OPCODE_COUNT];
+   uint64_t  last_cycles;
+   uint8_t   previous;
+   bool      started;                                          /* previous is set */
+}OpcodeStats;
+
+#ifdef DEBUG_OPCODE_STATS
+#define STATS_RECORD(stats, instruction)                                     \
+  do {                                                                       \
+    OpcodeStats *stats_ = (stats);                                           \
+    uint64_t now_       = STATS_READ_CYCLES();                               \
+    if (stats_->started) {                                                   \
+      stats_->cycles[stats_->previous] += now_ - stats_->last_cycles;        \
+      stats_->pairs[stats_->previous][(instruction)]++;                      \
+    }                                                                        \
+    stats_->counts[(instruction)]++;                                         \
+    stats_->previous    = (instruction);                                     \
+    stats_->last_cycles = now_;                                              \
+    stats_->started     = true;                                              \
+  } while (false)
+#else
+#define STATS_RECORD(stats, instruction) ((void)0)
+#endif
+
+typedef struct {
+   /* NULL unless built with DEBUG_OPCODE_STATS */
+   OpcodeStats*  (*new)(void);
+   void          (*free)(OpcodeStats *stats);
+
+   /* opcodes by count then the most frequent pairs, limit rows each */
+   void          (*print)(OpcodeStats *stats, FILE *file, int32_t limit);
+   bool          (*write_json)(OpcodeStats *stats, const char *path);
+}StatsAPI;
+
+extern const StatsAPI ant_stats;
+
+#endif // ANT_STATS_H
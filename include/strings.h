@@ -4,6 +4,18 @@
 #include "value.h"
 #include "object.h"
 #include "table.h"
+#include <stdatomic.h>
+
+/* Chars of a string handed to other isolates, see channel.h.
+ * Strings are immutable so every isolate can point at the same chars,
+ * they are freed with the last reference.
+ */
+typedef struct SharedChars {
+  atomic_int refs;
+  int32_t    length;
+  uint32_t   hash;
+  char *     chars;
+} SharedChars;
 
 /*  NOTE: having the struct Object as the frist member of the struct
  *  allow us to cast a ObjectString pointer to a Object pointer
@@ -14,6 +26,7 @@ struct ObjectString {
   char *  chars;
   int32_t length;
   uint32_t hash; /* cache of hash value */
+  SharedChars *shared; /* owns the chars once shared, NULL until then */
 };
 
 typedef struct {
@@ -21,9 +34,17 @@ typedef struct {
    void           (*free_table)       (void);
    ObjectString*  (*from_value)       (Value value);
    ObjectString*  (*concat)           (Value a, Value b);
+   ObjectString*  (*build)            (Value *parts, int32_t count);
    char*          (*as_cstring)       (ObjectString* string);
    int32_t        (*print)            (ObjectString* string, bool debug);
    Object*        (*as_object)        (ObjectString* string);
+
+  /* share returns a new reference to the chars, from_shared interns them in the current
+   * context taking over the reference. Chars are only copied for strings of a parent context,
+   * which are read-only */
+  SharedChars*   (*share)            (ObjectString* string);
+  ObjectString*  (*from_shared)      (SharedChars* shared);
+  void           (*release_shared)   (SharedChars* shared);
 }StringAPI;
 
 #define STRING_AS_OBJECT(string) ((Object*)(string))
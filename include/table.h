@@ -3,14 +3,23 @@
 #include "common.h"
 #include "value.h"
 
+/* Open addressing hash table keyed by any hashable Value.
+ *
+ * Empty entries have an undefined key and a nil value.
+ * Tombstones (deleted entries) have an undefined key and a true value.
+ *
+ * Strings hash with their cached hash and compare by identity, because ant interns ALL its strings.
+ * Numbers hash their bits, other objects hash and compare by identity.
+ */
+
 typedef struct {
-   ObjectString *key;
+   Value key;
    Value value;
 }Entry;
 
 
 typedef struct {
-   int32_t count;
+   int32_t count; /* live entries + tombstones */
    int32_t capacity;
    Entry *entries;
 }Table;
@@ -18,11 +27,19 @@ typedef struct {
 typedef struct{
    void            (*init)   (Table *table);
    void            (*free)   (Table *table);
+
+   /* string keys, used internally for interning and the globals mapping */
    bool            (*set)    (Table *table, ObjectString *key, Value value);
    bool            (*get)    (Table *table, ObjectString *key, Value *value);
    bool            (*delete) (Table *table, ObjectString *key);
    void            (*copy)   (Table *from, Table *to);
    ObjectString*   (*find)   (Table* table, const char* chars, int length, uint32_t hash);
+
+   /* any hashable value key. set returns true if the key was not in the table */
+   bool            (*set_value)    (Table *table, Value key, Value value);
+   bool            (*get_value)    (Table *table, Value key, Value *value);
+   bool            (*delete_value) (Table *table, Value key);
+   bool            (*is_hashable)  (Value key);
    
 }TableAPI;
 
@@ -14,45 +14,51 @@ typedef enum {
   TOKEN_SEMICOLON = 8,
   TOKEN_SLASH = 9,
   TOKEN_STAR = 10,
+  TOKEN_LEFT_BRACKET = 11,
+  TOKEN_RIGHT_BRACKET = 12,
+  TOKEN_COLON = 13,
 
   // One or two character tokens.
-  TOKEN_BANG = 11,
-  TOKEN_BANG_EQUAL = 12,
-  TOKEN_EQUAL = 13,
-  TOKEN_EQUAL_EQUAL = 14,
-  TOKEN_GREATER = 15,
-  TOKEN_GREATER_EQUAL = 16,
-  TOKEN_LESS = 17,
-  TOKEN_LESS_EQUAL = 18,
+  TOKEN_BANG = 14,
+  TOKEN_BANG_EQUAL = 15,
+  TOKEN_EQUAL = 16,
+  TOKEN_EQUAL_EQUAL = 17,
+  TOKEN_GREATER = 18,
+  TOKEN_GREATER_EQUAL = 19,
+  TOKEN_LESS = 20,
+  TOKEN_LESS_EQUAL = 21,
+  TOKEN_DOT_DOT = 22,
 
   // Literals.
-  TOKEN_IDENTIFIER = 19,
-  TOKEN_STRING = 20,
-  TOKEN_NUMBER = 21,
-  TOKEN_INTERPOLATION_START = 22,
-  TOKEN_INTERPOLATION_END = 23,
+  TOKEN_IDENTIFIER = 23,
+  TOKEN_STRING = 24,
+  TOKEN_NUMBER = 25,
+  TOKEN_INTERPOLATION_START = 26,
+  TOKEN_INTERPOLATION_END = 27,
 
   // Keywords.
-  TOKEN_AND = 24,
-  TOKEN_CLASS = 25,
-  TOKEN_ELSE = 26,
-  TOKEN_FALSE = 27,
-  TOKEN_FOR = 28,
-  TOKEN_FN = 29,
-  TOKEN_IF = 30,
-  TOKEN_NIL = 31,
-  TOKEN_OR = 32,
-  TOKEN_PRINT = 33,
-  TOKEN_RETURN = 34,
-  TOKEN_SUPER = 35,
-  TOKEN_THIS = 36,
-  TOKEN_TRUE = 37,
-  TOKEN_LET = 38,
-  TOKEN_WHILE = 39,
+  TOKEN_AND = 28,
+  TOKEN_CLASS = 29,
+  TOKEN_ELSE = 30,
+  TOKEN_FALSE = 31,
+  TOKEN_FOR = 32,
+  TOKEN_FN = 33,
+  TOKEN_IF = 34,
+  TOKEN_IN = 35,
+  TOKEN_NIL = 36,
+  TOKEN_OR = 37,
+  TOKEN_PRINT = 38,
+  TOKEN_RETURN = 39,
+  TOKEN_SUPER = 40,
+  TOKEN_THIS = 41,
+  TOKEN_TRUE = 42,
+  TOKEN_LET = 43,
+  TOKEN_WHILE = 44,
+  TOKEN_IMPORT = 45,
 
   // Error and end of file tokens.
-  TOKEN_ERROR = 40,
-  TOKEN_EOF = 41
+  TOKEN_ERROR = 46,
+  TOKEN_EOF = 47
 } TokenType;
 
 typedef struct {
@@ -60,6 +66,7 @@ typedef struct {
    const char *start;
    int32_t length;
    int32_t line;
+   int32_t column;   /* of the first char, from 1 */
 }Token;
 
 
@@ -0,0 +1,59 @@
+#ifndef ANT_TRACE_H
+#define ANT_TRACE_H
+
+#include "common.h"
+#include "config.h"
+#include "functions.h"
+
+/* Timeline of calls in the Chrome trace event format, built by make trace.
+ *
+ * With DEBUG_TRACE_EVENTS defined the VM records the entry and the return of every Ant function,
+ * every native call with its duration and the compile of every script and module. Without it
+ * the macros below are empty. Events go to a ring of OPTION_TRACE_EVENTS slots shared by every
+ * thread: a writer claims a slot with an atomic increment and publishes it with its sequence,
+ * so isolates and parallel workers never wait on each other. When the ring is full the oldest
+ * events are overwritten.
+ *
+ * ant --trace file path writes the events as JSON for chrome://tracing or Perfetto. Each OS
+ * thread is a process of the trace and each fiber a thread of it, so fibers switching on one
+ * thread keep their calls nested. Frames dropped by a runtime error have no end event.
+ * There is no GC to trace, objects are freed with their context.
+ */
+
+typedef enum {
+   TRACE_BEGIN,
+   TRACE_END,
+   TRACE_COMPLETE,   /* with a duration */
+}TracePhase;
+
+#define TRACE_FUNCTION_NAME(func) ((func)->name == NULL ? "script" : (func)->name->chars)
+
+#ifdef DEBUG_TRACE_EVENTS
+#define TRACE_CLOCK() ant_trace.now()
+#define TRACE_ENTER(track, name) ant_trace.record(TRACE_BEGIN, (track), (name), 0, 0)
+#define TRACE_LEAVE(track, name) ant_trace.record(TRACE_END, (track), (name), 0, 0)
+#define TRACE_SPAN(track, name, start) \
+   ant_trace.record(TRACE_COMPLETE, (track), (name), (start), ant_trace.now() - (start))
+#else
+#define TRACE_CLOCK() ((uint64_t)0)
+#define TRACE_ENTER(track, name) ((void)(track))
+#define TRACE_LEAVE(track, name) ((void)(track))
+#define TRACE_SPAN(track, name, start) ((void)(track), (void)(start))
+#endif
+
+typedef struct {
+   /* allocates the ring, false unless built with DEBUG_TRACE_EVENTS. Nothing is recorded before */
+   bool      (*start)(void);
+
+   /* track is the fiber of the event, any pointer telling it apart from the others.
+    * At 0 the timestamp is taken now */
+   void      (*record)(TracePhase phase, const void *track, const char *name, uint64_t timestamp, uint64_t duration);
+   uint64_t  (*now)(void);
+
+   /* once every thread recording is done. Frees the ring, false when the file can't be written */
+   bool      (*write)(const char *path);
+}TraceAPI;
+
+extern const TraceAPI ant_trace;
+
+#endif // ANT_TRACE_H
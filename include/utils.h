@@ -14,6 +14,11 @@ typedef struct AntUtils {
    */
   int32_t (*unpack_int32)(uint8_t *, int32_t);
   uint16_t (*unpack_uint16)(uint8_t *);
+
+  /**
+   * @brief FNV-1a hash of a byte buffer, same function used to intern strings
+   */
+  uint32_t (*hash)(const char *, int32_t);
 } Utils;
 
 extern Utils ant_utils;
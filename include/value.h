@@ -19,6 +19,11 @@ typedef struct ObjectString ObjectString;
 typedef struct ObjectFunction ObjectFunction;
 typedef struct ObjectClosure ObjectClosure;
 typedef struct ObjectNative ObjectNative;
+typedef struct ObjectList ObjectList;
+typedef struct ObjectF64Array ObjectF64Array;
+typedef struct ObjectMap ObjectMap;
+typedef struct ObjectFiber ObjectFiber;
+typedef struct ObjectChannel ObjectChannel;
 
 /**
  * Represents a value in the Ant language.
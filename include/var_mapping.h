@@ -16,6 +16,8 @@ typedef struct {
    void         (*free)(void);
    Value        (*add)(ObjectString*);
    ObjectString*(*find_name)(int32_t);
+   int32_t      (*find)(ObjectString*);   /* -1 for a name without index */
+   void         (*truncate)(int32_t count);
 }VarMappingAPI;
 
 extern const VarMappingAPI ant_mapping;
@@ -4,6 +4,13 @@
 #include "compiler.h"
 #include "config.h"
 #include "upvalues.h"
+#include "context.h"
+#include "fiber.h"
+#include "stack.h"
+#include "table.h"
+#include "stats.h"
+
+#include <stdatomic.h>
 
 typedef enum {
    INTERPRET_OK,
@@ -12,18 +19,25 @@ typedef enum {
 }InterpretResult;
 
 
-typedef struct {
-   ObjectClosure*  closure;  /* All functions are closures */
-   Value*          slots;    /* first slot of the call frame */
-   uint8_t*        ip;       /* return address */
-}CallFrame;
-
 typedef struct VM{
-   Compiler       compiler;            
+   Stack*         stack;               /* of the running fiber */
+   CallFrame*     frames;              /* same */
+   ObjectFiber*   fiber;               /* running fiber */
+   ObjectFiber*   root;                /* runs scripts, the other fibers are resumed from it */
+   ObjectFiber*   host;                /* run() returns when this fiber runs again, see run_fiber */
+   struct EventLoop* loop;             /* created by the first native waiting on it */
+   struct Isolate*   isolates;         /* started by scripts of this VM, joined when they end */
+   struct Channel*   channel;          /* isolate_channel(), NULL unless the VM runs an isolate */
+   AntContext*    context;             /* interned strings, globals mapping and heap */
+   Object*        natives_mark;        /* objects up to here are natives, reset frees everything newer */
    ValueArray     globals;
-   UpvalueList    open_upvalues;
-   CallFrame      frames[OPTION_FRAMES_MAX];
-   int32_t        frame_count;
+   Table          modules;             /* imported paths, see module.h */
+   OpcodeStats*   stats;               /* NULL unless built with DEBUG_OPCODE_STATS, see stats.h */
+   atomic_uint    sample_ticks;        /* counted by the profiler signal, see profiler.h */
+   struct PerfSession* perf;           /* counters read per function, NULL unless ant --perf=functions */
+   UpvalueList    open_upvalues;       /* of the running fiber */
+   int32_t        frame_count;         /* same */
+   int32_t        native_count;        /* globals below this index are natives, kept by reset */
 }VM;
 
 typedef struct VM_API{
@@ -31,6 +45,26 @@ typedef struct VM_API{
    void              (*free)(VM*);
    void              (*repl)(VM*);
    InterpretResult   (*interpret)(VM*, const char*);
+
+   /* interpret is compile + execute. A function compiled by one VM can be executed by another VM
+    * when the other context has it as parent, see pool.c */
+   ObjectFunction*   (*compile)(VM*, const char*);
+   InterpretResult   (*execute)(VM*, ObjectFunction*);
+
+   /* drops globals defined by scripts, any state left by a runtime error and every object
+    * allocated since new, functions returned by compile included */
+   void              (*reset)(VM*);
+
+   /* resumes a fiber from inside a native and runs it until control comes back to the fiber
+    * of the native, on yield, wait or return. The event loop wakes fibers with it */
+   InterpretResult   (*run_fiber)(VM*, ObjectFiber*, Value);
+
+   /* calls a closure with arg_count args on the root of an idle VM, the parallel natives run
+    * functions on worker VMs with it. Result is only set on INTERPRET_OK */
+   InterpretResult   (*call)(VM*, ObjectClosure*, int32_t arg_count, Value *args, Value *result);
+
+   /* prints the message and a stack trace. Natives call it before returning undefined */
+   void              (*runtime_error)(VM*, const char *format, ...);
 }AntVMAPI;
 
 extern AntVMAPI ant_vm;
@@ -0,0 +1,240 @@
+#include "alloc_sites.h"
+#include "context.h"
+#include "lines.h"
+#include "list.h"
+#include "map.h"
+#include "strings.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define SITE_NAME_MAX 48
+
+typedef struct {
+   const ObjectFunction*  func;    /* NULL for an empty slot */
+   int32_t                line;
+   ObjectType             type;
+   uint64_t               objects;
+   uint64_t               bytes;
+   char                   name[SITE_NAME_MAX];   /* copied, the function may be freed first */
+}Site;
+
+struct AllocationSites {
+   VM*      vm;
+   Site*    sites;      /* open addressing on func, line and type */
+   int32_t  count;
+   int32_t  capacity;
+};
+
+static void   start_sites(VM *vm);
+static void   stop_sites(VM *vm);
+static void   record_site(AllocationSites *sites, ObjectType type, size_t bytes, int32_t objects);
+static void   print_sites(VM *vm, FILE *file, int32_t limit);
+static Value  report_sites(VM *vm, int32_t limit);
+
+const AllocSitesAPI ant_alloc_sites = {
+   .start = start_sites,
+   .stop = stop_sites,
+   .record = record_site,
+   .print = print_sites,
+   .report = report_sites,
+};
+
+/* Private */
+static Site*        find_site(AllocationSites *sites, const ObjectFunction *func, int32_t line, ObjectType type);
+static Site*        find_slot(AllocationSites *sites, const ObjectFunction *func, int32_t line, ObjectType type);
+static void         grow_sites(AllocationSites *sites);
+static Site*        sorted_sites(AllocationSites *sites);
+static int          compare_sites(const void *a, const void *b);
+
+/* the compiler allocating outside of any frame */
+static const char compiler_site;
+#define COMPILER_SITE ((const ObjectFunction *)&compiler_site)
+
+/* Implementation */
+static void start_sites(VM *vm) {
+   if (vm->context->sites != NULL) {
+      return;
+   }
+
+   AllocationSites *sites = calloc(1, sizeof(AllocationSites));
+   sites->vm              = vm;
+   vm->context->sites     = sites;
+}
+
+/* */
+
+static void stop_sites(VM *vm) {
+   AllocationSites *sites = vm->context->sites;
+
+   if (sites != NULL) {
+      vm->context->sites = NULL;
+      free(sites->sites);
+      free(sites);
+   }
+}
+
+/* */
+
+static void record_site(AllocationSites *sites, ObjectType type, size_t bytes, int32_t objects) {
+   VM *vm                     = sites->vm;
+   const ObjectFunction *func = COMPILER_SITE;
+   int32_t line               = 0;
+
+   if (vm->frame_count > 0) {
+      CallFrame *frame = &vm->frames[vm->frame_count - 1];
+      func             = frame->closure->func;
+
+      int32_t offset = (int32_t)(frame->ip - func->chunk.code);
+      line           = ant_line.get(&func->chunk.lines, offset < func->chunk.count ? offset : func->chunk.count - 1);
+   }
+
+   Site *site = find_site(sites, func, line, type);
+   site->objects += objects;
+   site->bytes   += bytes;
+}
+
+/* */
+
+static void print_sites(VM *vm, FILE *file, int32_t limit) {
+   AllocationSites *sites = vm->context->sites;
+
+   if (sites == NULL) {
+      return;
+   }
+
+   Site *sorted = sorted_sites(sites);
+
+   fprintf(file, "\n== allocation sites ==\n\n");
+   fprintf(file, "%-40s %-10s %12s %14s\n", "function:line", "type", "objects", "bytes");
+
+   for (int32_t i = 0; i < sites->count && i < limit; i++) {
+      char where[SITE_NAME_MAX + 16];
+      snprintf(where, sizeof(where), "%s:%d", sorted[i].name, sorted[i].line);
+
+      fprintf(file, "%-40s %-10s %12lu %14lu\n", where, ant_object.type_name(sorted[i].type),
+              (unsigned long)sorted[i].objects, (unsigned long)sorted[i].bytes);
+   }
+
+   free(sorted);
+}
+
+/* the sites are copied first, the maps built here are allocations too */
+
+static Value report_sites(VM *vm, int32_t limit) {
+   AllocationSites *sites = vm->context->sites;
+
+   if (sites == NULL) {
+      return ant_value.make_nil();
+   }
+
+   Site *sorted  = sorted_sites(sites);
+   int32_t count = sites->count < limit ? sites->count : limit;
+   ObjectList *list = ant_list.new();
+
+#define SITE_KEY(key) ant_value.from_object(STRING_AS_OBJECT(ant_string.new(key, (int32_t)strlen(key))))
+
+   for (int32_t i = 0; i < count; i++) {
+      const char *type = ant_object.type_name(sorted[i].type);
+      ObjectMap *map   = ant_map.new();
+
+      ant_map.set(map, SITE_KEY("function"), SITE_KEY(sorted[i].name));
+      ant_map.set(map, SITE_KEY("line"), ant_value.from_number(sorted[i].line));
+      ant_map.set(map, SITE_KEY("type"), SITE_KEY(type));
+      ant_map.set(map, SITE_KEY("objects"), ant_value.from_number((double)sorted[i].objects));
+      ant_map.set(map, SITE_KEY("bytes"), ant_value.from_number((double)sorted[i].bytes));
+
+      ant_list.append(list, ant_value.from_object(MAP_AS_OBJECT(map)));
+   }
+
+#undef SITE_KEY
+
+   free(sorted);
+   return ant_value.from_object(LIST_AS_OBJECT(list));
+}
+
+/* Private */
+
+static Site *find_site(AllocationSites *sites, const ObjectFunction *func, int32_t line, ObjectType type) {
+   if ((sites->count + 1) * 4 > sites->capacity * 3) {
+      grow_sites(sites);
+   }
+
+   Site *site = find_slot(sites, func, line, type);
+
+   if (site->func == NULL) {
+      site->func = func;
+      site->line = line;
+      site->type = type;
+
+      const char *name = func == COMPILER_SITE ? "compiler" : func->name == NULL ? "script" : func->name->chars;
+      strncpy(site->name, name, SITE_NAME_MAX - 1);
+      sites->count++;
+   }
+
+   return site;
+}
+
+/* the site of func, line and type or the empty slot it goes to */
+
+static Site *find_slot(AllocationSites *sites, const ObjectFunction *func, int32_t line, ObjectType type) {
+   uint32_t hash  = (uint32_t)((uintptr_t)func >> 4) * 31 + (uint32_t)line * 17 + (uint32_t)type;
+   uint32_t index = hash & (sites->capacity - 1);
+
+   for (;;) {
+      Site *site = &sites->sites[index];
+
+      if (site->func == NULL || (site->func == func && site->line == line && site->type == type)) {
+         return site;
+      }
+
+      index = (index + 1) & (sites->capacity - 1);
+   }
+}
+
+/* */
+
+static void grow_sites(AllocationSites *sites) {
+   Site *old        = sites->sites;
+   int32_t capacity = sites->capacity;
+
+   sites->capacity = GROW_CAPACITY(capacity);
+   sites->sites    = calloc(sites->capacity, sizeof(Site));
+
+   for (int32_t i = 0; i < capacity; i++) {
+      if (old[i].func != NULL) {
+         *find_slot(sites, old[i].func, old[i].line, old[i].type) = old[i];
+      }
+   }
+
+   free(old);
+}
+
+/* the used slots, by bytes */
+
+static Site *sorted_sites(AllocationSites *sites) {
+   Site *sorted  = malloc(sizeof(Site) * (sites->count > 0 ? sites->count : 1));
+   int32_t count = 0;
+
+   for (int32_t i = 0; i < sites->capacity; i++) {
+      if (sites->sites[i].func != NULL) {
+         sorted[count++] = sites->sites[i];
+      }
+   }
+
+   qsort(sorted, count, sizeof(Site), compare_sites);
+   return sorted;
+}
+
+/* */
+
+static int compare_sites(const void *a, const void *b) {
+   const Site *x = a;
+   const Site *y = b;
+
+   if (x->bytes != y->bytes) {
+      return x->bytes < y->bytes ? 1 : -1;
+   }
+
+   return x->line - y->line;
+}
@@ -0,0 +1,339 @@
+#include "bytecode_cache.h"
+#include "bytes.h"
+#include "chunk.h"
+#include "config.h"
+#include "context.h"
+#include "functions.h"
+#include "memory.h"
+#include "strings.h"
+#include "utils.h"
+#include "var_mapping.h"
+
+#include <limits.h>
+#include <string.h>
+
+/* bump when the layout below changes. Caches from another ANT_VERSION or with a
+ * different number of opcodes are ignored on their own */
+#define BYTECODE_CACHE_VERSION 2
+#define BYTECODE_CACHE_OPCODES (OP_CONSTANT_LONG + 1)
+#define BYTECODE_CACHE_NO_NAME UINT32_MAX
+#define BYTECODE_CACHE_MAX_DEPTH 256
+
+/* Layout, see bytes.h for the encoding. Line tables are used in place.
+ *
+ *   header     CacheHeader
+ *   globals    global_count x (length, chars)
+ *   function   arity, upvalue_count, name length or NO_NAME, name chars,
+ *              code count, code, line bytes count, encoded runs, checkpoint count,
+ *              LineCheckpoint[], constant count, constants
+ *   constant   tag, then a double, a (length, chars) string or a nested function
+ */
+
+typedef struct {
+   char     magic[4];
+   uint32_t version;
+   uint32_t ant_version;
+   uint32_t opcode_count;
+   uint32_t source_hash;
+   uint32_t source_length;
+   uint32_t global_count;
+}CacheHeader;
+
+typedef enum {
+   CACHE_CONSTANT_NUMBER,
+   CACHE_CONSTANT_STRING,
+   CACHE_CONSTANT_FUNCTION,
+}CacheConstant;
+
+struct BytecodeFile {
+   MappedFile mapped;
+};
+
+static ObjectFunction *load_cache(VM *vm, const char *path, const char *source, BytecodeFile **file);
+static bool           save_cache(VM *vm, const char *path, ObjectFunction *script, const char *source);
+static void           close_cache(BytecodeFile *file);
+
+const BytecodeCacheAPI ant_bytecode_cache = {
+   .load = load_cache,
+   .save = save_cache,
+   .close = close_cache,
+};
+
+/* Private */
+static CacheHeader     make_header(const char *source, int32_t global_count);
+static bool            load_globals(ByteReader *reader, int32_t global_count);
+static ObjectFunction *read_function(ByteReader *reader, int32_t depth);
+static void            write_function(ByteWriter *writer, ObjectFunction *func);
+
+/* Implementation */
+
+static ObjectFunction *load_cache(VM *vm, const char *path, const char *source, BytecodeFile **file){
+   MappedFile mapped;
+
+   if(!ant_bytes.map(path, sizeof(CacheHeader), &mapped)){
+      return NULL;
+   }
+
+   ByteReader reader;
+   ant_bytes.init_reader(&reader, &mapped);
+
+   CacheHeader header;
+   memcpy(&header, ant_bytes.read(&reader, sizeof(CacheHeader)), sizeof(CacheHeader));
+
+   CacheHeader expected = make_header(source, (int32_t)header.global_count);
+
+   if(memcmp(&header, &expected, sizeof(CacheHeader)) != 0){
+      ant_bytes.unmap(&mapped);
+      return NULL;
+   }
+
+   ant_context.make_current(vm->context);
+
+   if(!load_globals(&reader, (int32_t)header.global_count)){
+      ant_bytes.unmap(&mapped);
+      return NULL;
+   }
+
+   /* a truncated or corrupt function tree leaves nothing behind */
+   Object *mark         = ant_context.mark(vm->context);
+   ObjectFunction *func = read_function(&reader, 0);
+
+   if(func == NULL || !reader.ok){
+      ant_context.release(vm->context, mark);
+      ant_bytes.unmap(&mapped);
+      return NULL;
+   }
+
+   *file           = ALLOCATE(BytecodeFile, 1);
+   (*file)->mapped = mapped;
+   return func;
+}
+
+/* */
+
+static bool save_cache(VM *vm, const char *path, ObjectFunction *script, const char *source){
+   ant_context.make_current(vm->context);
+
+   int32_t global_count = vm->context->mapping.count;
+   CacheHeader header   = make_header(source, global_count);
+
+   ByteWriter writer;
+   ant_bytes.init_writer(&writer);
+   ant_bytes.write(&writer, &header, sizeof(CacheHeader));
+
+   for(int32_t i = 0; i < global_count; i++){
+      ObjectString *name = ant_mapping.find_name(i);
+      ant_bytes.write_u32(&writer, (uint32_t)name->length);
+      ant_bytes.write_padded(&writer, name->chars, name->length);
+   }
+
+   write_function(&writer, script);
+
+   bool saved = ant_bytes.save(&writer, path);
+   ant_bytes.free_writer(&writer);
+   return saved;
+}
+
+/* */
+
+static void close_cache(BytecodeFile *file){
+   if(file == NULL){
+      return;
+   }
+
+   ant_bytes.unmap(&file->mapped);
+   FREE(BytecodeFile, file);
+}
+
+/* Private */
+
+static CacheHeader make_header(const char *source, int32_t global_count){
+   int32_t length = (int32_t)strlen(source);
+
+   CacheHeader header;
+   memcpy(header.magic, "ANTC", sizeof(header.magic));
+   header.version       = BYTECODE_CACHE_VERSION;
+   header.ant_version   = ant_utils.hash(ANT_VERSION, (int32_t)strlen(ANT_VERSION));
+   header.opcode_count  = BYTECODE_CACHE_OPCODES;
+   header.source_hash   = ant_utils.hash(source, length);
+   header.source_length = (uint32_t)length;
+   header.global_count  = (uint32_t)global_count;
+   return header;
+}
+
+/* Names already in the mapping, the natives, must sit at the same index.
+ * Only then the rest are added, so a mismatch leaves the mapping untouched.
+ */
+
+static bool load_globals(ByteReader *reader, int32_t global_count){
+   const uint8_t *start = reader->at;
+   int32_t known        = CURRENT_CONTEXT()->mapping.count;
+
+   for(int32_t i = 0; i < global_count; i++){
+      int32_t length    = (int32_t)ant_bytes.read_u32(reader);
+      const uint8_t *at = ant_bytes.read_padded(reader, length);
+
+      if(!reader->ok){
+         return false;
+      }
+
+      if(i < known){
+         ObjectString *name = ant_mapping.find_name(i);
+
+         if(name->length != length || memcmp(name->chars, at, length) != 0){
+            return false;
+         }
+      }
+   }
+
+   reader->at = start;
+
+   for(int32_t i = 0; i < global_count; i++){
+      int32_t length    = (int32_t)ant_bytes.read_u32(reader);
+      const uint8_t *at = ant_bytes.read_padded(reader, length);
+
+      if(i >= known){
+         ant_mapping.add(ant_string.new((const char*)at, length));
+      }
+   }
+
+   return true;
+}
+
+/* */
+
+static ObjectFunction *read_function(ByteReader *reader, int32_t depth){
+   if(depth > BYTECODE_CACHE_MAX_DEPTH){
+      reader->ok = false;
+      return NULL;
+   }
+
+   ObjectFunction *func = ant_function.new();
+   func->arity          = (int32_t)ant_bytes.read_u32(reader);
+   func->upvalue_count  = (int32_t)ant_bytes.read_u32(reader);
+
+   uint32_t name_length = ant_bytes.read_u32(reader);
+
+   if(name_length != BYTECODE_CACHE_NO_NAME){
+      const uint8_t *name = ant_bytes.read_padded(reader, (int32_t)name_length);
+
+      if(!reader->ok){
+         return NULL;
+      }
+
+      func->name = ant_string.new((const char*)name, (int32_t)name_length);
+   }
+
+   /* capacity stays 0, the chunk does not own its code and lines */
+   Chunk *chunk   = &func->chunk;
+   chunk->count   = (int32_t)ant_bytes.read_u32(reader);
+   chunk->code    = (uint8_t*)ant_bytes.read_padded(reader, chunk->count);
+
+   chunk->lines.count = (int32_t)ant_bytes.read_u32(reader);
+   chunk->lines.runs  = (uint8_t*)ant_bytes.read_padded(reader, chunk->lines.count);
+
+   chunk->lines.checkpoint_count = (int32_t)ant_bytes.read_u32(reader);
+
+   if(chunk->lines.checkpoint_count < 0 || chunk->lines.checkpoint_count > INT32_MAX / (int32_t)sizeof(LineCheckpoint)){
+      reader->ok = false;
+      return NULL;
+   }
+
+   chunk->lines.checkpoints = (LineCheckpoint*)ant_bytes.read(reader, chunk->lines.checkpoint_count * (int32_t)sizeof(LineCheckpoint));
+
+   int32_t constant_count = (int32_t)ant_bytes.read_u32(reader);
+
+   for(int32_t i = 0; i < constant_count && reader->ok; i++){
+      Value value = ant_value.make_nil();
+
+      switch(ant_bytes.read_u32(reader)){
+         case CACHE_CONSTANT_NUMBER: {
+            double number;
+            const uint8_t *at = ant_bytes.read(reader, sizeof(double));
+
+            if(at != NULL){
+               memcpy(&number, at, sizeof(double));
+               value = ant_value.from_number(number);
+            }
+            break;
+         }
+
+         case CACHE_CONSTANT_STRING: {
+            int32_t length    = (int32_t)ant_bytes.read_u32(reader);
+            const uint8_t *at = ant_bytes.read_padded(reader, length);
+
+            if(at != NULL){
+               value = ant_value.from_object(ant_string.as_object(ant_string.new((const char*)at, length)));
+            }
+            break;
+         }
+
+         case CACHE_CONSTANT_FUNCTION: {
+            ObjectFunction *nested = read_function(reader, depth + 1);
+
+            if(nested != NULL){
+               value = ant_value.from_object(ant_function.as_object(nested));
+            }
+            break;
+         }
+
+         default:
+            reader->ok = false;
+            break;
+      }
+
+      ant_value_array.write(&chunk->constants, value);
+   }
+
+   return reader->ok ? func : NULL;
+}
+
+/* */
+
+static void write_function(ByteWriter *writer, ObjectFunction *func){
+   ant_bytes.write_u32(writer, (uint32_t)func->arity);
+   ant_bytes.write_u32(writer, (uint32_t)func->upvalue_count);
+
+   if(func->name == NULL){
+      ant_bytes.write_u32(writer, BYTECODE_CACHE_NO_NAME);
+
+   } else {
+      ant_bytes.write_u32(writer, (uint32_t)func->name->length);
+      ant_bytes.write_padded(writer, func->name->chars, func->name->length);
+   }
+
+   Chunk *chunk = &func->chunk;
+   ant_bytes.write_u32(writer, (uint32_t)chunk->count);
+   ant_bytes.write_padded(writer, chunk->code, chunk->count);
+
+   ant_bytes.write_u32(writer, (uint32_t)chunk->lines.count);
+   ant_bytes.write_padded(writer, chunk->lines.runs, chunk->lines.count);
+   ant_bytes.write_u32(writer, (uint32_t)chunk->lines.checkpoint_count);
+   ant_bytes.write(writer, chunk->lines.checkpoints, chunk->lines.checkpoint_count * (int32_t)sizeof(LineCheckpoint));
+
+   ant_bytes.write_u32(writer, (uint32_t)chunk->constants.count);
+
+   for(int32_t i = 0; i < chunk->constants.count; i++){
+      Value value = chunk->constants.values[i];
+
+      if(VALUE_IS_NUMBER(value)){
+         double number = VALUE_AS_NUMBER(value);
+         ant_bytes.write_u32(writer, CACHE_CONSTANT_NUMBER);
+         ant_bytes.write(writer, &number, sizeof(double));
+
+      } else if(ant_object.is_string(value)){
+         ObjectString *string = ant_string.from_value(value);
+         ant_bytes.write_u32(writer, CACHE_CONSTANT_STRING);
+         ant_bytes.write_u32(writer, (uint32_t)string->length);
+         ant_bytes.write_padded(writer, string->chars, string->length);
+
+      } else if(ant_object.is_function(value)){
+         ant_bytes.write_u32(writer, CACHE_CONSTANT_FUNCTION);
+         write_function(writer, ant_function.from_value(value));
+
+      } else {
+         /* the compiler only emits the three above */
+         writer->ok = false;
+      }
+   }
+}
@@ -0,0 +1,262 @@
+#include "bytes.h"
+#include "memory.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static void            init_writer(ByteWriter *writer);
+static void            free_writer(ByteWriter *writer);
+static void            write_bytes(ByteWriter *writer, const void *bytes, int32_t length);
+static void            write_u32(ByteWriter *writer, uint32_t value);
+static void            write_padded(ByteWriter *writer, const void *bytes, int32_t length);
+static bool            save_writer(ByteWriter *writer, const char *path);
+static void            init_reader(ByteReader *reader, const MappedFile *file);
+static const uint8_t  *read_bytes(ByteReader *reader, int32_t length);
+static const uint8_t  *read_padded(ByteReader *reader, int32_t length);
+static uint32_t        read_u32(ByteReader *reader);
+static bool            map_file(const char *path, size_t min_size, MappedFile *file);
+static bool            map_source(const char *path, MappedFile *file);
+static void            unmap_file(MappedFile *file);
+
+const BytesAPI ant_bytes = {
+   .init_writer = init_writer,
+   .free_writer = free_writer,
+   .write = write_bytes,
+   .write_u32 = write_u32,
+   .write_padded = write_padded,
+   .save = save_writer,
+   .init_reader = init_reader,
+   .read = read_bytes,
+   .read_padded = read_padded,
+   .read_u32 = read_u32,
+   .map = map_file,
+   .map_source = map_source,
+   .unmap = unmap_file,
+};
+
+/* sources are read start to end once, prefault them rather than fault a page at a time */
+#ifdef MAP_POPULATE
+#define SOURCE_MAP_FLAGS MAP_POPULATE
+#else
+#define SOURCE_MAP_FLAGS 0
+#endif
+
+#define PADDING(length) ((int32_t)((sizeof(uint32_t) - (length) % sizeof(uint32_t)) % sizeof(uint32_t)))
+
+/* Writer */
+
+static void init_writer(ByteWriter *writer){
+   writer->bytes    = NULL;
+   writer->count    = 0;
+   writer->capacity = 0;
+   writer->ok       = true;
+}
+
+/* */
+
+static void free_writer(ByteWriter *writer){
+   FREE_ARRAY(uint8_t, writer->bytes, writer->capacity);
+   init_writer(writer);
+}
+
+/* */
+
+static void write_bytes(ByteWriter *writer, const void *bytes, int32_t length){
+   if(length < 0 || length > INT32_MAX - writer->count){
+      writer->ok = false;
+      return;
+   }
+
+   if(writer->count + length > writer->capacity){
+      int32_t old_capacity = writer->capacity;
+
+      while(writer->capacity < writer->count + length){
+         writer->capacity = GROW_CAPACITY(writer->capacity);
+      }
+
+      writer->bytes = GROW_ARRAY(uint8_t, writer->bytes, old_capacity, writer->capacity);
+   }
+
+   if(length > 0){
+      memcpy(writer->bytes + writer->count, bytes, length);
+   }
+
+   writer->count += length;
+}
+
+/* */
+
+static void write_u32(ByteWriter *writer, uint32_t value){
+   write_bytes(writer, &value, sizeof(uint32_t));
+}
+
+/* */
+
+static void write_padded(ByteWriter *writer, const void *bytes, int32_t length){
+   static const uint8_t zeros[sizeof(uint32_t)] = {0};
+
+   write_bytes(writer, bytes, length);
+   write_bytes(writer, zeros, PADDING(length));
+}
+
+/* */
+
+static bool save_writer(ByteWriter *writer, const char *path){
+   char temp_path[PATH_MAX];
+   int32_t written = snprintf(temp_path, sizeof(temp_path), "%s.%d.tmp", path, (int)getpid());
+
+   if(!writer->ok || written <= 0 || written >= (int32_t)sizeof(temp_path)){
+      return false;
+   }
+
+   FILE *out = fopen(temp_path, "wb");
+
+   if(out == NULL){
+      return false;
+   }
+
+   bool saved = fwrite(writer->bytes, 1, writer->count, out) == (size_t)writer->count;
+   saved      = fclose(out) == 0 && saved;
+   saved      = saved && rename(temp_path, path) == 0;
+
+   if(!saved){
+      remove(temp_path);
+   }
+
+   return saved;
+}
+
+/* Reader */
+
+static void init_reader(ByteReader *reader, const MappedFile *file){
+   reader->at  = file->data;
+   reader->end = (const uint8_t*)file->data + file->size;
+   reader->ok  = true;
+}
+
+/* */
+
+static const uint8_t *read_bytes(ByteReader *reader, int32_t length){
+   if(!reader->ok || length < 0 || length > reader->end - reader->at){
+      reader->ok = false;
+      return NULL;
+   }
+
+   const uint8_t *at = reader->at;
+   reader->at += length;
+   return at;
+}
+
+/* */
+
+static const uint8_t *read_padded(ByteReader *reader, int32_t length){
+   const uint8_t *at = read_bytes(reader, length);
+
+   if(at == NULL){
+      return NULL;
+   }
+
+   read_bytes(reader, PADDING(length));
+   return reader->ok ? at : NULL;
+}
+
+/* */
+
+static uint32_t read_u32(ByteReader *reader){
+   const uint8_t *at = read_bytes(reader, sizeof(uint32_t));
+
+   if(at == NULL){
+      return 0;
+   }
+
+   uint32_t value;
+   memcpy(&value, at, sizeof(uint32_t));
+   return value;
+}
+
+/* Files */
+
+static bool map_file(const char *path, size_t min_size, MappedFile *file){
+   int fd = open(path, O_RDONLY);
+
+   if(fd < 0){
+      return false;
+   }
+
+   struct stat info;
+
+   if(fstat(fd, &info) != 0 || (size_t)info.st_size < min_size || info.st_size == 0){
+      close(fd);
+      return false;
+   }
+
+   size_t size = (size_t)info.st_size;
+   void *data  = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+   close(fd);
+
+   if(data == MAP_FAILED){
+      return false;
+   }
+
+   file->data = data;
+   file->size = size;
+   return true;
+}
+
+/* The file is mapped over anonymous pages reserved one byte longer, which stay zero past its
+ * end: the page tail after the file is zeroed by mmap, and a file ending on a page boundary is
+ * followed by a whole page of zeros. */
+
+static bool map_source(const char *path, MappedFile *file){
+   int fd = open(path, O_RDONLY);
+
+   if(fd < 0){
+      return false;
+   }
+
+   struct stat info;
+
+   if(fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)){
+      close(fd);
+      return false;
+   }
+
+   size_t size     = (size_t)info.st_size;
+   size_t page     = (size_t)sysconf(_SC_PAGESIZE);
+   size_t reserved = (size / page + 1) * page;
+   void *data      = mmap(NULL, reserved, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+   if(data != MAP_FAILED && size > 0 &&
+      mmap(data, size, PROT_READ, MAP_PRIVATE | MAP_FIXED | SOURCE_MAP_FLAGS, fd, 0) == MAP_FAILED){
+      munmap(data, reserved);
+      data = MAP_FAILED;
+   }
+
+   close(fd);
+
+   if(data == MAP_FAILED){
+      return false;
+   }
+
+   madvise(data, size, MADV_SEQUENTIAL);
+
+   file->data = data;
+   file->size = reserved;
+   return true;
+}
+
+/* */
+
+static void unmap_file(MappedFile *file){
+   if(file->data != NULL){
+      munmap(file->data, file->size);
+   }
+
+   file->data = NULL;
+   file->size = 0;
+}
@@ -0,0 +1,201 @@
+#include "channel.h"
+#include "message.h"
+#include "memory.h"
+#include "vm.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+
+struct Channel {
+   atomic_int       refs;
+   pthread_mutex_t  lock;
+   pthread_cond_t   not_empty;
+   pthread_cond_t   not_full;
+   Message*         messages;   /* ring of capacity messages */
+   int32_t          capacity;
+   int32_t          head;
+   int32_t          count;
+   int32_t          receivers_waiting;
+   int32_t          senders_waiting;
+   bool             closed;
+};
+
+static Channel*        new_channel(int32_t capacity);
+static void            retain_channel(Channel *channel);
+static void            release_channel(Channel *channel);
+static ObjectChannel*  wrap_channel(Channel *channel);
+static ObjectChannel*  channel_from_value(Value value);
+static Object*         channel_as_object(ObjectChannel *object);
+static Value           send_value(VM *vm, Channel *channel, Value value);
+static Value           receive_value(VM *vm, Channel *channel);
+static void            close_channel(Channel *channel);
+static int32_t         print_channel(ObjectChannel *object);
+
+const ChannelAPI ant_channel = {
+   .new = new_channel,
+   .retain = retain_channel,
+   .release = release_channel,
+   .wrap = wrap_channel,
+   .from_value = channel_from_value,
+   .as_object = channel_as_object,
+   .send = send_value,
+   .receive = receive_value,
+   .close = close_channel,
+   .print = print_channel,
+};
+
+/* Implementation */
+
+static Channel *new_channel(int32_t capacity){
+   Channel *channel = ALLOCATE(Channel, 1);
+
+   atomic_init(&channel->refs, 1);
+   pthread_mutex_init(&channel->lock, NULL);
+   pthread_cond_init(&channel->not_empty, NULL);
+   pthread_cond_init(&channel->not_full, NULL);
+
+   channel->messages          = ALLOCATE(Message, capacity);
+   channel->capacity          = capacity;
+   channel->head              = 0;
+   channel->count             = 0;
+   channel->receivers_waiting = 0;
+   channel->senders_waiting   = 0;
+   channel->closed            = false;
+   return channel;
+}
+
+/* */
+
+static void retain_channel(Channel *channel){
+   atomic_fetch_add_explicit(&channel->refs, 1, memory_order_relaxed);
+}
+
+/* messages nobody received are dropped with the channel */
+
+static void release_channel(Channel *channel){
+   if(atomic_fetch_sub_explicit(&channel->refs, 1, memory_order_acq_rel) != 1){
+      return;
+   }
+
+   for(int32_t i = 0; i < channel->count; i++){
+      ant_message.free(&channel->messages[(channel->head + i) % channel->capacity]);
+   }
+
+   pthread_mutex_destroy(&channel->lock);
+   pthread_cond_destroy(&channel->not_empty);
+   pthread_cond_destroy(&channel->not_full);
+   FREE_ARRAY(Message, channel->messages, channel->capacity);
+   FREE(Channel, channel);
+}
+
+/* */
+
+static ObjectChannel *wrap_channel(Channel *channel){
+   ObjectChannel *object = (ObjectChannel*)ant_object.allocate(sizeof(ObjectChannel), OBJ_CHANNEL);
+   object->channel       = channel;
+   return object;
+}
+
+/* */
+
+static ObjectChannel *channel_from_value(Value value){
+   return (ObjectChannel*)ant_value.as_object(value);
+}
+
+/* */
+
+static Object *channel_as_object(ObjectChannel *object){
+   return (Object*)object;
+}
+
+/* The message is checked before anything is moved out of the value, so a value that can't
+ * be sent is left as it was. Encoding happens outside the lock, a channel closed meanwhile
+ * drops the message.
+ */
+
+static Value send_value(VM *vm, Channel *channel, Value value){
+
+   if(!ant_message.check(vm, value, "send")){
+      return ant_value.make_undefined();
+   }
+
+   pthread_mutex_lock(&channel->lock);
+   bool closed = channel->closed;
+   pthread_mutex_unlock(&channel->lock);
+
+   if(closed){
+      return ant_value.from_bool(false);
+   }
+
+   Message message = ant_message.encode(value, MESSAGE_MOVE);
+   pthread_mutex_lock(&channel->lock);
+
+   while(channel->count == channel->capacity && !channel->closed){
+      channel->senders_waiting++;
+      pthread_cond_wait(&channel->not_full, &channel->lock);
+      channel->senders_waiting--;
+   }
+
+   if(channel->closed){
+      pthread_mutex_unlock(&channel->lock);
+      ant_message.free(&message);
+      return ant_value.from_bool(false);
+   }
+
+   channel->messages[(channel->head + channel->count) % channel->capacity] = message;
+   channel->count++;
+
+   if(channel->receivers_waiting > 0){
+      pthread_cond_signal(&channel->not_empty);
+   }
+
+   pthread_mutex_unlock(&channel->lock);
+   return ant_value.from_bool(true);
+}
+
+/* decoded outside the lock, in the heap of the receiving isolate */
+
+static Value receive_value(VM *vm, Channel *channel){
+   (void)vm;
+   pthread_mutex_lock(&channel->lock);
+
+   while(channel->count == 0 && !channel->closed){
+      channel->receivers_waiting++;
+      pthread_cond_wait(&channel->not_empty, &channel->lock);
+      channel->receivers_waiting--;
+   }
+
+   if(channel->count == 0){
+      pthread_mutex_unlock(&channel->lock);
+      return ant_value.make_nil();
+   }
+
+   Message message = channel->messages[channel->head];
+   channel->head   = (channel->head + 1) % channel->capacity;
+   channel->count--;
+
+   if(channel->senders_waiting > 0){
+      pthread_cond_signal(&channel->not_full);
+   }
+
+   pthread_mutex_unlock(&channel->lock);
+   return ant_message.decode(&message);
+}
+
+/* */
+
+static void close_channel(Channel *channel){
+   pthread_mutex_lock(&channel->lock);
+   channel->closed = true;
+   pthread_cond_broadcast(&channel->not_empty);
+   pthread_cond_broadcast(&channel->not_full);
+   pthread_mutex_unlock(&channel->lock);
+}
+
+/* */
+
+static int32_t print_channel(ObjectChannel *object){
+   (void)object;
+   return printf("<channel>");
+}
@@ -9,25 +9,26 @@ typedef struct {
   OpCode op_24bit;
   int32_t index;
   int32_t line;
+  int32_t column;
 } WithOperandArgs;
 
 /* Foward declarations */
 static void init_chunk(Chunk *chunk);
-static void write_chunk(Chunk *chunk, uint8_t byte, int32_t line);
+static void write_chunk(Chunk *chunk, uint8_t byte, int32_t line, int32_t column);
 static bool patch_chunk_16(Chunk *chunk, int32_t offset, int32_t value);
 
 static void free_chunk(Chunk *chunk);
 static int32_t add_constant(Chunk *chunk, Value value);
-static bool write_constant(Chunk *chunk, Value value, int32_t line);
-static bool write_closure(Chunk *chunk, Value value, int32_t line);
+static bool write_constant(Chunk *chunk, Value value, int32_t line, int32_t column);
+static bool write_closure(Chunk *chunk, Value value, int32_t line, int32_t column);
 
-static bool write_define_global(Chunk *chunk, int32_t global_index, int32_t line);
-static bool write_get_global(Chunk *chunk, int32_t global_index, int32_t line);
-static bool write_set_global(Chunk *chunk, int32_t global_index, int32_t line);
-static bool write_set_local(Chunk *chunk, int32_t local_index, int32_t line);
-static bool write_get_local(Chunk *chunk, int32_t local_index, int32_t line);
-static bool write_set_upvalue(Chunk *chunk, int32_t upvalue_index, int32_t line);
-static bool write_get_upvalue(Chunk *chunk, int32_t upvalue_index, int32_t line);
+static bool write_define_global(Chunk *chunk, int32_t global_index, int32_t line, int32_t column);
+static bool write_get_global(Chunk *chunk, int32_t global_index, int32_t line, int32_t column);
+static bool write_set_global(Chunk *chunk, int32_t global_index, int32_t line, int32_t column);
+static bool write_set_local(Chunk *chunk, int32_t local_index, int32_t line, int32_t column);
+static bool write_get_local(Chunk *chunk, int32_t local_index, int32_t line, int32_t column);
+static bool write_set_upvalue(Chunk *chunk, int32_t upvalue_index, int32_t line, int32_t column);
+static bool write_get_upvalue(Chunk *chunk, int32_t upvalue_index, int32_t line, int32_t column);
 
 /* API */
 AntChunkAPI ant_chunk = {
@@ -63,7 +64,7 @@ static void init_chunk(Chunk *chunk) {
 
 /* */
 
-static void write_chunk(Chunk *chunk, uint8_t byte, int32_t line) {
+static void write_chunk(Chunk *chunk, uint8_t byte, int32_t line, int32_t column) {
 
   if (chunk->capacity < chunk->count + 1) {
     size_t old_capacity = chunk->capacity;
@@ -72,7 +73,7 @@ static void write_chunk(Chunk *chunk, uint8_t byte, int32_t line) {
   }
 
   chunk->code[chunk->count] = byte;
-  ant_line.write(&chunk->lines, line, chunk->count);
+  ant_line.write(&chunk->lines, line, column, chunk->count);
   chunk->count++;
 }
 
@@ -82,7 +83,11 @@ static void free_chunk(Chunk *chunk) {
   if (!chunk)
     return;
 
-  FREE_ARRAY(uint8_t, chunk->code, chunk->capacity);
+  /* code loaded from a bytecode cache is borrowed from the mapped file */
+  if (chunk->capacity > 0) {
+    FREE_ARRAY(uint8_t, chunk->code, chunk->capacity);
+  }
+
   ant_line.free(&chunk->lines);
   ant_value_array.free(&chunk->constants);
   init_chunk(chunk);
@@ -108,7 +113,7 @@ static bool patch_chunk_16(Chunk *chunk, int32_t offset, int32_t value){
 
 /* */
 
-static bool write_constant(Chunk *chunk, Value constant, int32_t line) {
+static bool write_constant(Chunk *chunk, Value constant, int32_t line, int32_t column) {
 
   int32_t constant_index = chunk->constants.count;
   ant_value_array.write(&chunk->constants, constant);
@@ -117,13 +122,14 @@ static bool write_constant(Chunk *chunk, Value constant, int32_t line) {
       .op_8bit = OP_CONSTANT,
       .op_24bit = OP_CONSTANT_LONG,
       .line = line,
+      .column = column,
       .index = constant_index,
   };
 
   return write_chunk_with_operand(chunk, args);
 }
 
-static bool write_closure(Chunk *chunk, Value value, int32_t line) {
+static bool write_closure(Chunk *chunk, Value value, int32_t line, int32_t column) {
    int32_t const_index = chunk->constants.count;
    ant_value_array.write(&chunk->constants, value);
 
@@ -131,6 +137,7 @@ static bool write_closure(Chunk *chunk, Value value, int32_t line) {
       .op_8bit = OP_CLOSURE,
       .op_24bit = OP_CLOSURE_LONG,
       .line = line,
+      .column = column,
       .index = const_index,
   };
 
@@ -148,59 +155,64 @@ static int32_t add_constant(Chunk *chunk, Value constant) {
 
 /* */
 
-static bool write_define_global(Chunk *chunk, int32_t global_index, int32_t line) {
+static bool write_define_global(Chunk *chunk, int32_t global_index, int32_t line, int32_t column) {
   WithOperandArgs args = {
       .op_8bit = OP_DEFINE_GLOBAL,
       .op_24bit = OP_DEFINE_GLOBAL_LONG,
       .index = global_index,
       .line = line,
+      .column = column,
   };
 
   return write_chunk_with_operand(chunk, args);
 }
 
-static bool write_get_global(Chunk *chunk, int32_t global_index, int32_t line) {
+static bool write_get_global(Chunk *chunk, int32_t global_index, int32_t line, int32_t column) {
   WithOperandArgs args = {
       .op_8bit = OP_GET_GLOBAL,
       .op_24bit = OP_GET_GLOBAL_LONG,
       .index = global_index,
       .line = line,
+      .column = column,
   };
 
   return write_chunk_with_operand(chunk, args);
 }
 
 
-static bool write_set_global(Chunk *chunk, int32_t global_index, int32_t line) {
+static bool write_set_global(Chunk *chunk, int32_t global_index, int32_t line, int32_t column) {
   WithOperandArgs args = {
       .op_8bit = OP_SET_GLOBAL,
       .op_24bit = OP_SET_GLOBAL_LONG,
       .index = global_index,
       .line = line,
+      .column = column,
   };
 
   return write_chunk_with_operand(chunk, args);
 }
 
-static bool write_set_local(Chunk *chunk, int32_t local_index, int32_t line){
+static bool write_set_local(Chunk *chunk, int32_t local_index, int32_t line, int32_t column){
 
    WithOperandArgs args = {
       .op_8bit = OP_SET_LOCAL,
       .op_24bit = OP_SET_LOCAL_LONG,
       .index = local_index,
       .line = line,
+      .column = column,
    };
 
    return write_chunk_with_operand(chunk, args);
 }
 
 
-static bool write_get_local(Chunk *chunk, int32_t local_index, int32_t line){
+static bool write_get_local(Chunk *chunk, int32_t local_index, int32_t line, int32_t column){
    WithOperandArgs args = {
       .op_8bit = OP_GET_LOCAL,
       .op_24bit = OP_GET_LOCAL_LONG,
       .index = local_index,
       .line = line,
+      .column = column,
    };
 
    return write_chunk_with_operand(chunk, args);
@@ -210,15 +222,15 @@ static bool write_get_local(Chunk *chunk, int32_t local_index, int32_t line){
 // TODO: For now upvalue and closure only support 8bits operands
 // in order to make them work with 24bits operands we need to change
 // the OP_CLOSURE instruction so that in the pair [is_local, index], the index can be a 24bits operands
-static bool write_set_upvalue(Chunk *chunk, int32_t upvalue_index, int32_t line){
-   write_chunk(chunk, OP_SET_UPVALUE, line);
-   write_chunk(chunk, (uint8_t)upvalue_index, line);
+static bool write_set_upvalue(Chunk *chunk, int32_t upvalue_index, int32_t line, int32_t column){
+   write_chunk(chunk, OP_SET_UPVALUE, line, column);
+   write_chunk(chunk, (uint8_t)upvalue_index, line, column);
    return true;
 }
 
-static bool write_get_upvalue(Chunk *chunk, int32_t upvalue_index, int32_t line){
-   write_chunk(chunk, OP_GET_UPVALUE, line);
-   write_chunk(chunk, (uint8_t)upvalue_index, line);
+static bool write_get_upvalue(Chunk *chunk, int32_t upvalue_index, int32_t line, int32_t column){
+   write_chunk(chunk, OP_GET_UPVALUE, line, column);
+   write_chunk(chunk, (uint8_t)upvalue_index, line, column);
    return true;
 }
 
@@ -229,8 +241,8 @@ static bool write_chunk_with_operand(Chunk *chunk, WithOperandArgs args) {
 
   /* if we can get away with 8bits, use the more efficient OP_CONSTANT */
   if (args.index < CONST_MAX_8BITS_VALUE) {
-    write_chunk(chunk, args.op_8bit, args.line);
-    write_chunk(chunk, args.index, args.line);
+    write_chunk(chunk, args.op_8bit, args.line, args.column);
+    write_chunk(chunk, args.index, args.line, args.column);
     return true;
   }
 
@@ -240,10 +252,11 @@ static bool write_chunk_with_operand(Chunk *chunk, WithOperandArgs args) {
   }
 
   /* Otherwise we use OP_CONSTANT_LONG that has a 24 bits operand */
-  write_chunk(chunk, args.op_24bit, args.line);
-  write_chunk(chunk, (uint8_t)(args.index & 0xFF), args.line);
-  write_chunk(chunk, (uint8_t)(args.index >> 8) & 0xFF, args.line);
-  write_chunk(chunk, (uint8_t)(args.index >> 16) & 0xFF, args.line);
+  /* most significant byte first, as read by the VM and ant_utils.unpack_int32 */
+  write_chunk(chunk, args.op_24bit, args.line, args.column);
+  write_chunk(chunk, (uint8_t)(args.index >> 16) & 0xFF, args.line, args.column);
+  write_chunk(chunk, (uint8_t)(args.index >> 8) & 0xFF, args.line, args.column);
+  write_chunk(chunk, (uint8_t)(args.index & 0xFF), args.line, args.column);
 
   return true;
 }
@@ -5,9 +5,11 @@
 #include "var_mapping.h"
 #include "debug.h"
 #include "common.h"
+#include "memory.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
+#include <string.h>
 #if defined(DEBUG_PRINT_CODE) || defined(DEBUG_TRACE_PARSER)
 #include "debug.h"
 #endif
@@ -46,7 +48,7 @@ static int32_t trace_depth = 0;
 #endif
 
 // write global variable callback
-typedef bool (*Callback)(Chunk *chunk, int32_t const_index, int32_t line);
+typedef bool (*Callback)(Chunk *chunk, int32_t const_index, int32_t line, int32_t column);
 
 typedef enum {
    VAR_RESOLVES_GLOBAL,
@@ -57,10 +59,12 @@ typedef enum {
 
 /* Public */
 static void init_compiler(Compiler *compiler, CompilationType type);
+static void init_module_compiler(Compiler *compiler, const char *path, int32_t builtin_count);
 static ObjectFunction *compile(Compiler *compiler, const char *source);
 
 const AntCompilerAPI ant_compiler = {
     .init = init_compiler,
+    .init_module = init_module_compiler,
     .compile = compile,
 };
 
@@ -73,6 +77,7 @@ static void variable_declaration(Compiler *compiler);
 static void statement(Compiler *compiler);
 static void while_statement(Compiler *compiler);
 static void for_statement(Compiler *compiler);
+static void range_for_statement(Compiler *compiler);
 static void print_statement(Compiler *compiler);
 static void if_statement(Compiler *compiler);
 static void return_statement(Compiler *compiler);
@@ -95,8 +100,14 @@ static void variable(Compiler *compiler, bool can_assign);
 static void call(Compiler *compiler, bool can_assign);
 static void literal(Compiler *compiler, bool can_assign);
 static void string(Compiler *compiler, bool can_assign);
+static void interpolation(Compiler *compiler, bool can_assign);
+static void list(Compiler *compiler, bool can_assign);
+static void map(Compiler *compiler, bool can_assign);
+static void subscript(Compiler *compiler, bool can_assign);
 static void and_operator(Compiler *compiler, bool can_assign);
 static void or_operator(Compiler *compiler, bool can_assign);
+static void dot(Compiler *compiler, bool can_assign);
+static void import(Compiler *compiler, bool can_assign);
 
 typedef void (*ParserFunc)(Compiler *, bool can_assign);
 
@@ -118,16 +129,19 @@ ParseRule rules[] = {
     /* TOKEN TYPE          PREFIX     INFIX   PRESEDENCE */
     [TOKEN_LEFT_PAREN] = {grouping, call, PREC_CALL},
     [TOKEN_RIGHT_PAREN] = {NULL, NULL, PREC_NONE},
-    [TOKEN_LEFT_BRACE] = {NULL, NULL, PREC_NONE},
+    [TOKEN_LEFT_BRACE] = {map, NULL, PREC_NONE},
     [TOKEN_RIGHT_BRACE] = {NULL, NULL, PREC_NONE},
     [TOKEN_COMMA] = {NULL, NULL, PREC_NONE},
-    [TOKEN_DOT] = {NULL, NULL, PREC_NONE},
+    [TOKEN_DOT] = {NULL, dot, PREC_CALL},
     [TOKEN_MINUS] = {unary, binary, PREC_TERM},
     // todo, TOKEN_PLUS as unary?
     [TOKEN_PLUS] = {unary, binary, PREC_TERM},
     [TOKEN_SEMICOLON] = {NULL, NULL, PREC_NONE},
     [TOKEN_SLASH] = {NULL, binary, PREC_FACTOR},
     [TOKEN_STAR] = {NULL, binary, PREC_FACTOR},
+    [TOKEN_LEFT_BRACKET] = {list, subscript, PREC_CALL},
+    [TOKEN_RIGHT_BRACKET] = {NULL, NULL, PREC_NONE},
+    [TOKEN_COLON] = {NULL, NULL, PREC_NONE},
     [TOKEN_BANG] = {unary, NULL, PREC_NONE},
     [TOKEN_EQUAL] = {NULL, NULL, PREC_NONE},
     [TOKEN_BANG_EQUAL] = {NULL, binary, PREC_COMPARISON},
@@ -136,9 +150,12 @@ ParseRule rules[] = {
     [TOKEN_GREATER_EQUAL] = {NULL, binary, PREC_COMPARISON},
     [TOKEN_LESS] = {NULL, binary, PREC_COMPARISON},
     [TOKEN_LESS_EQUAL] = {NULL, binary, PREC_COMPARISON},
+    [TOKEN_DOT_DOT] = {NULL, NULL, PREC_NONE},
     [TOKEN_IDENTIFIER] = {variable, NULL, PREC_NONE},
     [TOKEN_STRING] = {string, NULL, PREC_NONE},
     [TOKEN_NUMBER] = {number, NULL, PREC_NONE},
+    [TOKEN_INTERPOLATION_START] = {interpolation, NULL, PREC_NONE},
+    [TOKEN_INTERPOLATION_END] = {NULL, NULL, PREC_NONE},
     [TOKEN_AND] = {NULL, and_operator, PREC_AND},
     [TOKEN_CLASS] = {NULL, NULL, PREC_NONE},
     [TOKEN_ELSE] = {NULL, NULL, PREC_NONE},
@@ -146,6 +163,7 @@ ParseRule rules[] = {
     [TOKEN_FOR] = {NULL, NULL, PREC_NONE},
     [TOKEN_FN] = {NULL, NULL, PREC_NONE},
     [TOKEN_IF] = {NULL, NULL, PREC_NONE},
+    [TOKEN_IN] = {NULL, NULL, PREC_NONE},
     [TOKEN_NIL] = {literal, NULL, PREC_NONE},
     [TOKEN_OR] = {NULL, or_operator, PREC_OR},
     [TOKEN_PRINT] = {NULL, NULL, PREC_NONE},
@@ -155,6 +173,7 @@ ParseRule rules[] = {
     [TOKEN_TRUE] = {literal, NULL, PREC_NONE},
     [TOKEN_LET] = {NULL, NULL, PREC_NONE},
     [TOKEN_WHILE] = {NULL, NULL, PREC_NONE},
+    [TOKEN_IMPORT] = {import, NULL, PREC_NONE},
     [TOKEN_ERROR] = {NULL, NULL, PREC_NONE},
     [TOKEN_EOF] = {NULL, NULL, PREC_NONE},
 };
@@ -169,7 +188,7 @@ static void named_variable(Compiler *compiler, Token name, bool can_assign);
 static VarResolution resolve_variable_scope(Compiler *compiler, Token *name, int32_t *var_index);
 static int32_t resolve_upvalue(Compiler *compiler, Token *name);
 static int32_t parse_variable(Compiler *compiler, const char *message);
-static int32_t make_global_identifier(Compiler *compiler, Token *token);
+static int32_t make_global_identifier(Compiler *compiler, Token *token, bool defining);
 
 
 /* Functions */
@@ -188,11 +207,14 @@ static void patch_jump(Compiler *compiler, int32_t offset);
 
 /* Emitting */
 static void emit_constant(Compiler *compiler, Value value);
+static int32_t emit_string_segment(Compiler *compiler, Token segment, int32_t suffix_length);
 static void emit_closure(Compiler *compiler, Compiler *func_compiler, ObjectFunction *func);
 static void emit_variable(Compiler *compiler, int32_t index, Callback callback);
 static int32_t emit_jump(Compiler *compiler, uint8_t instruction);
 static void emit_loop(Compiler *compiler, int32_t loop_start);
+static int32_t emit_range_jump(Compiler *compiler, uint8_t instruction, int32_t slot);
 static void emit_return_nil(Compiler *compiler);
+static void emit_exports(Compiler *compiler);
 static void emit_byte(Compiler *compiler, uint8_t byte);
 static void emit_two_bytes(Compiler *compiler, uint8_t byte1, uint8_t byte2);
 
@@ -214,9 +236,12 @@ static bool was_local_found(int32_t local_index);
 
 /* Compiler API */
 static void init_compiler(Compiler *compiler, CompilationType type) {
-  compiler->func      = NULL;
-  compiler->enclosing = NULL;
-  compiler->type      = type;
+  compiler->func          = NULL;
+  compiler->enclosing     = NULL;
+  compiler->type          = type;
+  compiler->module        = NULL;
+  compiler->builtin_count = 0;
+  ant_value_array.init(&compiler->exports);
 
   /* scanner gets initialize on compile method */
   ant_parser.init(&compiler->parser);
@@ -225,6 +250,14 @@ static void init_compiler(Compiler *compiler, CompilationType type) {
   ant_compiler_upvalues.init(&compiler->upvalues, compiler->func);
 }
 
+/* the path must outlive the compilation */
+
+static void init_module_compiler(Compiler *compiler, const char *path, int32_t builtin_count) {
+  init_compiler(compiler, COMPILATION_TYPE_SCRIPT);
+  compiler->module        = path;
+  compiler->builtin_count = builtin_count;
+}
+
 /**/
 
 static ObjectFunction *compile(Compiler *compiler, const char *source) {
@@ -275,7 +308,7 @@ static void declaration(Compiler *compiler) {
  * */
 
 static void function_declaration(Compiler *compiler) {
-  uint8_t global_index = parse_variable(compiler, "Expected function name.");
+  int32_t global_index = parse_variable(compiler, "Expected function name.");
 
   ScopeType scope = ant_locals.current_scope(&compiler->locals);
 
@@ -304,7 +337,7 @@ static void variable_declaration(Compiler *compiler) {
 
   // note that we do not emit a constant instruction here
   // that happens in define_variable below
-  uint8_t globals_index = parse_variable(compiler, "Expected variable name.");
+  int32_t globals_index = parse_variable(compiler, "Expected variable name.");
 
   if (match(compiler, TOKEN_EQUAL)) {
     expression(compiler);
@@ -440,6 +473,12 @@ static void for_statement(Compiler *compiler) {
   TRACE_PARSER_ENTER("Compiler *compiler = %p", compiler);
   TRACE_PARSER_TOKEN(compiler->parser.prev, compiler->parser.current);
 
+  if (match(compiler, TOKEN_IDENTIFIER)) {
+    range_for_statement(compiler);
+    TRACE_PARSER_EXIT();
+    return;
+  }
+
   begin_scope(compiler); // for variables are scoped to the loop
   consume(compiler, TOKEN_LEFT_PAREN, "Expected '(' after 'for'.");
 
@@ -488,6 +527,76 @@ static void for_statement(Compiler *compiler) {
   TRACE_PARSER_EXIT();
 }
 
+/*  for i in start..end, end is exclusive and evaluated once.
+ *  The counter and the limit live in hidden locals right below i,
+ *  so a whole iteration is a single OP_FOR_STEP.
+ *
+ *       <start expression>          -> hidden counter
+ *       <end expression>            -> hidden limit
+ *       OP_NIL                      -> i
+ *    |- OP_FOR_RANGE slot
+ *    |   body_start   <---------|
+ *    |  <body statement>        |
+ *    |  OP_FOR_STEP slot    ----|
+ *    |-> exit jump...
+ *       OP_POP x 3
+ *      continues...
+ *
+ * */
+
+static void range_for_statement(Compiler *compiler) {
+  TRACE_PARSER_ENTER("Compiler *compiler = %p", compiler);
+  TRACE_PARSER_TOKEN(compiler->parser.prev, compiler->parser.current);
+
+  /* names with a space can never be resolved from user code */
+  Token counter = {.type = TOKEN_IDENTIFIER, .start = " counter", .length = 8, .line = compiler->parser.prev.line, .column = compiler->parser.prev.column};
+  Token limit   = {.type = TOKEN_IDENTIFIER, .start = " limit", .length = 6, .line = compiler->parser.prev.line, .column = compiler->parser.prev.column};
+  Token name    = compiler->parser.prev;
+
+  begin_scope(compiler);
+  consume(compiler, TOKEN_IN, "Expected 'in' after loop variable.");
+
+  expression(compiler);
+  ant_locals.push(&compiler->locals, counter);
+  define_local_variable(compiler);
+
+  consume(compiler, TOKEN_DOT_DOT, "Expected '..' after range start.");
+
+  expression(compiler);
+  ant_locals.push(&compiler->locals, limit);
+  define_local_variable(compiler);
+
+  emit_byte(compiler, OP_NIL);
+  ant_locals.push(&compiler->locals, name);
+  define_local_variable(compiler);
+
+  int32_t slot = compiler->locals.count - 3;
+
+  if (slot > UINT8_MAX) {
+    error(&compiler->parser, "Too many local variables for a range loop.");
+  }
+
+  int32_t exit_jump = emit_range_jump(compiler, OP_FOR_RANGE, slot);
+  int32_t body_start = current_chunk(compiler)->count;
+
+  statement(compiler);
+
+  int32_t step_jump = emit_range_jump(compiler, OP_FOR_STEP, slot);
+
+  // jump back over the OP_FOR_STEP operands, like emit_loop
+  int32_t offset = current_chunk(compiler)->count - body_start;
+
+  if (offset > CONST_MAX_16BITS_VALUE) {
+    error(&compiler->parser, "Loop body too large.");
+  }
+
+  ant_chunk.patch_16bits(current_chunk(compiler), step_jump, offset);
+  patch_jump(compiler, exit_jump);
+
+  end_scope(compiler);
+  TRACE_PARSER_EXIT();
+}
+
 /*
  *   <Conditional Expression>
  *
@@ -603,7 +712,9 @@ static void compile_function(Compiler *parent_compiler, CompilationType type) {
 
   Compiler func_compiler;
   init_compiler(&func_compiler, type);
-  func_compiler.enclosing = parent_compiler;
+  func_compiler.enclosing     = parent_compiler;
+  func_compiler.module        = parent_compiler->module;
+  func_compiler.builtin_count = parent_compiler->builtin_count;
 
   // the function compiler will move the parse and scanner along during function compilation
   func_compiler.parser = parent_compiler->parser;
@@ -800,6 +911,134 @@ static void variable(Compiler *compiler, bool can_assign) {
   TRACE_PARSER_EXIT();
 }
 
+/*
+ *  [a, b] compiles to
+ *
+ *   OP_LIST
+ *   <a expression>
+ *   OP_LIST_APPEND
+ *   <b expression>
+ *   OP_LIST_APPEND
+ * */
+
+static void list(Compiler *compiler, bool _) {
+  TRACE_PARSER_ENTER("Compiler *compiler = %p", compiler);
+  TRACE_PARSER_TOKEN(compiler->parser.prev, compiler->parser.current);
+
+  emit_byte(compiler, OP_LIST);
+
+  if (!check(compiler, TOKEN_RIGHT_BRACKET)) {
+    do {
+      /* allows a trailing comma */
+      if (check(compiler, TOKEN_RIGHT_BRACKET)) {
+        break;
+      }
+
+      expression(compiler);
+      emit_byte(compiler, OP_LIST_APPEND);
+    } while (match(compiler, TOKEN_COMMA));
+  }
+
+  consume(compiler, TOKEN_RIGHT_BRACKET, "Expected ']' after list elements.");
+  TRACE_PARSER_EXIT();
+}
+
+/*
+ *  {a: b} compiles to
+ *
+ *   OP_MAP
+ *   <a expression>
+ *   <b expression>
+ *   OP_MAP_INSERT
+ *
+ *  A '{' at the start of a statement is always a block.
+ * */
+
+static void map(Compiler *compiler, bool _) {
+  TRACE_PARSER_ENTER("Compiler *compiler = %p", compiler);
+  TRACE_PARSER_TOKEN(compiler->parser.prev, compiler->parser.current);
+
+  emit_byte(compiler, OP_MAP);
+
+  if (!check(compiler, TOKEN_RIGHT_BRACE)) {
+    do {
+      /* allows a trailing comma */
+      if (check(compiler, TOKEN_RIGHT_BRACE)) {
+        break;
+      }
+
+      expression(compiler);
+      consume(compiler, TOKEN_COLON, "Expected ':' after map key.");
+      expression(compiler);
+      emit_byte(compiler, OP_MAP_INSERT);
+    } while (match(compiler, TOKEN_COMMA));
+  }
+
+  consume(compiler, TOKEN_RIGHT_BRACE, "Expected '}' after map entries.");
+  TRACE_PARSER_EXIT();
+}
+
+/* list[index], map[key] and their assignments */
+
+static void subscript(Compiler *compiler, bool can_assign) {
+  TRACE_PARSER_ENTER("Compiler *compiler = %p", compiler);
+  TRACE_PARSER_TOKEN(compiler->parser.prev, compiler->parser.current);
+
+  expression(compiler);
+  consume(compiler, TOKEN_RIGHT_BRACKET, "Expected ']' after index.");
+
+  if (can_assign && match(compiler, TOKEN_EQUAL)) {
+    expression(compiler);
+    emit_byte(compiler, OP_INDEX_SET);
+
+  } else {
+    emit_byte(compiler, OP_INDEX_GET);
+  }
+
+  TRACE_PARSER_EXIT();
+}
+
+/* `target.name` is `target["name"]`, the exports of a module read like fields */
+
+static void dot(Compiler *compiler, bool can_assign) {
+  TRACE_PARSER_ENTER("Compiler *compiler = %p", compiler);
+  TRACE_PARSER_TOKEN(compiler->parser.prev, compiler->parser.current);
+
+  consume(compiler, TOKEN_IDENTIFIER, "Expected name after '.'.");
+  Token name = compiler->parser.prev;
+  emit_constant(compiler, ant_value.from_object(ant_string.as_object(ant_string.new(name.start, name.length))));
+
+  if (can_assign && match(compiler, TOKEN_EQUAL)) {
+    expression(compiler);
+    emit_byte(compiler, OP_INDEX_SET);
+
+  } else {
+    emit_byte(compiler, OP_INDEX_GET);
+  }
+
+  TRACE_PARSER_EXIT();
+}
+
+/*  import "path" evaluates to the exports of the module, loaded the first time it runs
+ *
+ *   OP_CONSTANT     'path'
+ *   OP_IMPORT       -> calls the module, or pushes its exports and skips the next instruction
+ *   OP_IMPORT_END   -> keeps the exports the module returned
+ * */
+
+static void import(Compiler *compiler, bool can_assign) {
+  TRACE_PARSER_ENTER("Compiler *compiler = %p", compiler);
+  TRACE_PARSER_TOKEN(compiler->parser.prev, compiler->parser.current);
+
+  consume(compiler, TOKEN_STRING, "Expected path string after 'import'.");
+  Token path = compiler->parser.prev;
+
+  emit_constant(compiler, ant_value.from_object(ant_string.as_object(ant_string.new(path.start + 1, path.length - 2))));
+  emit_byte(compiler, OP_IMPORT);
+  emit_byte(compiler, OP_IMPORT_END);
+  TRACE_PARSER_EXIT();
+}
+
 /* */
 
 static void call(Compiler *compiler, bool can_assign){
@@ -842,6 +1081,44 @@ void string(Compiler *compiler, bool _) {
   emit_constant(compiler, value);
 }
 
+/*
+ *  "a ${x} b ${y}" compiles to
+ *
+ *   OP_CONSTANT     'a '
+ *   <x expression>
+ *   OP_CONSTANT     ' b '
+ *   <y expression>
+ *   OP_BUILD_STRING 4
+ *
+ *  empty segments are not emitted.
+ * */
+
+static void interpolation(Compiler *compiler, bool _) {
+  TRACE_PARSER_ENTER("Compiler *compiler = %p", compiler);
+  TRACE_PARSER_TOKEN(compiler->parser.prev, compiler->parser.current);
+
+  int32_t part_count = 0;
+
+  do {
+    /* segment lexeme is either "...${ or }...${ */
+    part_count += emit_string_segment(compiler, compiler->parser.prev, 2);
+    expression(compiler);
+    part_count++;
+  } while (match(compiler, TOKEN_INTERPOLATION_START));
+
+  consume(compiler, TOKEN_INTERPOLATION_END, "Expected '}' to close string interpolation.");
+
+  /* closing segment lexeme is }..." */
+  part_count += emit_string_segment(compiler, compiler->parser.prev, 1);
+
+  if (part_count > OPTION_INTERPOLATION_MAX_PARTS) {
+    errorf(&compiler->parser, "Cannot have more than %d parts in an interpolated string.", OPTION_INTERPOLATION_MAX_PARTS);
+  }
+
+  emit_two_bytes(compiler, OP_BUILD_STRING, (uint8_t)part_count);
+  TRACE_PARSER_EXIT();
+}
+
 /*
  *   <left operand experession>
  *  |--OP_JUMP_IF_FALSE // if left operand is false, jump to the end
@@ -898,6 +1175,11 @@ static void define_global_variable(Compiler *compiler, int32_t global_index) {
   TRACE_PARSER_TOKEN(compiler->parser.prev, compiler->parser.current);
 
   emit_variable(compiler, global_index, ant_chunk.write_define_global);
+
+  if (compiler->module != NULL) {
+    ant_value_array.write(&compiler->exports, ant_value.from_number(global_index));
+  }
+
   TRACE_PARSER_EXIT();
 }
 
@@ -1010,7 +1292,7 @@ static VarResolution resolve_variable_scope(Compiler *compiler, Token *name, int
   /* Note the globals resolves at runtime. For now we add it to the mapping. 
    * If it hasn't been declared variable will error at runtime
    * */
-  *var_index = make_global_identifier(compiler, name);
+  *var_index = make_global_identifier(compiler, name, false);
   return VAR_RESOLVES_GLOBAL;
 }
 
@@ -1070,7 +1352,7 @@ static int32_t parse_variable(Compiler *compiler, const char *message) {
     return -1; // dummy value
   }
 
-  int32_t globals_index = make_global_identifier(compiler, &compiler->parser.prev);
+  int32_t globals_index = make_global_identifier(compiler, &compiler->parser.prev, true);
   TRACE_PARSER_EXIT();
   return globals_index;
 }
@@ -1078,9 +1360,32 @@ static int32_t parse_variable(Compiler *compiler, const char *message) {
 /* Note that this function creates a global_index but doesn't emit
  * */
 
-static int32_t make_global_identifier(Compiler *compiler, Token *token) {
+static int32_t make_global_identifier(Compiler *compiler, Token *token, bool defining) {
   ObjectString *str = ant_string.new(token->start, token->length);
 
+  /* every name a module defines goes under its path, `path:name`, even one of a native so
+   * the native isn't replaced for the whole VM. Reading a name the module hasn't defined
+   * falls back to the native */
+  if (compiler->module != NULL) {
+    int32_t native        = ant_mapping.find(str);
+    int32_t prefix_length = (int32_t)strlen(compiler->module) + 1;
+    int32_t length        = prefix_length + token->length;
+    char *chars           = ALLOCATE(char, length);
+
+    memcpy(chars, compiler->module, prefix_length - 1);
+    chars[prefix_length - 1] = ':';
+    memcpy(chars + prefix_length, token->start, token->length);
+
+    ObjectString *prefixed = ant_string.new(chars, length);
+    FREE_ARRAY(char, chars, length);
+
+    bool is_native = native >= 0 && native < compiler->builtin_count;
+
+    if (defining || !is_native || ant_mapping.find(prefixed) >= 0) {
+      str = prefixed;
+    }
+  }
+
   // mapping global variables using the compiler's globals table
   // so vm can access value with O(1) direct indexing
   Value globals_index = ant_mapping.add(str);
@@ -1173,7 +1478,13 @@ static void consume(Compiler *compiler, TokenType type, const char *message) {
 /**/
 
 ObjectFunction *end_of_compilation(Compiler *compiler) {
-  emit_return_nil(compiler);
+  if (compiler->module != NULL && compiler->enclosing == NULL) {
+    emit_exports(compiler);
+  } else {
+    emit_return_nil(compiler);
+  }
+
+  ant_value_array.free(&compiler->exports);
   ObjectFunction *func = compiler->func;
 
 #ifdef DEBUG_PRINT_CODE
@@ -1231,20 +1542,36 @@ static void patch_jump(Compiler *compiler, int32_t offset) {
 /**/
 
 static void emit_constant(Compiler *compiler, Value value) {
-  int32_t line = compiler->parser.prev.line;
-  bool valid = ant_chunk.write_constant(current_chunk(compiler), value, line);
+  int32_t line   = compiler->parser.prev.line;
+  int32_t column = compiler->parser.prev.column;
+  bool valid = ant_chunk.write_constant(current_chunk(compiler), value, line, column);
 
   if (!valid) {
     error(&compiler->parser, "Too many constants in one chunk.");
   }
 }
 
+/* emits the string between the opening delimiter and the suffix, returns the number of constants emitted */
+
+static int32_t emit_string_segment(Compiler *compiler, Token segment, int32_t suffix_length) {
+  int32_t length = segment.length - 1 - suffix_length;
+
+  if (length <= 0) {
+    return 0;
+  }
+
+  ObjectString *string = ant_string.new(segment.start + 1, length);
+  emit_constant(compiler, ant_value.from_object(ant_string.as_object(string)));
+  return 1;
+}
+
 /**/
 
 static void emit_closure(Compiler *compiler, Compiler *func_compiler, ObjectFunction *func){
-   int32_t line = compiler->parser.prev.line;
-   Value value  = ant_value.from_object(ant_function.as_object(func));
-   bool valid   = ant_chunk.write_closure(current_chunk(compiler), value, line);
+   int32_t line   = compiler->parser.prev.line;
+   int32_t column = compiler->parser.prev.column;
+   Value value    = ant_value.from_object(ant_function.as_object(func));
+   bool valid     = ant_chunk.write_closure(current_chunk(compiler), value, line, column);
 
   if (!valid) {
     error(&compiler->parser, "Too many closure constants in one chunk.");
@@ -1252,8 +1579,8 @@ static void emit_closure(Compiler *compiler, Compiler *func_compiler, ObjectFunc
 
   for(int32_t i = 0; i < func->upvalue_count; i++){
      CompilerUpvalue upvalue =  func_compiler->upvalues.values[i];
-     ant_chunk.write(current_chunk(compiler), upvalue.is_local ? 1 : 0, line);
-     ant_chunk.write(current_chunk(compiler), upvalue.index, line);
+     ant_chunk.write(current_chunk(compiler), upvalue.is_local ? 1 : 0, line, column);
+     ant_chunk.write(current_chunk(compiler), upvalue.index, line, column);
   }
 }
 
@@ -1261,8 +1588,9 @@ static void emit_closure(Compiler *compiler, Compiler *func_compiler, ObjectFunc
 
 static void emit_variable(Compiler *compiler, int32_t index, Callback write_variable) {
 
-  int32_t line = compiler->parser.prev.line;
-  bool valid = write_variable(current_chunk(compiler), index, line);
+  int32_t line   = compiler->parser.prev.line;
+  int32_t column = compiler->parser.prev.column;
+  bool valid = write_variable(current_chunk(compiler), index, line, column);
 
   if (!valid) {
     error(&compiler->parser, "Too many global variables in one chunk.");
@@ -1295,25 +1623,55 @@ static void emit_loop(Compiler *compiler, int32_t loop_start) {
   emit_two_bytes(compiler, (offset >> 8) & 0xff, offset & 0xff);
 }
 
+/* like emit_jump, with the loop local slot before the 16 bit operand */
+
+static int32_t emit_range_jump(Compiler *compiler, uint8_t instruction, int32_t slot) {
+  emit_two_bytes(compiler, instruction, (uint8_t)slot);
+  emit_two_bytes(compiler, 0xff, 0xff);
+  return current_chunk(compiler)->count - CONST_16BITS;
+}
+
 /**/
 static void emit_return_nil(Compiler *compiler) {
   emit_byte(compiler, OP_NIL);
   emit_byte(compiler, OP_RETURN);
 }
 
+/* a module returns a map of the globals it defined, keyed by their names without the path */
+
+static void emit_exports(Compiler *compiler) {
+  int32_t prefix_length = (int32_t)strlen(compiler->module) + 1;
+
+  emit_byte(compiler, OP_MAP);
+
+  for (int32_t i = 0; i < compiler->exports.count; i++) {
+    int32_t global_index = (int32_t)ant_value.as_number(compiler->exports.values[i]);
+    ObjectString *global = ant_mapping.find_name(global_index);
+    ObjectString *name   = ant_string.new(global->chars + prefix_length, global->length - prefix_length);
+
+    emit_constant(compiler, ant_value.from_object(ant_string.as_object(name)));
+    emit_variable(compiler, global_index, ant_chunk.write_get_global);
+    emit_byte(compiler, OP_MAP_INSERT);
+  }
+
+  emit_byte(compiler, OP_RETURN);
+}
+
 /**/
 
 static void emit_byte(Compiler *compiler, uint8_t byte) {
-  int32_t line = compiler->parser.prev.line;
-  ant_chunk.write(current_chunk(compiler), byte, line);
+  int32_t line   = compiler->parser.prev.line;
+  int32_t column = compiler->parser.prev.column;
+  ant_chunk.write(current_chunk(compiler), byte, line, column);
 }
 
 /**/
 
 static void emit_two_bytes(Compiler *compiler, uint8_t byte1, uint8_t byte2) {
-  int32_t line = compiler->parser.prev.line;
-  ant_chunk.write(current_chunk(compiler), byte1, line);
-  ant_chunk.write(current_chunk(compiler), byte2, line);
+  int32_t line   = compiler->parser.prev.line;
+  int32_t column = compiler->parser.prev.column;
+  ant_chunk.write(current_chunk(compiler), byte1, line, column);
+  ant_chunk.write(current_chunk(compiler), byte2, line, column);
 }
 
 /* */
@@ -1375,7 +1733,7 @@ static void error_at(Parser *parser, const char *message) {
          
   parser->panic_mode = true;
 
-  fprintf(stderr, "[line %d] Error", token.line);
+  fprintf(stderr, "[line %d:%d] Error", token.line, token.column);
 
   switch (token.type) {
   case TOKEN_ERROR:
@@ -0,0 +1,93 @@
+#include "context.h"
+#include "strings.h"
+#include "object.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static AntContext*  new_context(void);
+static void         free_context(AntContext *context);
+static void         make_current(AntContext *context);
+static Object*      mark_objects(AntContext *context);
+static void         release_objects(AntContext *context, Object *mark);
+
+const ContextAPI ant_context = {
+   .new = new_context,
+   .free = free_context,
+   .make_current = make_current,
+   .mark = mark_objects,
+   .release = release_objects,
+};
+
+_Thread_local AntContext *ant_current_context = NULL;
+
+/* the context is not allocated through ant_memory, objects are only freed by free_context */
+
+static AntContext *new_context(void){
+   AntContext *context = (AntContext*)malloc(sizeof(AntContext));
+
+   if (context == NULL) {
+      fprintf(stderr, "Error: Could not allocate memory for interpreter context\n");
+      exit(1);
+   }
+
+   context->garbage.objects = NULL;
+   context->parent          = NULL;
+   context->sites           = NULL;
+   ant_table.init(&context->strings);
+
+   context->mapping.count = 0;
+   ant_table.init(&context->mapping.table);
+   ant_value_array.init(&context->mapping.reverse_lookup);
+
+   return context;
+}
+
+/* */
+
+static void free_context(AntContext *context){
+   AntContext *previous = ant_current_context;
+   make_current(context);
+
+   ant_memory.free_objects();
+
+   /* this only clear entries in the hash table
+    * the actual strings allocations were freed with the objects above
+    * */
+   ant_string.free_table();
+   ant_mapping.free();
+
+   ant_current_context = previous == context ? NULL : previous;
+   free(context);
+}
+
+/* */
+
+static void make_current(AntContext *context){
+   ant_current_context = context;
+}
+
+/* objects are pushed to the front of the list, so everything before mark is newer */
+
+static Object *mark_objects(AntContext *context){
+   return context->garbage.objects;
+}
+
+/* */
+
+static void release_objects(AntContext *context, Object *mark){
+   Object *head = context->garbage.objects;
+
+   while (head != NULL && head != mark) {
+      Object *next = head->next;
+
+      /* interned strings must leave the table with the object */
+      if (head->type == OBJ_STRING) {
+         ant_table.delete(&context->strings, (ObjectString*)head);
+      }
+
+      ant_object.free(head);
+      head = next;
+   }
+
+   context->garbage.objects = head;
+}
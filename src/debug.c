@@ -15,18 +15,21 @@ static int disassemble_instruction(Compiler *compiler, Chunk *frame_chunk, int o
 static void trace_parsing(const char *func_name, int32_t depth, const char *format, ...);
 static void trace_tokens(Token prev, Token current, int32_t depth);
 static void trace_token(Token token, const char *name, int32_t depth);
+static const char *opcode_name(uint8_t instruction);
 
 DebugAPI ant_debug = {
     .disassemble_chunk = disassemble_chunk,
     .disassemble_instruction = disassemble_instruction,
     .trace_parsing = trace_parsing,
     .trace_tokens = trace_tokens,
+    .opcode_name = opcode_name,
 };
 
 /* helpers */
 static int32_t print_instruction(const char *name, int32_t offset);
 static int32_t print_byte_instruction(const char *name, Chunk *frame_chunk, int32_t offset);
 static int32_t print_jump_instruction(const char *name, Chunk *frame_chunk, int32_t sign, int32_t offset);
+static int32_t print_range_instruction(const char *name, Chunk *frame_chunk, int32_t sign, int32_t offset);
 static int32_t print_constant_instruction(const char *name, Chunk *frame_chunk, int32_t offset);
 static int32_t print_closure_instruction(const char *name, Chunk *frame_chunk, int32_t offset);
 static int32_t print_global_instruction(const char *name, Chunk *frame_chunk, int offset);
@@ -37,6 +40,65 @@ static bool is_long_constant(uint8_t opcode);
 static void align_print(int32_t instruction_depth);
 
 /* Implementations */
+static const char *opcode_names[] = {
+    [OP_RETURN]               = "OP_RETURN",
+    [OP_NEGATE]               = "OP_NEGATE",
+    [OP_POSITIVE]             = "OP_POSITIVE",
+    [OP_ADD]                  = "OP_ADD",
+    [OP_SUBTRACT]             = "OP_SUBTRACT",
+    [OP_MULTIPLY]             = "OP_MULTIPLY",
+    [OP_DIVIDE]               = "OP_DIVIDE",
+    [OP_NIL]                  = "OP_NIL",
+    [OP_TRUE]                 = "OP_TRUE",
+    [OP_FALSE]                = "OP_FALSE",
+    [OP_NOT]                  = "OP_NOT",
+    [OP_EQUAL]                = "OP_EQUAL",
+    [OP_GREATER]              = "OP_GREATER",
+    [OP_LESS]                 = "OP_LESS",
+    [OP_PRINT]                = "OP_PRINT",
+    [OP_POP]                  = "OP_POP",
+    [OP_BUILD_STRING]         = "OP_BUILD_STRING",
+    [OP_LIST]                 = "OP_LIST",
+    [OP_LIST_APPEND]          = "OP_LIST_APPEND",
+    [OP_MAP]                  = "OP_MAP",
+    [OP_MAP_INSERT]           = "OP_MAP_INSERT",
+    [OP_INDEX_GET]            = "OP_INDEX_GET",
+    [OP_INDEX_SET]            = "OP_INDEX_SET",
+    [OP_CLOSURE]              = "OP_CLOSURE",
+    [OP_CLOSURE_LONG]         = "OP_CLOSURE_LONG",
+    [OP_CALL]                 = "OP_CALL",
+    [OP_IMPORT]               = "OP_IMPORT",
+    [OP_IMPORT_END]           = "OP_IMPORT_END",
+    [OP_JUMP]                 = "OP_JUMP",
+    [OP_JUMP_IF_FALSE]        = "OP_JUMP_IF_FALSE",
+    [OP_LOOP]                 = "OP_LOOP",
+    [OP_FOR_RANGE]            = "OP_FOR_RANGE",
+    [OP_FOR_STEP]             = "OP_FOR_STEP",
+    [OP_SET_UPVALUE]          = "OP_SET_UPVALUE",
+    [OP_GET_UPVALUE]          = "OP_GET_UPVALUE",
+    [OP_CLOSE_UPVALUE]        = "OP_CLOSE_UPVALUE",
+    [OP_DEFINE_GLOBAL]        = "OP_DEFINE_GLOBAL",
+    [OP_DEFINE_GLOBAL_LONG]   = "OP_DEFINE_GLOBAL_LONG",
+    [OP_GET_GLOBAL]           = "OP_GET_GLOBAL",
+    [OP_GET_GLOBAL_LONG]      = "OP_GET_GLOBAL_LONG",
+    [OP_SET_GLOBAL]           = "OP_SET_GLOBAL",
+    [OP_SET_GLOBAL_LONG]      = "OP_SET_GLOBAL_LONG",
+    [OP_SET_LOCAL]            = "OP_SET_LOCAL",
+    [OP_SET_LOCAL_LONG]       = "OP_SET_LOCAL_LONG",
+    [OP_GET_LOCAL]            = "OP_GET_LOCAL",
+    [OP_GET_LOCAL_LONG]       = "OP_GET_LOCAL_LONG",
+    [OP_CONSTANT]             = "OP_CONSTANT",
+    [OP_CONSTANT_LONG]        = "OP_CONSTANT_LONG",
+};
+
+static const char *opcode_name(uint8_t instruction) {
+  if (instruction >= sizeof(opcode_names) / sizeof(opcode_names[0])) {
+    return "OP_UNKNOWN";
+  }
+
+  return opcode_names[instruction];
+}
+
 static void disassemble_chunk(Compiler *compiler, Chunk *frame_chunk, const char *name) {
   printf("\n== %s ==\n\n", name);
 
@@ -150,12 +212,39 @@ static int32_t disassemble_instruction(Compiler *compiler, Chunk *frame_chunk, i
   case OP_POP:
     return print_instruction("OP_POP", offset);
 
+  case OP_BUILD_STRING:
+    return print_byte_instruction("OP_BUILD_STRING", frame_chunk, offset);
+
+  case OP_LIST:
+    return print_instruction("OP_LIST", offset);
+
+  case OP_LIST_APPEND:
+    return print_instruction("OP_LIST_APPEND", offset);
+
+  case OP_MAP:
+    return print_instruction("OP_MAP", offset);
+
+  case OP_MAP_INSERT:
+    return print_instruction("OP_MAP_INSERT", offset);
+
+  case OP_INDEX_GET:
+    return print_instruction("OP_INDEX_GET", offset);
+
+  case OP_INDEX_SET:
+    return print_instruction("OP_INDEX_SET", offset);
+
   case OP_JUMP_IF_FALSE:
     return print_jump_instruction("OP_JUMP_IF_FALSE", frame_chunk, 1, offset);
 
   case OP_JUMP:
     return print_jump_instruction("OP_JUMP", frame_chunk, 1, offset);
 
+  case OP_FOR_RANGE:
+    return print_range_instruction("OP_FOR_RANGE", frame_chunk, 1, offset);
+
+  case OP_FOR_STEP:
+    return print_range_instruction("OP_FOR_STEP", frame_chunk, -1, offset);
+
   case OP_LOOP:
     // loops jump backwards, so negative sign
     return print_jump_instruction("OP_LOOP", frame_chunk, -1, offset);
@@ -163,6 +252,12 @@ static int32_t disassemble_instruction(Compiler *compiler, Chunk *frame_chunk, i
   case OP_CALL:
     return print_byte_instruction("OP_CALL", frame_chunk, offset);
 
+  case OP_IMPORT:
+    return print_instruction("OP_IMPORT", offset);
+
+  case OP_IMPORT_END:
+    return print_instruction("OP_IMPORT_END", offset);
+
    case OP_CLOSURE:
     return print_closure_instruction("OP_CLOSURE", frame_chunk, offset);
 
@@ -253,6 +348,19 @@ static int32_t print_jump_instruction(const char *name, Chunk *frame_chunk, int3
 
 /* */
 
+static int32_t print_range_instruction(const char *name, Chunk *frame_chunk, int32_t sign, int32_t offset) {
+   uint8_t slot = frame_chunk->code[offset + 1];
+   uint16_t jump_offset = ant_utils.unpack_uint16(frame_chunk->code + offset + 2);
+   int32_t nb_jump_bytes = 4;
+
+  int32_t print_len = printf("%-16s %4d:slot %d -> %d", name, offset, slot, (offset + nb_jump_bytes) + (jump_offset * sign));
+  align_print(print_len);
+
+  return offset + nb_jump_bytes;
+}
+
+/* */
+
 static int32_t print_global_instruction(const char *name, Chunk *frame_chunk, int offset) {
 
   int32_t global_index = unpack_bitecode_operand(frame_chunk, &offset);
@@ -274,7 +382,11 @@ static int32_t print_local_instruction(const char *name, Compiler *compiler, Chu
   int32_t local_index = unpack_bitecode_operand(frame_chunk, &offset);
 
   int32_t print_len = printf("%-16s %4d:", name, local_index);
-  print_len += ant_locals.print(&compiler->locals, local_index);
+
+  /* no compiler when tracing execution, names are only known while compiling */
+  if (compiler != NULL) {
+    print_len += ant_locals.print(&compiler->locals, local_index);
+  }
 
   align_print(print_len);
   return offset;
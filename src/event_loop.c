@@ -0,0 +1,670 @@
+#include "event_loop.h"
+#include "fiber.h"
+#include "memory.h"
+#include "strings.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef enum {
+   WAIT_TIMER,        /* sleep, spawn and waits cancelled by close */
+   WAIT_FILE_CHUNK,   /* regular file, a chunk per turn of the loop */
+   WAIT_FILE,         /* pipe or fifo, until the end of file */
+   WAIT_READ,
+   WAIT_WRITE,
+   WAIT_CONNECT,
+}WaitKind;
+
+typedef struct Waiter {
+   ObjectFiber*    fiber;      /* NULL once the root wait it belonged to failed */
+   WaitKind        kind;
+   int             fd;
+   double          deadline;   /* ms on the monotonic clock */
+   uint64_t        sequence;   /* timers with the same deadline run in order */
+   ObjectString*   data;       /* writes */
+   int32_t         written;
+   char*           buffer;     /* reads */
+   int32_t         length;
+   int32_t         capacity;
+   Value           result;
+   bool            done;       /* waits of the root */
+   struct Waiter*  prev;       /* waiting on a fd */
+   struct Waiter*  next;
+}Waiter;
+
+struct EventLoop {
+   int       epoll_fd;
+   Waiter**  timers;           /* min heap on deadline then sequence */
+   int32_t   timer_count;
+   int32_t   timer_capacity;
+   Waiter*   io;
+   uint64_t  sequence;
+};
+
+#define BEFORE(a, b) ((a)->deadline < (b)->deadline || ((a)->deadline == (b)->deadline && (a)->sequence < (b)->sequence))
+
+static Value  loop_sleep(VM *vm, double ms);
+static Value  loop_read_file(VM *vm, ObjectString *path);
+static Value  loop_connect(VM *vm, int32_t port);
+static Value  loop_read(VM *vm, int32_t fd);
+static Value  loop_write(VM *vm, int32_t fd, ObjectString *data);
+static Value  loop_spawn(VM *vm, ObjectClosure *closure, double ms);
+static void   loop_close(VM *vm, int32_t fd);
+static bool   loop_drain(VM *vm);
+static void   loop_free(VM *vm);
+
+const EventLoopAPI ant_event_loop = {
+   .sleep = loop_sleep,
+   .read_file = loop_read_file,
+   .connect = loop_connect,
+   .read = loop_read,
+   .write = loop_write,
+   .spawn = loop_spawn,
+   .close = loop_close,
+   .drain = loop_drain,
+   .free = loop_free,
+};
+
+/* Private */
+static EventLoop *get_loop(VM *vm);
+static Waiter    *new_waiter(VM *vm, WaitKind kind, int fd);
+static void       free_waiter(Waiter *waiter);
+static double     now_ms(void);
+static Value      start(VM *vm, Waiter *waiter);
+static Value      wait_on(VM *vm, Waiter *waiter);
+static bool       tick(VM *vm);
+static bool       complete(EventLoop *loop, Waiter *waiter);
+static bool       wake(VM *vm, Waiter *waiter);
+static bool       arm(EventLoop *loop, Waiter *waiter, uint32_t events);
+static void       disarm(EventLoop *loop, Waiter *waiter);
+static void       push_timer(EventLoop *loop, Waiter *waiter, double deadline);
+static Waiter    *pop_timer(EventLoop *loop);
+static bool       reserve(Waiter *waiter, int32_t extra);
+static bool       fail(Waiter *waiter, bool owns_fd);
+
+/* Implementation */
+
+static Value loop_sleep(VM *vm, double ms){
+   EventLoop *loop = get_loop(vm);
+
+   if(loop == NULL){
+      return ant_value.make_undefined();
+   }
+
+   Waiter *waiter = new_waiter(vm, WAIT_TIMER, -1);
+   push_timer(loop, waiter, now_ms() + ms);
+   return wait_on(vm, waiter);
+}
+
+/* */
+
+static Value loop_read_file(VM *vm, ObjectString *path){
+   if(get_loop(vm) == NULL){
+      return ant_value.make_undefined();
+   }
+
+   int fd = open(path->chars, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+   struct stat info;
+
+   if(fd < 0){
+      return ant_value.make_nil();
+   }
+
+   if(fstat(fd, &info) != 0){
+      close(fd);
+      return ant_value.make_nil();
+   }
+
+   return start(vm, new_waiter(vm, S_ISREG(info.st_mode) ? WAIT_FILE_CHUNK : WAIT_FILE, fd));
+}
+
+/* only localhost */
+
+static Value loop_connect(VM *vm, int32_t port){
+   EventLoop *loop = get_loop(vm);
+
+   if(loop == NULL){
+      return ant_value.make_undefined();
+   }
+
+   int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+   if(fd < 0){
+      return ant_value.make_nil();
+   }
+
+   struct sockaddr_in address;
+   memset(&address, 0, sizeof(address));
+   address.sin_family      = AF_INET;
+   address.sin_port        = htons((uint16_t)port);
+   address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+   if(connect(fd, (struct sockaddr*)&address, sizeof(address)) == 0){
+      return ant_value.from_number(fd);
+   }
+
+   if(errno != EINPROGRESS){
+      close(fd);
+      return ant_value.make_nil();
+   }
+
+   Waiter *waiter = new_waiter(vm, WAIT_CONNECT, fd);
+
+   if(!arm(loop, waiter, EPOLLOUT)){
+      close(fd);
+      free_waiter(waiter);
+      return ant_value.make_nil();
+   }
+
+   return wait_on(vm, waiter);
+}
+
+/* */
+
+static Value loop_read(VM *vm, int32_t fd){
+   if(get_loop(vm) == NULL){
+      return ant_value.make_undefined();
+   }
+
+   return start(vm, new_waiter(vm, WAIT_READ, fd));
+}
+
+/* */
+
+static Value loop_write(VM *vm, int32_t fd, ObjectString *data){
+   if(get_loop(vm) == NULL){
+      return ant_value.make_undefined();
+   }
+
+   Waiter *waiter = new_waiter(vm, WAIT_WRITE, fd);
+   waiter->data   = data;
+   return start(vm, waiter);
+}
+
+/* the fiber is parked from the start, so only the loop can start it */
+
+static Value loop_spawn(VM *vm, ObjectClosure *closure, double ms){
+   EventLoop *loop = get_loop(vm);
+
+   if(loop == NULL){
+      return ant_value.make_undefined();
+   }
+
+   ObjectFiber *fiber = ant_fiber.new(closure);
+   fiber->state       = FIBER_WAITING;
+
+   Waiter *waiter = new_waiter(vm, WAIT_TIMER, -1);
+   waiter->fiber  = fiber;
+   push_timer(loop, waiter, now_ms() + ms);
+
+   return ant_value.from_object(ant_fiber.as_object(fiber));
+}
+
+/* waits on the fd are moved to the timers, they end on the next turn */
+
+static void loop_close(VM *vm, int32_t fd){
+   EventLoop *loop = vm->loop;
+   Waiter *waiter  = loop == NULL ? NULL : loop->io;
+
+   while(waiter != NULL){
+      Waiter *next = waiter->next;
+
+      if(waiter->fd == fd){
+         disarm(loop, waiter);
+         waiter->kind   = WAIT_TIMER;
+         waiter->result = ant_value.make_nil();
+         push_timer(loop, waiter, 0);
+      }
+
+      waiter = next;
+   }
+
+   close(fd);
+}
+
+/* */
+
+static bool loop_drain(VM *vm){
+   while(vm->loop != NULL && (vm->loop->timer_count > 0 || vm->loop->io != NULL)){
+      if(!tick(vm)){
+         return false;
+      }
+   }
+
+   return true;
+}
+
+/* */
+
+static void loop_free(VM *vm){
+   EventLoop *loop = vm->loop;
+
+   if(loop == NULL){
+      return;
+   }
+
+   while(loop->io != NULL){
+      Waiter *waiter = loop->io;
+      disarm(loop, waiter);
+      fail(waiter, waiter->kind == WAIT_FILE || waiter->kind == WAIT_CONNECT);
+      free_waiter(waiter);
+   }
+
+   for(int32_t i = 0; i < loop->timer_count; i++){
+      Waiter *waiter = loop->timers[i];
+      fail(waiter, waiter->kind == WAIT_FILE_CHUNK);
+      free_waiter(waiter);
+   }
+
+   close(loop->epoll_fd);
+   FREE_ARRAY(Waiter*, loop->timers, loop->timer_capacity);
+   FREE(EventLoop, loop);
+   vm->loop = NULL;
+}
+
+/* Private */
+
+static EventLoop *get_loop(VM *vm){
+   if(vm->loop != NULL){
+      return vm->loop;
+   }
+
+   int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+
+   if(epoll_fd < 0){
+      ant_vm.runtime_error(vm, "Could not create the event loop: %s", strerror(errno));
+      return NULL;
+   }
+
+   EventLoop *loop      = ALLOCATE(EventLoop, 1);
+   loop->epoll_fd       = epoll_fd;
+   loop->timers         = NULL;
+   loop->timer_count    = 0;
+   loop->timer_capacity = 0;
+   loop->io             = NULL;
+   loop->sequence       = 0;
+
+   vm->loop = loop;
+   return loop;
+}
+
+/* */
+
+static Waiter *new_waiter(VM *vm, WaitKind kind, int fd){
+   Waiter *waiter   = ALLOCATE(Waiter, 1);
+   waiter->fiber    = vm->fiber;
+   waiter->kind     = kind;
+   waiter->fd       = fd;
+   waiter->deadline = 0;
+   waiter->sequence = 0;
+   waiter->data     = NULL;
+   waiter->written  = 0;
+   waiter->buffer   = NULL;
+   waiter->length   = 0;
+   waiter->capacity = 0;
+   waiter->result   = ant_value.make_nil();
+   waiter->done     = false;
+   waiter->prev     = NULL;
+   waiter->next     = NULL;
+   return waiter;
+}
+
+/* */
+
+static void free_waiter(Waiter *waiter){
+   FREE_ARRAY(char, waiter->buffer, waiter->capacity);
+   FREE(Waiter, waiter);
+}
+
+/* */
+
+static double now_ms(void){
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC, &now);
+   return (double)now.tv_sec * 1000.0 + (double)now.tv_nsec / 1e6;
+}
+
+/* a ready fd finishes right away, without parking */
+
+static Value start(VM *vm, Waiter *waiter){
+   if(complete(vm->loop, waiter)){
+      Value result = waiter->result;
+      free_waiter(waiter);
+      return result;
+   }
+
+   return wait_on(vm, waiter);
+}
+
+/* the root has nothing to switch back to, it turns the loop until its own wait is done */
+
+static Value wait_on(VM *vm, Waiter *waiter){
+   if(vm->fiber != vm->root){
+      ant_fiber.wait(vm);
+      return ant_value.make_nil();
+   }
+
+   while(!waiter->done){
+      if(!tick(vm)){
+         /* still in the loop, freed when it ends */
+         waiter->fiber = NULL;
+         return ant_value.make_undefined();
+      }
+   }
+
+   Value result = waiter->result;
+   free_waiter(waiter);
+   return result;
+}
+
+/* One turn: ready fds first, then the expired timers.
+ * Timers queued during the turn wait for the next one, so chunked reads can't starve the fds.
+ */
+
+static bool tick(VM *vm){
+   EventLoop *loop = vm->loop;
+   int timeout     = -1;
+
+   if(loop->timer_count > 0){
+      double wait = loop->timers[0]->deadline - now_ms();
+      timeout     = wait <= 0 ? 0 : (wait >= INT_MAX ? INT_MAX : (int)wait + 1);
+   }
+
+   struct epoll_event events[OPTION_EVENT_LOOP_BATCH];
+   int count = epoll_wait(loop->epoll_fd, events, OPTION_EVENT_LOOP_BATCH, timeout);
+
+   for(int i = 0; i < count; i++){
+      Waiter *waiter = (Waiter*)events[i].data.ptr;
+
+      /* closed during this turn, it waits in the timers now */
+      if(waiter->kind == WAIT_TIMER){
+         continue;
+      }
+
+      disarm(loop, waiter);
+
+      if(complete(loop, waiter) && !wake(vm, waiter)){
+         return false;
+      }
+   }
+
+   uint64_t last = loop->sequence;
+   double now    = now_ms();
+
+   while(loop->timer_count > 0 && loop->timers[0]->deadline <= now && loop->timers[0]->sequence < last){
+      Waiter *waiter = pop_timer(loop);
+
+      if(complete(loop, waiter) && !wake(vm, waiter)){
+         return false;
+      }
+   }
+
+   return true;
+}
+
+/* Runs the operation as far as it goes without blocking.
+ * True when it finished and result is set, false when it waits again.
+ */
+
+static bool complete(EventLoop *loop, Waiter *waiter){
+   switch(waiter->kind){
+      case WAIT_TIMER:
+         return true;
+
+      case WAIT_FILE_CHUNK:
+      case WAIT_FILE:
+         for(;;){
+            if(!reserve(waiter, OPTION_READ_CHUNK)){
+               return fail(waiter, true);
+            }
+
+            ssize_t count = read(waiter->fd, waiter->buffer + waiter->length, OPTION_READ_CHUNK);
+
+            if(count > 0){
+               waiter->length += (int32_t)count;
+
+               /* a short read is most likely the end, checked right away */
+               if(waiter->kind == WAIT_FILE_CHUNK && count == OPTION_READ_CHUNK){
+                  push_timer(loop, waiter, now_ms());
+                  return false;
+               }
+
+               continue;
+            }
+
+            if(count == 0){
+               waiter->result = ant_value.from_object(ant_string.as_object(ant_string.new(waiter->buffer, waiter->length)));
+               close(waiter->fd);
+               return true;
+            }
+
+            if(errno == EINTR){
+               continue;
+            }
+
+            if(errno == EAGAIN && waiter->kind == WAIT_FILE && arm(loop, waiter, EPOLLIN)){
+               return false;
+            }
+
+            return fail(waiter, true);
+         }
+
+      case WAIT_READ:
+         for(;;){
+            if(!reserve(waiter, OPTION_READ_CHUNK)){
+               return fail(waiter, false);
+            }
+
+            ssize_t count = read(waiter->fd, waiter->buffer, OPTION_READ_CHUNK);
+
+            if(count >= 0){
+               waiter->result = ant_value.from_object(ant_string.as_object(ant_string.new(waiter->buffer, (int32_t)count)));
+               return true;
+            }
+
+            if(errno == EINTR){
+               continue;
+            }
+
+            if(errno == EAGAIN && arm(loop, waiter, EPOLLIN)){
+               return false;
+            }
+
+            return fail(waiter, false);
+         }
+
+      case WAIT_WRITE:
+         while(waiter->written < waiter->data->length){
+            ssize_t count = send(waiter->fd, waiter->data->chars + waiter->written,
+                                 waiter->data->length - waiter->written, MSG_NOSIGNAL);
+
+            if(count >= 0){
+               waiter->written += (int32_t)count;
+               continue;
+            }
+
+            if(errno == EINTR){
+               continue;
+            }
+
+            if(errno == EAGAIN && arm(loop, waiter, EPOLLOUT)){
+               return false;
+            }
+
+            return fail(waiter, false);
+         }
+
+         waiter->result = ant_value.from_number(waiter->written);
+         return true;
+
+      case WAIT_CONNECT: {
+         int error         = 0;
+         socklen_t length  = sizeof(error);
+
+         if(getsockopt(waiter->fd, SOL_SOCKET, SO_ERROR, &error, &length) != 0 || error != 0){
+            return fail(waiter, true);
+         }
+
+         waiter->result = ant_value.from_number(waiter->fd);
+         return true;
+      }
+   }
+
+   return fail(waiter, false);
+}
+
+/* */
+
+static bool wake(VM *vm, Waiter *waiter){
+   ObjectFiber *fiber = waiter->fiber;
+
+   if(fiber == vm->root){
+      waiter->done = true;
+      return true;
+   }
+
+   Value result = waiter->result;
+   free_waiter(waiter);
+
+   if(fiber == NULL){
+      return true;
+   }
+
+   /* spawned fibers are parked before they ever ran */
+   fiber->state = fiber->frame_count == 0 ? FIBER_NEW : FIBER_SUSPENDED;
+   return ant_vm.run_fiber(vm, fiber, result) == INTERPRET_OK;
+}
+
+/* */
+
+static bool arm(EventLoop *loop, Waiter *waiter, uint32_t events){
+   struct epoll_event event;
+   event.events   = events;
+   event.data.ptr = waiter;
+
+   if(epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, waiter->fd, &event) != 0){
+      return false;
+   }
+
+   waiter->prev = NULL;
+   waiter->next = loop->io;
+
+   if(loop->io != NULL){
+      loop->io->prev = waiter;
+   }
+
+   loop->io = waiter;
+   return true;
+}
+
+/* */
+
+static void disarm(EventLoop *loop, Waiter *waiter){
+   epoll_ctl(loop->epoll_fd, EPOLL_CTL_DEL, waiter->fd, NULL);
+
+   if(waiter->prev != NULL){
+      waiter->prev->next = waiter->next;
+   } else {
+      loop->io = waiter->next;
+   }
+
+   if(waiter->next != NULL){
+      waiter->next->prev = waiter->prev;
+   }
+
+   waiter->prev = NULL;
+   waiter->next = NULL;
+}
+
+/* */
+
+static void push_timer(EventLoop *loop, Waiter *waiter, double deadline){
+   waiter->deadline = deadline;
+   waiter->sequence = loop->sequence++;
+
+   if(loop->timer_count == loop->timer_capacity){
+      int32_t old_capacity = loop->timer_capacity;
+      loop->timer_capacity = GROW_CAPACITY(old_capacity);
+      loop->timers         = GROW_ARRAY(Waiter*, loop->timers, old_capacity, loop->timer_capacity);
+   }
+
+   int32_t at = loop->timer_count++;
+
+   while(at > 0 && BEFORE(waiter, loop->timers[(at - 1) / 2])){
+      loop->timers[at] = loop->timers[(at - 1) / 2];
+      at               = (at - 1) / 2;
+   }
+
+   loop->timers[at] = waiter;
+}
+
+/* */
+
+static Waiter *pop_timer(EventLoop *loop){
+   Waiter *first = loop->timers[0];
+   Waiter *last  = loop->timers[--loop->timer_count];
+   int32_t at    = 0;
+
+   for(;;){
+      int32_t child = at * 2 + 1;
+
+      if(child >= loop->timer_count){
+         break;
+      }
+
+      if(child + 1 < loop->timer_count && BEFORE(loop->timers[child + 1], loop->timers[child])){
+         child++;
+      }
+
+      if(!BEFORE(loop->timers[child], last)){
+         break;
+      }
+
+      loop->timers[at] = loop->timers[child];
+      at               = child;
+   }
+
+   loop->timers[at] = last;
+   return first;
+}
+
+/* */
+
+static bool reserve(Waiter *waiter, int32_t extra){
+   if(waiter->length > INT32_MAX - extra){
+      return false;
+   }
+
+   if(waiter->length + extra <= waiter->capacity){
+      return true;
+   }
+
+   int32_t old_capacity = waiter->capacity;
+
+   while(waiter->capacity < waiter->length + extra){
+      waiter->capacity = waiter->capacity > INT32_MAX / 2 ? INT32_MAX : GROW_CAPACITY(waiter->capacity);
+   }
+
+   waiter->buffer = GROW_ARRAY(char, waiter->buffer, old_capacity, waiter->capacity);
+   return true;
+}
+
+/* ends the operation with nil, closing the fd when the operation opened it */
+
+static bool fail(Waiter *waiter, bool owns_fd){
+   if(owns_fd){
+      close(waiter->fd);
+   }
+
+   waiter->result = ant_value.make_nil();
+   return true;
+}
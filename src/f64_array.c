@@ -0,0 +1,54 @@
+#include "f64_array.h"
+#include "memory.h"
+#include <stdio.h>
+#include <string.h>
+
+static ObjectF64Array*  new_f64_array(int32_t length);
+static ObjectF64Array*  f64_array_from_value(Value value);
+static Object*          f64_array_as_object(ObjectF64Array *array);
+static int32_t          print_f64_array(ObjectF64Array *array);
+
+const F64ArrayAPI ant_f64_array = {
+   .new = new_f64_array,
+   .from_value = f64_array_from_value,
+   .as_object = f64_array_as_object,
+   .print = print_f64_array,
+};
+
+/* zero initialized */
+
+static ObjectF64Array *new_f64_array(int32_t length){
+   ObjectF64Array *array = (ObjectF64Array*)ant_object.allocate(sizeof(ObjectF64Array), OBJ_F64ARRAY);
+   array->length         = length;
+   array->values         = length > 0 ? ALLOCATE(double, length) : NULL;
+
+   if(length > 0){
+      memset(array->values, 0, sizeof(double) * length);
+   }
+
+   return array;
+}
+
+/* */
+
+static ObjectF64Array *f64_array_from_value(Value value){
+  return (ObjectF64Array*)ant_value.as_object(value);
+}
+
+/* */
+
+static Object *f64_array_as_object(ObjectF64Array *array){
+  return (Object*)array;
+}
+
+/* */
+
+static int32_t print_f64_array(ObjectF64Array *array){
+   int32_t print_len = printf("f64[");
+
+   for(int32_t i = 0; i < array->length; i++){
+      print_len += printf(i < array->length - 1 ? "%g, " : "%g", array->values[i]);
+   }
+
+   return print_len + printf("]");
+}
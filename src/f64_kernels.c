@@ -0,0 +1,312 @@
+#include "f64_kernels.h"
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define ANT_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+static void        detect_kernels(void);
+static void        select_kernels(void);
+static const char* kernels_name(void);
+
+/* scalar kernels, always available */
+static double scalar_sum(const double *x, int32_t n);
+static double scalar_dot(const double *x, const double *y, int32_t n);
+static double scalar_min(const double *x, int32_t n);
+static double scalar_max(const double *x, int32_t n);
+static void   scalar_scale(double *x, double k, int32_t n);
+static void   scalar_axpy(double a, const double *x, double *y, int32_t n);
+static void   scalar_add(const double *a, const double *b, double *out, int32_t n);
+static void   scalar_sub(const double *a, const double *b, double *out, int32_t n);
+static void   scalar_mul(const double *a, const double *b, double *out, int32_t n);
+static void   scalar_div(const double *a, const double *b, double *out, int32_t n);
+
+F64KernelAPI ant_f64_kernels = {
+   .detect = detect_kernels,
+   .name = kernels_name,
+   .sum = scalar_sum,
+   .dot = scalar_dot,
+   .min = scalar_min,
+   .max = scalar_max,
+   .scale = scalar_scale,
+   .axpy = scalar_axpy,
+   .add = scalar_add,
+   .sub = scalar_sub,
+   .mul = scalar_mul,
+   .div = scalar_div,
+};
+
+static const char *selected_kernels = "scalar";
+
+#define USE_KERNELS(prefix)                   \
+  do {                                        \
+    ant_f64_kernels.sum   = prefix##_sum;     \
+    ant_f64_kernels.dot   = prefix##_dot;     \
+    ant_f64_kernels.min   = prefix##_min;     \
+    ant_f64_kernels.max   = prefix##_max;     \
+    ant_f64_kernels.scale = prefix##_scale;   \
+    ant_f64_kernels.axpy  = prefix##_axpy;    \
+    ant_f64_kernels.add   = prefix##_add;     \
+    ant_f64_kernels.sub   = prefix##_sub;     \
+    ant_f64_kernels.mul   = prefix##_mul;     \
+    ant_f64_kernels.div   = prefix##_div;     \
+    selected_kernels      = #prefix;          \
+  } while (false)
+
+/* Scalar */
+
+static double scalar_sum(const double *x, int32_t n){
+   double sum = 0;
+   for(int32_t i = 0; i < n; i++) sum += x[i];
+   return sum;
+}
+
+static double scalar_dot(const double *x, const double *y, int32_t n){
+   double sum = 0;
+   for(int32_t i = 0; i < n; i++) sum += x[i] * y[i];
+   return sum;
+}
+
+static double scalar_min(const double *x, int32_t n){
+   double min = x[0];
+   for(int32_t i = 1; i < n; i++) min = x[i] < min ? x[i] : min;
+   return min;
+}
+
+static double scalar_max(const double *x, int32_t n){
+   double max = x[0];
+   for(int32_t i = 1; i < n; i++) max = x[i] > max ? x[i] : max;
+   return max;
+}
+
+static void scalar_scale(double *x, double k, int32_t n){
+   for(int32_t i = 0; i < n; i++) x[i] *= k;
+}
+
+static void scalar_axpy(double a, const double *x, double *y, int32_t n){
+   for(int32_t i = 0; i < n; i++) y[i] += a * x[i];
+}
+
+#define SCALAR_ELEMENTWISE(name, op)                                          \
+  static void name(const double *a, const double *b, double *out, int32_t n){ \
+    for (int32_t i = 0; i < n; i++) out[i] = a[i] op b[i];                    \
+  }
+
+SCALAR_ELEMENTWISE(scalar_add, +)
+SCALAR_ELEMENTWISE(scalar_sub, -)
+SCALAR_ELEMENTWISE(scalar_mul, *)
+SCALAR_ELEMENTWISE(scalar_div, /)
+
+/* SSE2: 2 doubles per register. Baseline on x86_64 */
+
+#if defined(ANT_KERNELS_X86) && defined(__SSE2__)
+#define ANT_KERNELS_SSE2
+
+static double sse2_hsum(__m128d v){
+   double lanes[2];
+   _mm_storeu_pd(lanes, v);
+   return lanes[0] + lanes[1];
+}
+
+static double sse2_sum(const double *x, int32_t n){
+   __m128d acc0 = _mm_setzero_pd();
+   __m128d acc1 = _mm_setzero_pd();
+   int32_t i    = 0;
+
+   /* two accumulators to hide the add latency */
+   for(; i + 4 <= n; i += 4){
+      acc0 = _mm_add_pd(acc0, _mm_loadu_pd(x + i));
+      acc1 = _mm_add_pd(acc1, _mm_loadu_pd(x + i + 2));
+   }
+
+   double sum = sse2_hsum(_mm_add_pd(acc0, acc1));
+   for(; i < n; i++) sum += x[i];
+   return sum;
+}
+
+static double sse2_dot(const double *x, const double *y, int32_t n){
+   __m128d acc0 = _mm_setzero_pd();
+   __m128d acc1 = _mm_setzero_pd();
+   int32_t i    = 0;
+
+   for(; i + 4 <= n; i += 4){
+      acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(x + i), _mm_loadu_pd(y + i)));
+      acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(x + i + 2), _mm_loadu_pd(y + i + 2)));
+   }
+
+   double sum = sse2_hsum(_mm_add_pd(acc0, acc1));
+   for(; i < n; i++) sum += x[i] * y[i];
+   return sum;
+}
+
+#define SSE2_REDUCE(name, intrinsic, cmp)                                \
+  static double name(const double *x, int32_t n){                       \
+    __m128d acc = _mm_set1_pd(x[0]);                                     \
+    int32_t i   = 0;                                                     \
+    for (; i + 2 <= n; i += 2) acc = intrinsic(acc, _mm_loadu_pd(x + i)); \
+    double lanes[2];                                                     \
+    _mm_storeu_pd(lanes, acc);                                           \
+    double result = lanes[0] cmp lanes[1] ? lanes[0] : lanes[1];         \
+    for (; i < n; i++) result = x[i] cmp result ? x[i] : result;         \
+    return result;                                                       \
+  }
+
+SSE2_REDUCE(sse2_min, _mm_min_pd, <)
+SSE2_REDUCE(sse2_max, _mm_max_pd, >)
+
+static void sse2_scale(double *x, double k, int32_t n){
+   __m128d vk = _mm_set1_pd(k);
+   int32_t i  = 0;
+
+   for(; i + 2 <= n; i += 2) _mm_storeu_pd(x + i, _mm_mul_pd(_mm_loadu_pd(x + i), vk));
+   for(; i < n; i++) x[i] *= k;
+}
+
+static void sse2_axpy(double a, const double *x, double *y, int32_t n){
+   __m128d va = _mm_set1_pd(a);
+   int32_t i  = 0;
+
+   for(; i + 2 <= n; i += 2){
+      __m128d product = _mm_mul_pd(va, _mm_loadu_pd(x + i));
+      _mm_storeu_pd(y + i, _mm_add_pd(_mm_loadu_pd(y + i), product));
+   }
+   for(; i < n; i++) y[i] += a * x[i];
+}
+
+#define SSE2_ELEMENTWISE(name, intrinsic, op)                                                  \
+  static void name(const double *a, const double *b, double *out, int32_t n){                  \
+    int32_t i = 0;                                                                             \
+    for (; i + 2 <= n; i += 2)                                                                 \
+      _mm_storeu_pd(out + i, intrinsic(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));             \
+    for (; i < n; i++) out[i] = a[i] op b[i];                                                  \
+  }
+
+SSE2_ELEMENTWISE(sse2_add, _mm_add_pd, +)
+SSE2_ELEMENTWISE(sse2_sub, _mm_sub_pd, -)
+SSE2_ELEMENTWISE(sse2_mul, _mm_mul_pd, *)
+SSE2_ELEMENTWISE(sse2_div, _mm_div_pd, /)
+
+#endif // SSE2
+
+/* AVX2: 4 doubles per register. Compiled for the avx2 target and only selected at runtime */
+
+#if defined(ANT_KERNELS_X86) && (defined(__GNUC__) || defined(__clang__))
+#define ANT_KERNELS_AVX2
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+AVX2_TARGET static double avx2_hsum(__m256d v){
+   __m128d half = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+   double lanes[2];
+   _mm_storeu_pd(lanes, half);
+   return lanes[0] + lanes[1];
+}
+
+AVX2_TARGET static double avx2_sum(const double *x, int32_t n){
+   __m256d acc0 = _mm256_setzero_pd();
+   __m256d acc1 = _mm256_setzero_pd();
+   int32_t i    = 0;
+
+   for(; i + 8 <= n; i += 8){
+      acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(x + i));
+      acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(x + i + 4));
+   }
+
+   double sum = avx2_hsum(_mm256_add_pd(acc0, acc1));
+   for(; i < n; i++) sum += x[i];
+   return sum;
+}
+
+AVX2_TARGET static double avx2_dot(const double *x, const double *y, int32_t n){
+   __m256d acc0 = _mm256_setzero_pd();
+   __m256d acc1 = _mm256_setzero_pd();
+   int32_t i    = 0;
+
+   for(; i + 8 <= n; i += 8){
+      acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+      acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4)));
+   }
+
+   double sum = avx2_hsum(_mm256_add_pd(acc0, acc1));
+   for(; i < n; i++) sum += x[i] * y[i];
+   return sum;
+}
+
+#define AVX2_REDUCE(name, intrinsic, cmp)                                      \
+  AVX2_TARGET static double name(const double *x, int32_t n){                  \
+    __m256d acc = _mm256_set1_pd(x[0]);                                         \
+    int32_t i   = 0;                                                            \
+    for (; i + 4 <= n; i += 4) acc = intrinsic(acc, _mm256_loadu_pd(x + i));    \
+    double lanes[4];                                                            \
+    _mm256_storeu_pd(lanes, acc);                                               \
+    double result = lanes[0];                                                   \
+    for (int32_t l = 1; l < 4; l++) result = lanes[l] cmp result ? lanes[l] : result; \
+    for (; i < n; i++) result = x[i] cmp result ? x[i] : result;                \
+    return result;                                                              \
+  }
+
+AVX2_REDUCE(avx2_min, _mm256_min_pd, <)
+AVX2_REDUCE(avx2_max, _mm256_max_pd, >)
+
+AVX2_TARGET static void avx2_scale(double *x, double k, int32_t n){
+   __m256d vk = _mm256_set1_pd(k);
+   int32_t i  = 0;
+
+   for(; i + 4 <= n; i += 4) _mm256_storeu_pd(x + i, _mm256_mul_pd(_mm256_loadu_pd(x + i), vk));
+   for(; i < n; i++) x[i] *= k;
+}
+
+AVX2_TARGET static void avx2_axpy(double a, const double *x, double *y, int32_t n){
+   __m256d va = _mm256_set1_pd(a);
+   int32_t i  = 0;
+
+   for(; i + 4 <= n; i += 4){
+      __m256d product = _mm256_mul_pd(va, _mm256_loadu_pd(x + i));
+      _mm256_storeu_pd(y + i, _mm256_add_pd(_mm256_loadu_pd(y + i), product));
+   }
+   for(; i < n; i++) y[i] += a * x[i];
+}
+
+#define AVX2_ELEMENTWISE(name, intrinsic, op)                                                  \
+  AVX2_TARGET static void name(const double *a, const double *b, double *out, int32_t n){      \
+    int32_t i = 0;                                                                             \
+    for (; i + 4 <= n; i += 4)                                                                 \
+      _mm256_storeu_pd(out + i, intrinsic(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));   \
+    for (; i < n; i++) out[i] = a[i] op b[i];                                                  \
+  }
+
+AVX2_ELEMENTWISE(avx2_add, _mm256_add_pd, +)
+AVX2_ELEMENTWISE(avx2_sub, _mm256_sub_pd, -)
+AVX2_ELEMENTWISE(avx2_mul, _mm256_mul_pd, *)
+AVX2_ELEMENTWISE(avx2_div, _mm256_div_pd, /)
+
+#endif // AVX2
+
+/* every VM calls detect, possibly from different threads */
+
+static void detect_kernels(void){
+   static pthread_once_t once = PTHREAD_ONCE_INIT;
+   pthread_once(&once, select_kernels);
+}
+
+/* */
+
+static void select_kernels(void){
+
+#ifdef ANT_KERNELS_AVX2
+   __builtin_cpu_init();
+
+   if(__builtin_cpu_supports("avx2")){
+      USE_KERNELS(avx2);
+      return;
+   }
+#endif
+
+#ifdef ANT_KERNELS_SSE2
+   USE_KERNELS(sse2);
+#endif
+}
+
+static const char *kernels_name(void){
+   return selected_kernels;
+}
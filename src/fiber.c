@@ -0,0 +1,217 @@
+#include "fiber.h"
+#include "memory.h"
+#include "vm.h"
+#include "trace.h"
+#include "perf.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+static ObjectFiber*  new_fiber(ObjectClosure *closure);
+static ObjectFiber*  fiber_from_value(Value value);
+static Object*       fiber_as_object(ObjectFiber *fiber);
+static bool          resume_fiber(VM *vm, ObjectFiber *fiber, Value value);
+static bool          yield_fiber(VM *vm, Value value);
+static void          wait_fiber(VM *vm);
+static void          finish_fiber(VM *vm, Value result);
+static void          unwind_fibers(VM *vm);
+static void          release_fiber(ObjectFiber *fiber);
+static int32_t       print_fiber(ObjectFiber *fiber);
+
+const FiberAPI ant_fiber = {
+   .new = new_fiber,
+   .from_value = fiber_from_value,
+   .as_object = fiber_as_object,
+   .resume = resume_fiber,
+   .yield = yield_fiber,
+   .wait = wait_fiber,
+   .finish = finish_fiber,
+   .unwind = unwind_fibers,
+   .release = release_fiber,
+   .print = print_fiber,
+};
+
+/* Private */
+static void suspend(VM *vm, FiberState state, Value value);
+static void switch_to(VM *vm, ObjectFiber *fiber);
+
+/* Implementation */
+
+static ObjectFiber *new_fiber(ObjectClosure *closure){
+   ObjectFiber *fiber = (ObjectFiber*)ant_object.allocate(sizeof(ObjectFiber), OBJ_FIBER);
+   bool is_root       = closure == NULL;
+
+   fiber->closure            = closure;
+   fiber->frame_max          = OPTION_FRAMES_MAX;
+   fiber->frames             = ALLOCATE(CallFrame, fiber->frame_max);
+   fiber->frame_count        = 0;
+   fiber->open_upvalues.head = NULL;
+   fiber->caller             = NULL;
+   fiber->state              = is_root ? FIBER_RUNNING : FIBER_NEW;
+
+   /* as deep as the root, generators and event loop tasks recurse like any code. The pages of
+    * the stack are only touched as it grows */
+   init_stack(&fiber->stack, OPTION_STACK_MAX);
+   return fiber;
+}
+
+/* */
+
+static ObjectFiber *fiber_from_value(Value value){
+   return (ObjectFiber*)ant_value.as_object(value);
+}
+
+/* */
+
+static Object *fiber_as_object(ObjectFiber *fiber){
+   return (Object*)fiber;
+}
+
+/* a new fiber starts like a call, with the closure in slot 0 and its argument above */
+
+static bool resume_fiber(VM *vm, ObjectFiber *fiber, Value value){
+
+   if(fiber->state == FIBER_RUNNING){
+      ant_vm.runtime_error(vm, "Cannot resume a running fiber");
+      return false;
+   }
+
+   if(fiber->state == FIBER_DONE){
+      ant_vm.runtime_error(vm, "Cannot resume a finished fiber");
+      return false;
+   }
+
+   if(fiber->state == FIBER_WAITING){
+      ant_vm.runtime_error(vm, "Cannot resume a fiber waiting on the event loop");
+      return false;
+   }
+
+   fiber->caller = vm->fiber;
+   switch_to(vm, fiber);
+
+   Stack *stack = vm->stack;
+
+   if(fiber->state == FIBER_NEW){
+      ObjectFunction *func = fiber->closure->func;
+      STACK_PUSH(VALUE_FROM_OBJECT(CLOSURE_AS_OBJECT(fiber->closure)));
+
+      if(func->arity == 1){
+         STACK_PUSH(value);
+      }
+
+      CallFrame *frame = vm->frames;
+      frame->closure   = fiber->closure;
+      frame->ip        = func->chunk.code;
+      frame->slots     = stack->slots;
+      vm->frame_count  = 1;
+
+      TRACE_ENTER(fiber, TRACE_FUNCTION_NAME(func));
+      PERF_SYNC(vm, true);
+
+   } else {
+      /* result of the yield() it is suspended in */
+      STACK_PEEK(0) = value;
+   }
+
+   fiber->state = FIBER_RUNNING;
+   return true;
+}
+
+/* */
+
+static bool yield_fiber(VM *vm, Value value){
+
+   if(vm->fiber->caller == NULL){
+      ant_vm.runtime_error(vm, "Can only yield from a fiber");
+      return false;
+   }
+
+   suspend(vm, FIBER_SUSPENDED, value);
+   return true;
+}
+
+/* */
+
+static void wait_fiber(VM *vm){
+   suspend(vm, FIBER_WAITING, ant_value.make_nil());
+}
+
+/* the fiber function closed its upvalues on return, nothing points into the stack anymore */
+
+static void finish_fiber(VM *vm, Value result){
+   ObjectFiber *fiber  = vm->fiber;
+   ObjectFiber *caller = fiber->caller;
+
+   fiber->caller = NULL;
+   fiber->state  = FIBER_DONE;
+   switch_to(vm, caller);
+   release_fiber(fiber);
+
+   Stack *stack  = vm->stack;
+   STACK_PEEK(0) = result;
+}
+
+/* closures can outlive the dropped fibers, so their upvalues are closed first */
+
+static void unwind_fibers(VM *vm){
+   while(vm->fiber->caller != NULL){
+      ObjectFiber *fiber  = vm->fiber;
+      ObjectFiber *caller = fiber->caller;
+
+      ant_upvalues.close(&vm->open_upvalues, fiber->stack.slots);
+
+      fiber->caller = NULL;
+      fiber->state  = FIBER_DONE;
+      switch_to(vm, caller);
+      release_fiber(fiber);
+   }
+}
+
+/* */
+
+static void release_fiber(ObjectFiber *fiber){
+   free_stack(&fiber->stack);
+   FREE_ARRAY(CallFrame, fiber->frames, fiber->frame_max);
+
+   fiber->frames             = NULL;
+   fiber->frame_max          = 0;
+   fiber->frame_count        = 0;
+   fiber->open_upvalues.head = NULL;
+}
+
+/* */
+
+static int32_t print_fiber(ObjectFiber *fiber){
+   (void)fiber;
+   return printf("<fiber>");
+}
+
+/* Private */
+
+static void suspend(VM *vm, FiberState state, Value value){
+   ObjectFiber *fiber  = vm->fiber;
+   ObjectFiber *caller = fiber->caller;
+
+   fiber->caller = NULL;
+   fiber->state  = state;
+   switch_to(vm, caller);
+
+   /* result of the resume() the caller is waiting in */
+   Stack *stack  = vm->stack;
+   STACK_PEEK(0) = value;
+}
+
+/* */
+
+/* the frame count and open upvalues are hot in the VM, the rest is a pointer swap */
+
+static void switch_to(VM *vm, ObjectFiber *fiber){
+   ObjectFiber *current   = vm->fiber;
+   current->frame_count   = vm->frame_count;
+   current->open_upvalues = vm->open_upvalues;
+
+   vm->fiber         = fiber;
+   vm->stack         = &fiber->stack;
+   vm->frames        = fiber->frames;
+   vm->frame_count   = fiber->frame_count;
+   vm->open_upvalues = fiber->open_upvalues;
+}
@@ -0,0 +1,723 @@
+#include "image.h"
+#include "bytes.h"
+#include "chunk.h"
+#include "closure.h"
+#include "config.h"
+#include "context.h"
+#include "f64_array.h"
+#include "functions.h"
+#include "list.h"
+#include "map.h"
+#include "memory.h"
+#include "natives.h"
+#include "strings.h"
+#include "table.h"
+#include "upvalues.h"
+#include "utils.h"
+#include "var_mapping.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+
+/* bump when the layout below changes */
+#define IMAGE_VERSION 2
+#define IMAGE_NO_NAME UINT32_MAX
+
+/* Layout, see bytes.h for the encoding.
+ *
+ *   header     ImageHeader, with the object count of each section
+ *   strings    (length, chars)
+ *   functions  arity, upvalue_count, name or NO_NAME, code count, code, line bytes count,
+ *              encoded runs, checkpoint count, LineCheckpoint[], constant count, values
+ *   f64arrays  (length, doubles)
+ *   closures   function, upvalue count, upvalues
+ *   upvalues   closed value
+ *   lists      (count, values)
+ *   maps       (count, key value pairs)
+ *   mapping    string per global name
+ *   globals    value per global
+ *
+ * Object numbers run through the sections in ImageSection order, which is not the file order:
+ * the file is ordered so every object exists before a reference to it is read.
+ */
+
+typedef enum {
+   IMAGE_STRINGS,
+   IMAGE_FUNCTIONS,
+   IMAGE_UPVALUES,
+   IMAGE_CLOSURES,
+   IMAGE_LISTS,
+   IMAGE_F64ARRAYS,
+   IMAGE_MAPS,
+   IMAGE_SECTION_COUNT,
+}ImageSection;
+
+typedef enum {
+   IMAGE_VALUE_NIL,
+   IMAGE_VALUE_TRUE,
+   IMAGE_VALUE_FALSE,
+   IMAGE_VALUE_UNDEFINED,
+   IMAGE_VALUE_NUMBER,
+   IMAGE_VALUE_OBJECT,
+   IMAGE_VALUE_NATIVE,
+}ImageValue;
+
+typedef struct {
+   char     magic[4];
+   uint32_t version;
+   uint32_t ant_version;
+   uint32_t opcode_count;
+   uint32_t native_count;
+   uint32_t counts[IMAGE_SECTION_COUNT];
+   uint32_t mapping_count;
+   uint32_t global_count;
+}ImageHeader;
+
+struct HeapImage {
+   MappedFile mapped;
+};
+
+typedef struct {
+   ByteWriter bytes;
+   Table numbers;   /* object -> object number */
+}ImageWriter;
+
+typedef struct {
+   ByteReader bytes;
+   Object **objects;
+   int32_t first[IMAGE_SECTION_COUNT + 1];   /* object number of the first object in each section */
+   Value *natives;
+   int32_t native_count;
+}ImageReader;
+
+static bool       snapshot(VM *vm, const char *path);
+static HeapImage *restore(VM *vm, const char *path);
+static void       close_image(HeapImage *image);
+
+const HeapImageAPI ant_image = {
+   .snapshot = snapshot,
+   .restore = restore,
+   .close = close_image,
+};
+
+/* Private */
+static ImageHeader  make_header(VM *vm);
+static int32_t      section_of(Object *object);
+static void         write_value(ImageWriter *writer, Value value);
+static void         write_reference(ImageWriter *writer, Object *object);
+static void         write_object(ImageWriter *writer, Object *object);
+static bool         read_objects(ImageReader *reader, const ImageHeader *header);
+static bool         read_globals(ImageReader *reader, VM *vm, const ImageHeader *header);
+static void         read_function(ImageReader *reader, ObjectFunction *func);
+static Value        read_value(ImageReader *reader);
+static Object      *read_reference(ImageReader *reader, ImageSection section);
+
+/* Implementation */
+
+static bool snapshot(VM *vm, const char *path){
+   if(vm->frame_count != 0 || vm->context->parent != NULL){
+      return false;
+   }
+
+   ant_context.make_current(vm->context);
+
+   ImageWriter writer;
+   ant_bytes.init_writer(&writer.bytes);
+   ant_table.init(&writer.numbers);
+
+   /* number the objects, section by section */
+   ValueArray sections[IMAGE_SECTION_COUNT];
+
+   for(int32_t i = 0; i < IMAGE_SECTION_COUNT; i++){
+      ant_value_array.init(&sections[i]);
+   }
+
+   for(Object *object = vm->context->garbage.objects; object != NULL; object = object->next){
+      int32_t section = section_of(object);
+
+      if(section >= 0){
+         ant_value_array.write(&sections[section], VALUE_FROM_OBJECT(object));
+      }
+   }
+
+   int32_t number = 0;
+
+   for(int32_t i = 0; i < IMAGE_SECTION_COUNT; i++){
+      for(int32_t j = 0; j < sections[i].count; j++){
+         ant_table.set_value(&writer.numbers, sections[i].values[j], VALUE_FROM_NUMBER(number++));
+      }
+   }
+
+   ImageHeader header = make_header(vm);
+
+   for(int32_t i = 0; i < IMAGE_SECTION_COUNT; i++){
+      header.counts[i] = (uint32_t)sections[i].count;
+   }
+
+   ant_bytes.write(&writer.bytes, &header, sizeof(ImageHeader));
+
+   const ImageSection file_order[] = {
+      IMAGE_STRINGS, IMAGE_FUNCTIONS, IMAGE_F64ARRAYS, IMAGE_CLOSURES, IMAGE_UPVALUES, IMAGE_LISTS, IMAGE_MAPS,
+   };
+
+   for(size_t i = 0; i < sizeof(file_order) / sizeof(file_order[0]); i++){
+      ValueArray *section = &sections[file_order[i]];
+
+      for(int32_t j = 0; j < section->count; j++){
+         write_object(&writer, VALUE_AS_OBJECT(section->values[j]));
+      }
+   }
+
+   VarMapping *mapping = &vm->context->mapping;
+
+   for(int32_t i = 0; i < mapping->count; i++){
+      write_reference(&writer, VALUE_AS_OBJECT(mapping->reverse_lookup.values[i]));
+   }
+
+   for(int32_t i = 0; i < vm->globals.count; i++){
+      write_value(&writer, vm->globals.values[i]);
+   }
+
+   bool saved = ant_bytes.save(&writer.bytes, path);
+
+   for(int32_t i = 0; i < IMAGE_SECTION_COUNT; i++){
+      ant_value_array.free(&sections[i]);
+   }
+
+   ant_table.free(&writer.numbers);
+   ant_bytes.free_writer(&writer.bytes);
+   return saved;
+}
+
+/* Nothing in the VM changes until the whole image was read,
+ * a failure releases the objects allocated so far.
+ */
+
+static HeapImage *restore(VM *vm, const char *path){
+   if(vm->globals.count != vm->native_count || vm->context->mapping.count != vm->native_count){
+      return NULL;
+   }
+
+   MappedFile mapped;
+
+   if(!ant_bytes.map(path, sizeof(ImageHeader), &mapped)){
+      return NULL;
+   }
+
+   ImageReader reader;
+   ant_bytes.init_reader(&reader.bytes, &mapped);
+
+   ImageHeader header;
+   memcpy(&header, ant_bytes.read(&reader.bytes, sizeof(ImageHeader)), sizeof(ImageHeader));
+
+   ImageHeader expected = make_header(vm);
+   memcpy(expected.counts, header.counts, sizeof(header.counts));
+   expected.mapping_count = header.mapping_count;
+   expected.global_count  = header.global_count;
+
+   if(memcmp(&header, &expected, sizeof(ImageHeader)) != 0){
+      ant_bytes.unmap(&mapped);
+      return NULL;
+   }
+
+   ant_context.make_current(vm->context);
+   Object *mark = ant_context.mark(vm->context);
+
+   bool restored = read_objects(&reader, &header) && read_globals(&reader, vm, &header);
+
+   FREE_ARRAY(Object*, reader.objects, reader.first[IMAGE_SECTION_COUNT]);
+
+   if(!restored){
+      ant_context.release(vm->context, mark);
+      ant_bytes.unmap(&mapped);
+      return NULL;
+   }
+
+   HeapImage *image = ALLOCATE(HeapImage, 1);
+   image->mapped    = mapped;
+   return image;
+}
+
+/* */
+
+static void close_image(HeapImage *image){
+   if(image == NULL){
+      return;
+   }
+
+   ant_bytes.unmap(&image->mapped);
+   FREE(HeapImage, image);
+}
+
+/* Private */
+
+static ImageHeader make_header(VM *vm){
+   ImageHeader header;
+   memset(&header, 0, sizeof(ImageHeader));
+
+   memcpy(header.magic, "ANTI", sizeof(header.magic));
+   header.version       = IMAGE_VERSION;
+   header.ant_version   = ant_utils.hash(ANT_VERSION, (int32_t)strlen(ANT_VERSION));
+   header.opcode_count  = OP_CONSTANT_LONG + 1;
+   header.native_count  = (uint32_t)vm->native_count;
+   header.mapping_count = (uint32_t)vm->context->mapping.count;
+   header.global_count  = (uint32_t)vm->globals.count;
+   return header;
+}
+
+/* natives are written by position and never numbered.
+ * Fibers own a stack and channels are shared with other threads, neither is written,
+ * a value holding one fails the snapshot, see write_reference */
+
+static int32_t section_of(Object *object){
+   switch(object->type){
+      case OBJ_STRING:   return IMAGE_STRINGS;
+      case OBJ_FUNCTION: return IMAGE_FUNCTIONS;
+      case OBJ_UPVALUE:  return IMAGE_UPVALUES;
+      case OBJ_CLOSURE:  return IMAGE_CLOSURES;
+      case OBJ_LIST:     return IMAGE_LISTS;
+      case OBJ_F64ARRAY: return IMAGE_F64ARRAYS;
+      case OBJ_MAP:      return IMAGE_MAPS;
+      case OBJ_NATIVE:   return -1;
+      case OBJ_FIBER:    return -1;
+      case OBJ_CHANNEL:  return -1;
+   }
+
+   return -1;
+}
+
+/* */
+
+static void write_value(ImageWriter *writer, Value value){
+   ByteWriter *bytes = &writer->bytes;
+
+   switch(value.type){
+      case VAL_NIL:       ant_bytes.write_u32(bytes, IMAGE_VALUE_NIL); break;
+      case VAL_UNDEFINED: ant_bytes.write_u32(bytes, IMAGE_VALUE_UNDEFINED); break;
+      case VAL_BOOL:      ant_bytes.write_u32(bytes, VALUE_AS_BOOL(value) ? IMAGE_VALUE_TRUE : IMAGE_VALUE_FALSE); break;
+
+      case VAL_NUMBER: {
+         double number = VALUE_AS_NUMBER(value);
+         ant_bytes.write_u32(bytes, IMAGE_VALUE_NUMBER);
+         ant_bytes.write(bytes, &number, sizeof(double));
+         break;
+      }
+
+      case VAL_OBJECT: {
+         Object *object = VALUE_AS_OBJECT(value);
+
+         if(object->type == OBJ_NATIVE){
+            int32_t index = ant_native.index((ObjectNative*)object);
+            ant_bytes.write_u32(bytes, IMAGE_VALUE_NATIVE);
+            ant_bytes.write_u32(bytes, (uint32_t)index);
+            bytes->ok = bytes->ok && index >= 0;
+            break;
+         }
+
+         ant_bytes.write_u32(bytes, IMAGE_VALUE_OBJECT);
+         write_reference(writer, object);
+         break;
+      }
+   }
+}
+
+/* objects outside this VM heap, from a parent context, cannot be written */
+
+static void write_reference(ImageWriter *writer, Object *object){
+   Value number;
+
+   if(!ant_table.get_value(&writer->numbers, VALUE_FROM_OBJECT(object), &number)){
+      /* the first one only, the snapshot stops there */
+      if(writer->bytes.ok && section_of(object) < 0){
+         fprintf(stderr, "Error: A heap image cannot hold a %s\n", ant_object.type_name(object->type));
+      }
+
+      writer->bytes.ok = false;
+      return;
+   }
+
+   ant_bytes.write_u32(&writer->bytes, (uint32_t)VALUE_AS_NUMBER(number));
+}
+
+/* */
+
+static void write_object(ImageWriter *writer, Object *object){
+   ByteWriter *bytes = &writer->bytes;
+
+   switch(object->type){
+      case OBJ_STRING: {
+         ObjectString *string = (ObjectString*)object;
+         ant_bytes.write_u32(bytes, (uint32_t)string->length);
+         ant_bytes.write_padded(bytes, string->chars, string->length);
+         break;
+      }
+
+      case OBJ_FUNCTION: {
+         ObjectFunction *func = (ObjectFunction*)object;
+         Chunk *chunk         = &func->chunk;
+
+         ant_bytes.write_u32(bytes, (uint32_t)func->arity);
+         ant_bytes.write_u32(bytes, (uint32_t)func->upvalue_count);
+
+         if(func->name == NULL){
+            ant_bytes.write_u32(bytes, IMAGE_NO_NAME);
+         } else {
+            write_reference(writer, STRING_AS_OBJECT(func->name));
+         }
+
+         ant_bytes.write_u32(bytes, (uint32_t)chunk->count);
+         ant_bytes.write_padded(bytes, chunk->code, chunk->count);
+         ant_bytes.write_u32(bytes, (uint32_t)chunk->lines.count);
+         ant_bytes.write_padded(bytes, chunk->lines.runs, chunk->lines.count);
+         ant_bytes.write_u32(bytes, (uint32_t)chunk->lines.checkpoint_count);
+         ant_bytes.write(bytes, chunk->lines.checkpoints, chunk->lines.checkpoint_count * (int32_t)sizeof(LineCheckpoint));
+         ant_bytes.write_u32(bytes, (uint32_t)chunk->constants.count);
+
+         for(int32_t i = 0; i < chunk->constants.count; i++){
+            write_value(writer, chunk->constants.values[i]);
+         }
+         break;
+      }
+
+      case OBJ_F64ARRAY: {
+         ObjectF64Array *array = (ObjectF64Array*)object;
+         ant_bytes.write_u32(bytes, (uint32_t)array->length);
+         ant_bytes.write(bytes, array->values, array->length * (int32_t)sizeof(double));
+         break;
+      }
+
+      case OBJ_CLOSURE: {
+         ObjectClosure *closure = (ObjectClosure*)object;
+         write_reference(writer, FUNCTION_AS_OBJECT(closure->func));
+         ant_bytes.write_u32(bytes, (uint32_t)closure->upvalue_count);
+
+         for(int32_t i = 0; i < closure->upvalue_count; i++){
+            write_reference(writer, UPVALUE_AS_OBJECT(closure->upvalues[i]));
+         }
+         break;
+      }
+
+      case OBJ_UPVALUE: {
+         /* between runs every upvalue is closed */
+         ObjectUpvalue *upvalue = (ObjectUpvalue*)object;
+         bytes->ok = bytes->ok && upvalue->location == &upvalue->closed;
+         write_value(writer, upvalue->closed);
+         break;
+      }
+
+      case OBJ_LIST: {
+         ObjectList *list = (ObjectList*)object;
+         ant_bytes.write_u32(bytes, (uint32_t)list->items.count);
+
+         for(int32_t i = 0; i < list->items.count; i++){
+            write_value(writer, list->items.values[i]);
+         }
+         break;
+      }
+
+      case OBJ_MAP: {
+         ObjectMap *map = (ObjectMap*)object;
+         ant_bytes.write_u32(bytes, (uint32_t)map->count);
+
+         int32_t cursor = 0;
+         Value key, value;
+
+         while(ant_map.next(map, &cursor, &key, &value)){
+            write_value(writer, key);
+            write_value(writer, value);
+         }
+         break;
+      }
+
+      case OBJ_NATIVE:
+      case OBJ_FIBER:
+      case OBJ_CHANNEL:
+         break;
+   }
+}
+
+/* Every object is allocated before the first reference to it is read,
+ * objects that only hold references are allocated empty first and filled after.
+ */
+
+static bool read_objects(ImageReader *reader, const ImageHeader *header){
+   ByteReader *bytes = &reader->bytes;
+
+   reader->first[0] = 0;
+
+   for(int32_t i = 0; i < IMAGE_SECTION_COUNT; i++){
+      if(header->counts[i] > (uint32_t)(INT32_MAX / 2 - reader->first[i])){
+         reader->objects                   = NULL;
+         reader->first[IMAGE_SECTION_COUNT] = 0;
+         return false;
+      }
+
+      reader->first[i + 1] = reader->first[i] + (int32_t)header->counts[i];
+   }
+
+   reader->objects = ALLOCATE(Object*, reader->first[IMAGE_SECTION_COUNT]);
+   Object **objects = reader->objects;
+
+   #define SECTION(section, i) objects[reader->first[section] + (i)]
+   #define COUNT(section) ((int32_t)header->counts[section])
+
+   for(int32_t i = 0; i < COUNT(IMAGE_STRINGS) && bytes->ok; i++){
+      int32_t length    = (int32_t)ant_bytes.read_u32(bytes);
+      const uint8_t *at = ant_bytes.read_padded(bytes, length);
+
+      SECTION(IMAGE_STRINGS, i) = at == NULL ? NULL : STRING_AS_OBJECT(ant_string.new((const char*)at, length));
+   }
+
+   for(int32_t i = 0; i < COUNT(IMAGE_FUNCTIONS); i++){
+      SECTION(IMAGE_FUNCTIONS, i) = FUNCTION_AS_OBJECT(ant_function.new());
+   }
+
+   for(int32_t i = 0; i < COUNT(IMAGE_UPVALUES); i++){
+      ObjectUpvalue *upvalue = ant_upvalues.new(NULL);
+      upvalue->location      = &upvalue->closed;
+      SECTION(IMAGE_UPVALUES, i) = UPVALUE_AS_OBJECT(upvalue);
+   }
+
+   for(int32_t i = 0; i < COUNT(IMAGE_LISTS); i++){
+      SECTION(IMAGE_LISTS, i) = ant_list.as_object(ant_list.new());
+   }
+
+   for(int32_t i = 0; i < COUNT(IMAGE_MAPS); i++){
+      SECTION(IMAGE_MAPS, i) = ant_map.as_object(ant_map.new());
+   }
+
+   for(int32_t i = 0; i < COUNT(IMAGE_FUNCTIONS) && bytes->ok; i++){
+      read_function(reader, (ObjectFunction*)SECTION(IMAGE_FUNCTIONS, i));
+   }
+
+   for(int32_t i = 0; i < COUNT(IMAGE_F64ARRAYS) && bytes->ok; i++){
+      int32_t length    = (int32_t)ant_bytes.read_u32(bytes);
+      const uint8_t *at = length <= INT32_MAX / (int32_t)sizeof(double)
+                        ? ant_bytes.read(bytes, length * (int32_t)sizeof(double)) : NULL;
+
+      if(at == NULL){
+         bytes->ok = false;
+         break;
+      }
+
+      ObjectF64Array *array = ant_f64_array.new(length);
+      memcpy(array->values, at, length * sizeof(double));
+      SECTION(IMAGE_F64ARRAYS, i) = ant_f64_array.as_object(array);
+   }
+
+   for(int32_t i = 0; i < COUNT(IMAGE_CLOSURES) && bytes->ok; i++){
+      ObjectFunction *func = (ObjectFunction*)read_reference(reader, IMAGE_FUNCTIONS);
+      int32_t count        = (int32_t)ant_bytes.read_u32(bytes);
+
+      if(func == NULL || count != func->upvalue_count){
+         bytes->ok = false;
+         break;
+      }
+
+      ObjectClosure *closure = ant_closure.new(func);
+
+      for(int32_t j = 0; j < count; j++){
+         closure->upvalues[j] = (ObjectUpvalue*)read_reference(reader, IMAGE_UPVALUES);
+      }
+
+      SECTION(IMAGE_CLOSURES, i) = CLOSURE_AS_OBJECT(closure);
+   }
+
+   for(int32_t i = 0; i < COUNT(IMAGE_UPVALUES) && bytes->ok; i++){
+      ((ObjectUpvalue*)SECTION(IMAGE_UPVALUES, i))->closed = read_value(reader);
+   }
+
+   for(int32_t i = 0; i < COUNT(IMAGE_LISTS) && bytes->ok; i++){
+      ObjectList *list = (ObjectList*)SECTION(IMAGE_LISTS, i);
+      int32_t count    = (int32_t)ant_bytes.read_u32(bytes);
+
+      for(int32_t j = 0; j < count && bytes->ok; j++){
+         ant_list.append(list, read_value(reader));
+      }
+   }
+
+   for(int32_t i = 0; i < COUNT(IMAGE_MAPS) && bytes->ok; i++){
+      ObjectMap *map = (ObjectMap*)SECTION(IMAGE_MAPS, i);
+      int32_t count  = (int32_t)ant_bytes.read_u32(bytes);
+
+      for(int32_t j = 0; j < count && bytes->ok; j++){
+         Value key   = read_value(reader);
+         Value value = read_value(reader);
+
+         if(!ant_table.is_hashable(key)){
+            bytes->ok = false;
+            break;
+         }
+
+         ant_map.set(map, key, value);
+      }
+   }
+
+   #undef SECTION
+   #undef COUNT
+
+   return bytes->ok;
+}
+
+/* Names already in the mapping, the natives, must sit at the same index,
+ * the rest is added once all of them were read.
+ */
+
+static bool read_globals(ImageReader *reader, VM *vm, const ImageHeader *header){
+   ByteReader *bytes     = &reader->bytes;
+   int32_t mapping_count = (int32_t)header->mapping_count;
+   int32_t global_count  = (int32_t)header->global_count;
+
+   if(mapping_count < vm->native_count || global_count < vm->native_count){
+      return false;
+   }
+
+   /* natives of this VM, before the globals holding them are overwritten */
+   reader->natives      = vm->globals.values;
+   reader->native_count = vm->native_count;
+
+   ValueArray names, globals;
+   ant_value_array.init(&names);
+   ant_value_array.init(&globals);
+
+   for(int32_t i = 0; i < mapping_count && bytes->ok; i++){
+      Object *name = read_reference(reader, IMAGE_STRINGS);
+
+      if(name != NULL && i < vm->native_count && (ObjectString*)name != ant_mapping.find_name(i)){
+         bytes->ok = false;
+      }
+
+      ant_value_array.write(&names, VALUE_FROM_OBJECT(name));
+   }
+
+   for(int32_t i = 0; i < global_count && bytes->ok; i++){
+      ant_value_array.write(&globals, read_value(reader));
+   }
+
+   bool ok = bytes->ok;
+
+   if(ok){
+      for(int32_t i = vm->native_count; i < mapping_count; i++){
+         ant_mapping.add(ant_string.from_value(names.values[i]));
+      }
+
+      for(int32_t i = vm->native_count; i < global_count; i++){
+         ant_value_array.write_at(&vm->globals, globals.values[i], i);
+      }
+
+      /* a script may have reassigned a native slot */
+      for(int32_t i = 0; i < vm->native_count; i++){
+         vm->globals.values[i] = globals.values[i];
+      }
+   }
+
+   ant_value_array.free(&names);
+   ant_value_array.free(&globals);
+   return ok;
+}
+
+/* */
+
+static void read_function(ImageReader *reader, ObjectFunction *func){
+   ByteReader *bytes = &reader->bytes;
+
+   func->arity         = (int32_t)ant_bytes.read_u32(bytes);
+   func->upvalue_count = (int32_t)ant_bytes.read_u32(bytes);
+
+   /* peek the name, NO_NAME is not an object number */
+   const uint8_t *at = bytes->at;
+
+   if(ant_bytes.read_u32(bytes) != IMAGE_NO_NAME){
+      bytes->at  = at;
+      func->name = (ObjectString*)read_reference(reader, IMAGE_STRINGS);
+   }
+
+   /* capacity stays 0, the chunk does not own its code and lines */
+   Chunk *chunk = &func->chunk;
+   chunk->count = (int32_t)ant_bytes.read_u32(bytes);
+   chunk->code  = (uint8_t*)ant_bytes.read_padded(bytes, chunk->count);
+
+   chunk->lines.count = (int32_t)ant_bytes.read_u32(bytes);
+   chunk->lines.runs  = (uint8_t*)ant_bytes.read_padded(bytes, chunk->lines.count);
+
+   chunk->lines.checkpoint_count = (int32_t)ant_bytes.read_u32(bytes);
+
+   if(chunk->lines.checkpoint_count < 0 || chunk->lines.checkpoint_count > INT32_MAX / (int32_t)sizeof(LineCheckpoint)){
+      bytes->ok = false;
+      return;
+   }
+
+   chunk->lines.checkpoints = (LineCheckpoint*)ant_bytes.read(bytes, chunk->lines.checkpoint_count * (int32_t)sizeof(LineCheckpoint));
+
+   int32_t constant_count = (int32_t)ant_bytes.read_u32(bytes);
+
+   for(int32_t i = 0; i < constant_count && bytes->ok; i++){
+      ant_value_array.write(&chunk->constants, read_value(reader));
+   }
+}
+
+/* natives come after the objects and resolve to the ones of the restoring VM */
+
+static Value read_value(ImageReader *reader){
+   ByteReader *bytes = &reader->bytes;
+
+   switch(ant_bytes.read_u32(bytes)){
+      case IMAGE_VALUE_NIL:       return ant_value.make_nil();
+      case IMAGE_VALUE_UNDEFINED: return ant_value.make_undefined();
+      case IMAGE_VALUE_TRUE:      return ant_value.from_bool(true);
+      case IMAGE_VALUE_FALSE:     return ant_value.from_bool(false);
+
+      case IMAGE_VALUE_NUMBER: {
+         const uint8_t *at = ant_bytes.read(bytes, sizeof(double));
+         double number     = 0;
+
+         if(at != NULL){
+            memcpy(&number, at, sizeof(double));
+         }
+
+         return ant_value.from_number(number);
+      }
+
+      case IMAGE_VALUE_OBJECT: {
+         uint32_t number = ant_bytes.read_u32(bytes);
+
+         if(number >= (uint32_t)reader->first[IMAGE_SECTION_COUNT] || reader->objects[number] == NULL){
+            bytes->ok = false;
+            return ant_value.make_nil();
+         }
+
+         return ant_value.from_object(reader->objects[number]);
+      }
+
+      case IMAGE_VALUE_NATIVE: {
+         uint32_t index = ant_bytes.read_u32(bytes);
+
+         if(index >= (uint32_t)reader->native_count){
+            bytes->ok = false;
+            return ant_value.make_nil();
+         }
+
+         return reader->natives[index];
+      }
+
+      default:
+         bytes->ok = false;
+         return ant_value.make_nil();
+   }
+}
+
+/* */
+
+static Object *read_reference(ImageReader *reader, ImageSection section){
+   uint32_t number = ant_bytes.read_u32(&reader->bytes);
+   uint32_t first  = (uint32_t)reader->first[section];
+   uint32_t last   = (uint32_t)reader->first[section + 1];
+
+   if(!reader->bytes.ok || number < first || number >= last || reader->objects[number] == NULL){
+      reader->bytes.ok = false;
+      return NULL;
+   }
+
+   return reader->objects[number];
+}
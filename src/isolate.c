@@ -0,0 +1,125 @@
+#include "isolate.h"
+#include "bytes.h"
+#include "memory.h"
+#include "strings.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+struct Isolate {
+   pthread_t        thread;
+   char*            source;
+   int32_t          length;
+   Channel*         channel;
+   InterpretResult  result;
+   struct Isolate*  next;     /* started by the same VM */
+};
+
+static Isolate*  start_isolate(const char *source, Channel *channel);
+static bool      join_isolate(Isolate *isolate);
+static bool      spawn_isolate(VM *vm, ObjectString *path, Channel *channel);
+static void      join_all(VM *vm);
+
+const IsolateAPI ant_isolate = {
+   .start = start_isolate,
+   .join = join_isolate,
+   .spawn = spawn_isolate,
+   .join_all = join_all,
+};
+
+/* Private */
+static void  *run_isolate(void *arg);
+static void   free_isolate(Isolate *isolate);
+
+/* Implementation */
+
+static Isolate *start_isolate(const char *source, Channel *channel){
+   Isolate *isolate = ALLOCATE(Isolate, 1);
+
+   isolate->length  = (int32_t)strlen(source);
+   isolate->source  = ALLOCATE(char, isolate->length + 1);
+   isolate->channel = channel;
+   isolate->result  = INTERPRET_OK;
+   isolate->next    = NULL;
+   memcpy(isolate->source, source, isolate->length + 1);
+
+   if(channel != NULL){
+      ant_channel.retain(channel);
+   }
+
+   if(pthread_create(&isolate->thread, NULL, run_isolate, isolate) != 0){
+      free_isolate(isolate);
+      return NULL;
+   }
+
+   return isolate;
+}
+
+/* */
+
+static bool join_isolate(Isolate *isolate){
+   pthread_join(isolate->thread, NULL);
+
+   bool ok = isolate->result == INTERPRET_OK;
+   free_isolate(isolate);
+   return ok;
+}
+
+/* the file is read here so a bad path is an error of the script starting the isolate */
+
+static bool spawn_isolate(VM *vm, ObjectString *path, Channel *channel){
+   MappedFile source;
+
+   if(!ant_bytes.map_source(path->chars, &source)){
+      ant_vm.runtime_error(vm, "isolate() could not read '%s'", path->chars);
+      return false;
+   }
+
+   Isolate *isolate = start_isolate(source.data, channel);
+   ant_bytes.unmap(&source);
+
+   if(isolate == NULL){
+      ant_vm.runtime_error(vm, "isolate() could not start a thread");
+      return false;
+   }
+
+   isolate->next = vm->isolates;
+   vm->isolates  = isolate;
+   return true;
+}
+
+/* */
+
+static void join_all(VM *vm){
+   while(vm->isolates != NULL){
+      Isolate *isolate = vm->isolates;
+      vm->isolates     = isolate->next;
+      join_isolate(isolate);
+   }
+}
+
+/* Private */
+
+/* the VM only borrows the channel, the isolate holds it until joined */
+
+static void *run_isolate(void *arg){
+   Isolate *isolate = (Isolate*)arg;
+   VM *vm           = ant_vm.new();
+   vm->channel      = isolate->channel;
+
+   isolate->result = ant_vm.interpret(vm, isolate->source);
+   ant_vm.free(vm);
+   return NULL;
+}
+
+/* */
+
+static void free_isolate(Isolate *isolate){
+   if(isolate->channel != NULL){
+      ant_channel.release(isolate->channel);
+   }
+
+   FREE_ARRAY(char, isolate->source, isolate->length + 1);
+   FREE(Isolate, isolate);
+}
@@ -3,82 +3,182 @@
 
 #include <stdio.h>
 
+/* three varints of at most 5 bytes */
+#define RUN_MAX_BYTES 15
+
 static void init_lines(Lines *lines);
-static void write_line(Lines *lines, int32_t line, int32_t chunk_index);
-static int32_t get_line(Lines *lines, int32_t chunk_index);
+static void write_line(Lines *lines, int32_t line, int32_t column, int32_t chunk_index);
+static int32_t get_line(const Lines *lines, int32_t chunk_index);
+static int32_t get_column(const Lines *lines, int32_t chunk_index);
 static void free_lines(Lines *lines);
 
 AntLineAPI ant_line = {
     .init = init_lines,
     .write = write_line,
     .get = get_line,
+    .column = get_column,
     .free = free_lines,
 };
 
 /* Helpers */
-static bool within_range(int32_t start, int32_t end, int32_t index);
-static bool line_exists(Lines *lines, int32_t line_number);
+static bool find_run(const Lines *lines, int32_t chunk_index, LineCheckpoint *run);
+static void add_checkpoint(Lines *lines, LineCheckpoint checkpoint);
+static void write_varint(Lines *lines, uint32_t value);
+static uint32_t read_varint(const uint8_t **at);
 
 static void init_lines(Lines *lines) {
   lines->count = 0;
   lines->capacity = 0;
-  lines->lines = NULL;
+  lines->runs = NULL;
+  lines->checkpoint_count = 0;
+  lines->checkpoint_capacity = 0;
+  lines->checkpoints = NULL;
+  lines->run_count = 0;
+  lines->last = (LineCheckpoint){.start = 0, .number = 0, .column = 0, .next = 0};
 }
 
-static void write_line(Lines *lines, int32_t line_number, int32_t chunk_index) {
+static void write_line(Lines *lines, int32_t line_number, int32_t column, int32_t chunk_index) {
+
+  /* NOTE: runs only store how far they start after the previous one, this
+   *       assumes that the bytecode is written in sequential order
+   * */
 
-  if (lines->capacity < lines->count + 1) {
+  if (lines->run_count > 0 && lines->last.number == line_number && lines->last.column == column) {
+    return;
+  }
+
+  if (lines->capacity < lines->count + RUN_MAX_BYTES) {
     size_t old_capacity = lines->capacity;
     lines->capacity = GROW_CAPACITY(old_capacity);
-    lines->lines =
-        GROW_ARRAY(Line, lines->lines, old_capacity, lines->capacity);
+    lines->capacity = lines->capacity < RUN_MAX_BYTES ? RUN_MAX_BYTES : lines->capacity;
+    lines->runs = GROW_ARRAY(uint8_t, lines->runs, old_capacity, lines->capacity);
   }
 
-  /* NOTE: we optimized adding new lines by not looping through the lines array
-   *       This assumes that the bytecode is written in sequential order
-   *       If this every changes, this will need to be updated
-   * */
+  /* zigzag, lines going back are small too */
+  int32_t line_delta = line_number - lines->last.number;
 
-  if (line_exists(lines, line_number)) {
-    lines->lines[lines->count - 1].end = chunk_index;
-    return;
-  }
+  write_varint(lines, (uint32_t)(chunk_index - lines->last.start));
+  write_varint(lines, ((uint32_t)line_delta << 1) ^ (uint32_t)(line_delta >> 31));
+  write_varint(lines, (uint32_t)column);
 
-  Line new_line = {
-      .start = chunk_index, .end = chunk_index, .number = line_number};
+  LineCheckpoint run = {
+      .start = chunk_index, .number = line_number, .column = column, .next = lines->count};
 
-  lines->lines[lines->count] = new_line;
-  lines->count++;
-}
+  if (lines->run_count % LINE_CHECKPOINT_RUNS == 0) {
+    add_checkpoint(lines, run);
+  }
 
-static int32_t get_line(Lines *lines, int32_t chunk_index) {
+  lines->last = run;
+  lines->run_count++;
+}
 
-  for (int i = 0; i < lines->count; i++) {
-    int32_t start = lines->lines[i].start;
-    int32_t end = lines->lines[i].end;
+static int32_t get_line(const Lines *lines, int32_t chunk_index) {
+  LineCheckpoint run;
 
-    if (within_range(start, end, chunk_index)) {
-      return lines->lines[i].number;
-    }
+  if (find_run(lines, chunk_index, &run)) {
+    return run.number;
   }
 
   printf("Error: Could not find line for chunk index %d\n", chunk_index);
   return -1;
 }
 
+static int32_t get_column(const Lines *lines, int32_t chunk_index) {
+  LineCheckpoint run;
+  return find_run(lines, chunk_index, &run) ? run.column : 0;
+}
+
 static void free_lines(Lines *lines) {
   if (!lines)
     return;
 
-  FREE_ARRAY(Line, lines->lines, lines->capacity);
+  /* borrowed from a bytecode cache when the capacities are 0 */
+  if (lines->capacity > 0) {
+    FREE_ARRAY(uint8_t, lines->runs, lines->capacity);
+  }
+
+  if (lines->checkpoint_capacity > 0) {
+    FREE_ARRAY(LineCheckpoint, lines->checkpoints, lines->checkpoint_capacity);
+  }
+
   init_lines(lines);
 }
 
-static bool line_exists(Lines *lines, int32_t line_number) {
-  return lines->count > 0 &&
-         lines->lines[lines->count - 1].number == line_number;
+/* the last checkpoint at or before chunk_index, then the runs after it up to chunk_index */
+
+static bool find_run(const Lines *lines, int32_t chunk_index, LineCheckpoint *run) {
+  if (lines->checkpoint_count == 0 || chunk_index < lines->checkpoints[0].start) {
+    return false;
+  }
+
+  int32_t low = 0;
+  int32_t high = lines->checkpoint_count - 1;
+
+  while (low < high) {
+    int32_t middle = low + (high - low + 1) / 2;
+
+    if (lines->checkpoints[middle].start <= chunk_index) {
+      low = middle;
+    } else {
+      high = middle - 1;
+    }
+  }
+
+  *run = lines->checkpoints[low];
+
+  const uint8_t *at = lines->runs + run->next;
+  const uint8_t *end = lines->runs + lines->count;
+
+  while (at < end) {
+    int32_t start = run->start + (int32_t)read_varint(&at);
+
+    if (start > chunk_index) {
+      break;
+    }
+
+    uint32_t line_delta = read_varint(&at);
+
+    run->start = start;
+    run->number += (int32_t)(line_delta >> 1) ^ -(int32_t)(line_delta & 1);
+    run->column = (int32_t)read_varint(&at);
+  }
+
+  return true;
+}
+
+static void add_checkpoint(Lines *lines, LineCheckpoint checkpoint) {
+  if (lines->checkpoint_capacity < lines->checkpoint_count + 1) {
+    size_t old_capacity = lines->checkpoint_capacity;
+    lines->checkpoint_capacity = GROW_CAPACITY(old_capacity);
+    lines->checkpoints = GROW_ARRAY(LineCheckpoint, lines->checkpoints, old_capacity,
+                                    lines->checkpoint_capacity);
+  }
+
+  lines->checkpoints[lines->checkpoint_count++] = checkpoint;
+}
+
+/* 7 bits per byte, the high bit set when more follow */
+
+static void write_varint(Lines *lines, uint32_t value) {
+  while (value >= 0x80) {
+    lines->runs[lines->count++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+
+  lines->runs[lines->count++] = (uint8_t)value;
 }
 
-static bool within_range(int32_t start, int32_t end, int32_t index) {
-  return index >= start && index <= end;
+static uint32_t read_varint(const uint8_t **at) {
+  uint32_t value = 0;
+
+  for (int32_t shift = 0; shift < 35; shift += 7) {
+    uint8_t byte = *(*at)++;
+    value |= (uint32_t)(byte & 0x7F) << shift;
+
+    if (byte < 0x80) {
+      break;
+    }
+  }
+
+  return value;
 }
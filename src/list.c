@@ -0,0 +1,77 @@
+#include "list.h"
+#include <stdio.h>
+
+static ObjectList*  new_list(void);
+static ObjectList*  list_from_value(Value value);
+static Object*      list_as_object(ObjectList *list);
+static void         append_list(ObjectList *list, Value value);
+static bool         pop_list(ObjectList *list, Value *value);
+static int32_t      print_list(ObjectList *list, bool debug);
+
+const ListAPI ant_list = {
+   .new = new_list,
+   .from_value = list_from_value,
+   .as_object = list_as_object,
+   .append = append_list,
+   .pop = pop_list,
+   .print = print_list,
+};
+
+static ObjectList *new_list(void){
+   ObjectList *list = (ObjectList*)ant_object.allocate(sizeof(ObjectList), OBJ_LIST);
+   ant_value_array.init(&list->items);
+
+   return list;
+}
+
+/* */
+
+static ObjectList *list_from_value(Value value){
+  return (ObjectList*)ant_value.as_object(value);
+}
+
+/* */
+
+static Object *list_as_object(ObjectList *list){
+  return (Object*)list;
+}
+
+/* */
+
+static void append_list(ObjectList *list, Value value){
+   ant_value_array.write(&list->items, value);
+}
+
+/* */
+
+static bool pop_list(ObjectList *list, Value *value){
+   if(list->items.count == 0){
+      return false;
+   }
+
+   list->items.count--;
+   *value = list->items.values[list->items.count];
+   return true;
+}
+
+/* */
+
+static int32_t print_list(ObjectList *list, bool debug){
+   /* a list inside itself, directly or through other lists and maps, would recurse forever */
+   if(!ant_object.enter(LIST_AS_OBJECT(list))){
+      return printf("[...]");
+   }
+
+   int32_t print_len = printf("[");
+
+   for(int32_t i = 0; i < list->items.count; i++){
+      print_len += ant_value.print(list->items.values[i], debug);
+
+      if(i < list->items.count - 1){
+         print_len += printf(", ");
+      }
+   }
+
+   ant_object.leave();
+   return print_len + printf("]");
+}
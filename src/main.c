@@ -1,74 +1,207 @@
 #include "vm.h"
+#include "bytecode_cache.h"
+#include "bytes.h"
+#include "image.h"
+#include "parallel.h"
+#include "profiler.h"
+#include "trace.h"
+#include "alloc_sites.h"
+#include "perf.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
-static void run_file(VM *vm, const char *path);
-static char *read_file(const char *path);
+static InterpretResult run_file(VM *vm, const char *path, BytecodeFile **cache_file);
+static int exit_status(InterpretResult result);
+static void report_stats(VM *vm, const char *option);
+static InterpretResult run_counted(VM *vm, const char *option, const char *path, BytecodeFile **cache_file);
 
 int main(int ac, char *av[]) {
   VM *vm = ant_vm.new();
+  BytecodeFile *cache_file = NULL;
+  HeapImage *image = NULL;
+  InterpretResult result = INTERPRET_OK;
+  int status = 0;
+  bool tracing = false;
 
-  switch (ac) {
-  case 1:
+  if (ac == 1) {
     ant_vm.repl(vm);
-    break;
-  case 2:
-    run_file(vm, av[1]);
-    break;
-  default:
-    fprintf(stderr, "Usage: ant [path]\n");
-    break;
+
+  } else if (ac == 2 && av[1][0] != '-') {
+    result = run_file(vm, av[1], &cache_file);
+
+  } else if (ac == 3 && strncmp(av[1], "--stats", 7) == 0 && (av[1][7] == '\0' || av[1][7] == '=')) {
+    result = run_file(vm, av[2], &cache_file);
+    report_stats(vm, av[1]);
+
+  } else if (ac == 4 && strcmp(av[1], "--profile") == 0) {
+    if (!ant_profiler.start(vm)) {
+      fprintf(stderr, "Error: Could not start the profiler\n");
+    }
+
+    result = run_file(vm, av[3], &cache_file);
+    ant_profiler.stop(vm);
+
+    if (!ant_profiler.write(av[2])) {
+      fprintf(stderr, "Error: Could not write profile: %s\n", av[2]);
+    }
+
+  } else if (ac == 3 && strcmp(av[1], "--alloc-sites") == 0) {
+    ant_alloc_sites.start(vm);
+    result = run_file(vm, av[2], &cache_file);
+    ant_alloc_sites.print(vm, stderr, 30);
+
+  } else if (ac == 3 && (strcmp(av[1], "--perf") == 0 || strcmp(av[1], "--perf=functions") == 0)) {
+    result = run_counted(vm, av[1], av[2], &cache_file);
+
+  } else if (ac == 4 && strcmp(av[1], "--trace") == 0) {
+    tracing = ant_trace.start();
+
+    if (!tracing) {
+      fprintf(stderr, "Error: --trace needs a build with DEBUG_TRACE_EVENTS, see make trace\n");
+    }
+
+    result = run_file(vm, av[3], &cache_file);
+
+  } else if (ac == 4 && strcmp(av[1], "--snapshot") == 0) {
+    result = run_file(vm, av[3], &cache_file);
+
+    if (result == INTERPRET_OK && !ant_image.snapshot(vm, av[2])) {
+      fprintf(stderr, "Error: Could not write heap image: %s\n", av[2]);
+      status = 73; /* EX_CANTCREAT */
+    }
+
+  } else if ((ac == 3 || ac == 4) && strcmp(av[1], "--restore") == 0) {
+    image = ant_image.restore(vm, av[2]);
+
+    if (image == NULL) {
+      fprintf(stderr, "Error: Could not restore heap image: %s\n", av[2]);
+      status = 66; /* EX_NOINPUT */
+    } else if (ac == 4) {
+      result = run_file(vm, av[3], &cache_file);
+    } else {
+      ant_vm.repl(vm);
+    }
+
+  } else {
+    fprintf(stderr, "Usage: ant [path]\n"
+                    "       ant --stats[=json file] path\n"
+                    "       ant --profile folded_stacks_file path\n"
+                    "       ant --trace trace_json_file path\n"
+                    "       ant --alloc-sites path\n"
+                    "       ant --perf[=functions] path\n"
+                    "       ant --snapshot image path\n"
+                    "       ant --restore image [path]\n");
   }
 
+  /* functions loaded from the cache or the image point into the mapped files */
   ant_vm.free(vm);
-  return 0;
+  ant_parallel.stop();
+
+  /* the workers and isolates recording are gone */
+  if (tracing && !ant_trace.write(av[2])) {
+    fprintf(stderr, "Error: Could not write trace: %s\n", av[2]);
+  }
+
+  ant_bytecode_cache.close(cache_file);
+  ant_image.close(image);
+  return status != 0 ? status : exit_status(result);
 }
 
-static void run_file(VM *vm, const char *path) {
-  char *source = read_file(path);
+/* the ones of sysexits.h, so the bench runner and shells can tell a script failed */
 
-  InterpretResult result = ant_vm.interpret(vm, source);
+static int exit_status(InterpretResult result) {
+  switch (result) {
+  case INTERPRET_COMPILE_ERROR:
+    return 65;
+  case INTERPRET_RUNTIME_ERROR:
+    return 70;
+  default:
+    return 0;
+  }
+}
+
+/* --stats prints to stderr, --stats=file writes JSON. Runtime errors are reported too, the
+ * counts stop at the failing instruction */
 
-  if (result == INTERPRET_COMPILE_ERROR) printf("Compile error\n");
+static void report_stats(VM *vm, const char *option) {
+  if (vm->stats == NULL) {
+    fprintf(stderr, "Error: --stats needs a build with DEBUG_OPCODE_STATS, see make stats\n");
+    return;
+  }
 
-  free(source);
+  if (option[7] == '\0') {
+    ant_stats.print(vm->stats, stderr, 30);
+  } else if (!ant_stats.write_json(vm->stats, option + 8)) {
+    fprintf(stderr, "Error: Could not write stats: %s\n", option + 8);
+  }
 }
 
-static char *read_file(const char *path) {
+/* without any counter the script still runs, uncounted */
 
-  FILE *file = fopen(path, "rb");
+static InterpretResult run_counted(VM *vm, const char *option, const char *path, BytecodeFile **cache_file) {
+  bool functions      = strcmp(option, "--perf=functions") == 0;
+  PerfSession *perf   = ant_perf.open(functions);
 
-  if (file == NULL) {
-    printf("Error: Could not open file: %s\n", path);
-    exit(74);
+  if (perf == NULL) {
+    fprintf(stderr, "Error: Could not open perf counters, see /proc/sys/kernel/perf_event_paranoid\n");
   }
 
-  int r = fseek(file, 0L, SEEK_END);
+  vm->perf = functions ? perf : NULL;
+  InterpretResult result = run_file(vm, path, cache_file);
+  vm->perf = NULL;
 
-  if (r != 0) {
-    printf("Error: Could not seek file: %s\n", path);
-    exit(74);
+  if (perf != NULL) {
+    ant_perf.report(perf, stderr, 30);
+    ant_perf.close(perf);
   }
 
-  size_t file_size = ftell(file);
-  rewind(file);
+  return result;
+}
+
+/* compiles only when the cache next to the source is missing or stale */
 
-  char *buffer = (char *)malloc((file_size + 1) * sizeof(char));
+static InterpretResult run_file(VM *vm, const char *path, BytecodeFile **cache_file) {
+  MappedFile mapped;
 
-  if (buffer == NULL) {
-    printf("Error: Could not allocate memory for reading file: %s\n", path);
+  if (!ant_bytes.map_source(path, &mapped)) {
+    printf("Error: Could not open file: %s\n", path);
     exit(74);
   }
 
-  size_t rd_len = fread(buffer, sizeof(char), file_size, file);
+  const char *source = mapped.data;
+
+  size_t path_length = strlen(path);
+  char *cache_path   = (char *)malloc(path_length + sizeof(BYTECODE_CACHE_SUFFIX));
 
-  if (rd_len < file_size) {
-    printf("Error: Could not read file: %s. File size: %ld bytes, read: %ld " "bytes\n", path, file_size, rd_len);
+  if (cache_path == NULL) {
+    printf("Error: Could not allocate memory for cache path: %s\n", path);
     exit(74);
   }
 
-  buffer[rd_len] = '\0';
+  memcpy(cache_path, path, path_length);
+  memcpy(cache_path + path_length, BYTECODE_CACHE_SUFFIX, sizeof(BYTECODE_CACHE_SUFFIX));
+
+  ObjectFunction *script = ant_bytecode_cache.load(vm, cache_path, source, cache_file);
+
+  if (script == NULL) {
+    script = ant_vm.compile(vm, source);
+
+    /* an unwritable directory only costs the next run a compile */
+    if (script != NULL) {
+      ant_bytecode_cache.save(vm, cache_path, script, source);
+    }
+  }
+
+  InterpretResult result = INTERPRET_COMPILE_ERROR;
+
+  if (script == NULL) {
+    printf("Compile error\n");
+  } else {
+    result = ant_vm.execute(vm, script);
+  }
 
-  fclose(file);
-  return buffer;
+  free(cache_path);
+  ant_bytes.unmap(&mapped);
+  return result;
 }
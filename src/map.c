@@ -0,0 +1,114 @@
+#include "map.h"
+#include <stdio.h>
+
+static ObjectMap*   new_map(void);
+static ObjectMap*   map_from_value(Value value);
+static Object*      map_as_object(ObjectMap *map);
+static void         map_set(ObjectMap *map, Value key, Value value);
+static bool         map_get(ObjectMap *map, Value key, Value *value);
+static bool         map_delete(ObjectMap *map, Value key);
+static bool         map_next(ObjectMap *map, int32_t *cursor, Value *key, Value *value);
+static int32_t      print_map(ObjectMap *map, bool debug);
+
+const MapAPI ant_map = {
+   .new = new_map,
+   .from_value = map_from_value,
+   .as_object = map_as_object,
+   .set = map_set,
+   .get = map_get,
+   .delete = map_delete,
+   .next = map_next,
+   .print = print_map,
+};
+
+static ObjectMap *new_map(void){
+   ObjectMap *map = (ObjectMap*)ant_object.allocate(sizeof(ObjectMap), OBJ_MAP);
+   ant_table.init(&map->table);
+   map->count = 0;
+
+   return map;
+}
+
+/* */
+
+static ObjectMap *map_from_value(Value value){
+  return (ObjectMap*)ant_value.as_object(value);
+}
+
+/* */
+
+static Object *map_as_object(ObjectMap *map){
+  return (Object*)map;
+}
+
+/* caller must check the key with ant_table.is_hashable */
+
+static void map_set(ObjectMap *map, Value key, Value value){
+   if(ant_table.set_value(&map->table, key, value)){
+      map->count++;
+   }
+}
+
+/* */
+
+static bool map_get(ObjectMap *map, Value key, Value *value){
+   return ant_table.get_value(&map->table, key, value);
+}
+
+/* */
+
+static bool map_delete(ObjectMap *map, Value key){
+   if(!ant_table.delete_value(&map->table, key)){
+      return false;
+   }
+
+   map->count--;
+   return true;
+}
+
+/* Iterates live entries in table order. Start with cursor = 0, 
+ * the map must not be modified while iterating.
+ */
+
+static bool map_next(ObjectMap *map, int32_t *cursor, Value *key, Value *value){
+   while(*cursor < map->table.capacity){
+      Entry *entry = &map->table.entries[(*cursor)++];
+
+      if(VALUE_IS_UNDEFINED(entry->key)){
+         continue;
+      }
+
+      *key = entry->key;
+      *value = entry->value;
+      return true;
+   }
+
+   return false;
+}
+
+/* */
+
+static int32_t print_map(ObjectMap *map, bool debug){
+   /* shares the stack of ant_list.print, so cycles through lists are caught too */
+   if(!ant_object.enter(MAP_AS_OBJECT(map))){
+      return printf("{...}");
+   }
+
+   int32_t print_len = printf("{");
+   int32_t cursor = 0;
+   int32_t printed = 0;
+   Value key, value;
+
+   while(map_next(map, &cursor, &key, &value)){
+      print_len += ant_value.print(key, debug);
+      print_len += printf(": ");
+      print_len += ant_value.print(value, debug);
+
+      if(++printed < map->count){
+         print_len += printf(", ");
+      }
+   }
+
+   ant_object.leave();
+   return print_len + printf("}");
+}
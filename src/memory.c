@@ -1,8 +1,7 @@
 #include "memory.h"
+#include "context.h"
 #include <stdlib.h>
 
-GarbageCollection garbage = {.objects = NULL};
-
 static void *reallocate(void *pointer, size_t old_size, size_t new_size);
 static Object* add_object(Object *object);
 static void    free_objects(void);
@@ -41,13 +40,13 @@ static void *reallocate(void *pointer, size_t old_size, size_t new_size) {
 static Object* add_object(Object *object) {
    /* add to the front  */
 
-   object->next = garbage.objects;
-   garbage.objects = object;
+   object->next = CURRENT_CONTEXT()->garbage.objects;
+   CURRENT_CONTEXT()->garbage.objects = object;
    return object;
 }
 
 static void free_objects(){
-   Object *head = garbage.objects;
+   Object *head = CURRENT_CONTEXT()->garbage.objects;
 
 
    while (head != NULL) {
@@ -56,6 +55,6 @@ static void free_objects(){
       head = next;
    }
 
-   garbage.objects = NULL;
+   CURRENT_CONTEXT()->garbage.objects = NULL;
 }
 
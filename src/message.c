@@ -0,0 +1,257 @@
+#include "message.h"
+#include "list.h"
+#include "map.h"
+#include "f64_array.h"
+#include "memory.h"
+#include "vm.h"
+
+#include <string.h>
+
+static bool     check_message(VM *vm, Value value, const char *name);
+static Message  encode_message(Value value, MessageMode mode);
+static Value    decode_message(Message *message);
+static void     free_message(Message *message);
+
+const MessageAPI ant_message = {
+   .check = check_message,
+   .encode = encode_message,
+   .decode = decode_message,
+   .free = free_message,
+};
+
+/* Private */
+static bool     check_value(VM *vm, Value value, const char *name, int32_t depth);
+
+/* Implementation */
+
+/* */
+
+static bool check_message(VM *vm, Value value, const char *name){
+   return check_value(vm, value, name, 0);
+}
+
+/* */
+
+static Message encode_message(Value value, MessageMode mode){
+   Message message = {.type = MESSAGE_NIL, .count = 0};
+
+   switch(value.type){
+      case VAL_BOOL:
+         message.type       = MESSAGE_BOOL;
+         message.as.boolean = VALUE_AS_BOOL(value);
+         return message;
+
+      case VAL_NUMBER:
+         message.type      = MESSAGE_NUMBER;
+         message.as.number = VALUE_AS_NUMBER(value);
+         return message;
+
+      case VAL_NIL:
+      case VAL_UNDEFINED:
+         return message;
+
+      case VAL_OBJECT:
+         break;
+   }
+
+   switch(OBJECT_TYPE(value)){
+      case OBJ_STRING:
+         message.type      = MESSAGE_STRING;
+         message.as.string = ant_string.share(STRING_FROM_VALUE(value));
+         break;
+
+      case OBJ_F64ARRAY: {
+         ObjectF64Array *array = F64_ARRAY_FROM_VALUE(value);
+
+         message.type  = MESSAGE_F64ARRAY;
+         message.count = array->length;
+
+         if(mode == MESSAGE_COPY){
+            message.as.values = array->length > 0 ? ALLOCATE(double, array->length) : NULL;
+            memcpy(message.as.values, array->values, sizeof(double) * array->length);
+            break;
+         }
+
+         message.as.values = array->values;
+         array->values     = NULL;
+         array->length     = 0;
+         break;
+      }
+
+      case OBJ_CHANNEL:
+         message.type       = MESSAGE_CHANNEL;
+         message.as.channel = CHANNEL_FROM_VALUE(value)->channel;
+         ant_channel.retain(message.as.channel);
+         break;
+
+      case OBJ_LIST: {
+         ObjectList *list = LIST_FROM_VALUE(value);
+
+         message.type     = MESSAGE_LIST;
+         message.count    = list->items.count;
+         message.as.items = ALLOCATE(Message, message.count);
+
+         for(int32_t i = 0; i < message.count; i++){
+            message.as.items[i] = encode_message(list->items.values[i], mode);
+         }
+         break;
+      }
+
+      case OBJ_MAP: {
+         ObjectMap *map = MAP_FROM_VALUE(value);
+         int32_t cursor = 0;
+         int32_t at     = 0;
+         Value key, item;
+
+         message.type     = MESSAGE_MAP;
+         message.count    = map->count;
+         message.as.items = ALLOCATE(Message, message.count * 2);
+
+         while(ant_map.next(map, &cursor, &key, &item)){
+            message.as.items[at++] = encode_message(key, mode);
+            message.as.items[at++] = encode_message(item, mode);
+         }
+         break;
+      }
+
+      default:
+         break;
+   }
+
+   return message;
+}
+
+/* */
+
+static Value decode_message(Message *message){
+   switch(message->type){
+      case MESSAGE_NIL:     return ant_value.make_nil();
+      case MESSAGE_BOOL:    return ant_value.from_bool(message->as.boolean);
+      case MESSAGE_NUMBER:  return ant_value.from_number(message->as.number);
+
+      case MESSAGE_STRING:
+         return ant_value.from_object(STRING_AS_OBJECT(ant_string.from_shared(message->as.string)));
+
+      case MESSAGE_F64ARRAY: {
+         ObjectF64Array *array = ant_f64_array.new(0);
+         array->values = message->as.values;
+         array->length = message->count;
+         return ant_value.from_object(F64_ARRAY_AS_OBJECT(array));
+      }
+
+      case MESSAGE_CHANNEL:
+         return ant_value.from_object(CHANNEL_AS_OBJECT(ant_channel.wrap(message->as.channel)));
+
+      case MESSAGE_LIST: {
+         ObjectList *list = ant_list.new();
+
+         for(int32_t i = 0; i < message->count; i++){
+            ant_list.append(list, decode_message(&message->as.items[i]));
+         }
+
+         FREE_ARRAY(Message, message->as.items, message->count);
+         return ant_value.from_object(LIST_AS_OBJECT(list));
+      }
+
+      case MESSAGE_MAP: {
+         ObjectMap *map = ant_map.new();
+
+         for(int32_t i = 0; i < message->count; i++){
+            Value key = decode_message(&message->as.items[i * 2]);
+            ant_map.set(map, key, decode_message(&message->as.items[i * 2 + 1]));
+         }
+
+         FREE_ARRAY(Message, message->as.items, message->count * 2);
+         return ant_value.from_object(MAP_AS_OBJECT(map));
+      }
+   }
+
+   return ant_value.make_nil();
+}
+
+/* */
+
+static void free_message(Message *message){
+   switch(message->type){
+      case MESSAGE_STRING:
+         ant_string.release_shared(message->as.string);
+         break;
+
+      case MESSAGE_F64ARRAY:
+         FREE_ARRAY(double, message->as.values, message->count);
+         break;
+
+      case MESSAGE_CHANNEL:
+         ant_channel.release(message->as.channel);
+         break;
+
+      case MESSAGE_LIST:
+      case MESSAGE_MAP: {
+         int32_t count = message->type == MESSAGE_MAP ? message->count * 2 : message->count;
+
+         for(int32_t i = 0; i < count; i++){
+            free_message(&message->as.items[i]);
+         }
+
+         FREE_ARRAY(Message, message->as.items, count);
+         break;
+      }
+
+      default:
+         break;
+   }
+}
+
+/* Private */
+
+/* lists and maps containing themselves hit the depth limit */
+
+static bool check_value(VM *vm, Value value, const char *name, int32_t depth){
+
+   if(!VALUE_IS_OBJECT(value)){
+      return true;
+   }
+
+   if(depth > OPTION_MESSAGE_DEPTH_MAX){
+      ant_vm.runtime_error(vm, "%s() value nested deeper than %d lists or maps", name, OPTION_MESSAGE_DEPTH_MAX);
+      return false;
+   }
+
+   switch(OBJECT_TYPE(value)){
+      case OBJ_STRING:
+      case OBJ_F64ARRAY:
+      case OBJ_CHANNEL:
+         return true;
+
+      case OBJ_LIST: {
+         ObjectList *list = LIST_FROM_VALUE(value);
+
+         for(int32_t i = 0; i < list->items.count; i++){
+            if(!check_value(vm, list->items.values[i], name, depth + 1)){
+               return false;
+            }
+         }
+         return true;
+      }
+
+      case OBJ_MAP: {
+         int32_t cursor = 0;
+         Value key, item;
+
+         while(ant_map.next(MAP_FROM_VALUE(value), &cursor, &key, &item)){
+            if(!check_value(vm, key, name, depth + 1) || !check_value(vm, item, name, depth + 1)){
+               return false;
+            }
+         }
+         return true;
+      }
+
+      case OBJ_FIBER:
+         ant_vm.runtime_error(vm, "%s() can't pass a fiber to another thread", name);
+         return false;
+
+      default:
+         ant_vm.runtime_error(vm, "%s() can't pass a function to another thread", name);
+         return false;
+   }
+}
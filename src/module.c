@@ -0,0 +1,92 @@
+#include "module.h"
+#include "bytes.h"
+#include "memory.h"
+#include "strings.h"
+#include "table.h"
+#include "trace.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static bool           find_module(VM *vm, ObjectString *path, Value *exports);
+static ObjectClosure *load_module(VM *vm, ObjectString *path);
+static void           module_loaded(VM *vm, ObjectString *path, Value exports);
+
+const ModuleAPI ant_module = {
+   .find = find_module,
+   .load = load_module,
+   .loaded = module_loaded,
+};
+
+/* Private */
+static bool  is_running(VM *vm, ObjectClosure *closure);
+
+/* Implementation */
+
+static bool find_module(VM *vm, ObjectString *path, Value *exports){
+   Value found;
+
+   if(!ant_table.get(&vm->modules, path, &found) || OBJECT_IS_CLOSURE(found)){
+      return false;
+   }
+
+   *exports = found;
+   return true;
+}
+
+/* a closure left by a module that stopped on a runtime error is compiled again */
+
+static ObjectClosure *load_module(VM *vm, ObjectString *path){
+   Value loading;
+
+   if(ant_table.get(&vm->modules, path, &loading) && is_running(vm, CLOSURE_FROM_VALUE(loading))){
+      ant_vm.runtime_error(vm, "Import cycle, %s is imported while it runs", path->chars);
+      return NULL;
+   }
+
+   MappedFile source;
+
+   if(!ant_bytes.map_source(path->chars, &source)){
+      ant_vm.runtime_error(vm, "Could not read module: %s", path->chars);
+      return NULL;
+   }
+
+   uint64_t started = TRACE_CLOCK();
+
+   Compiler compiler;
+   ant_compiler.init_module(&compiler, path->chars, vm->native_count);
+
+   ObjectFunction *func = ant_compiler.compile(&compiler, source.data);
+   ant_bytes.unmap(&source);
+   TRACE_SPAN(vm->fiber, "compile", started);
+
+   if(func == NULL){
+      ant_vm.runtime_error(vm, "Could not compile module: %s", path->chars);
+      return NULL;
+   }
+
+   /* stack traces show the frames of the module by its path */
+   func->name = path;
+
+   ObjectClosure *closure = ant_closure.new(func);
+   ant_table.set(&vm->modules, path, ant_value.from_object(CLOSURE_AS_OBJECT(closure)));
+   return closure;
+}
+
+/* */
+
+static void module_loaded(VM *vm, ObjectString *path, Value exports){
+   ant_table.set(&vm->modules, path, exports);
+}
+
+/* */
+
+static bool is_running(VM *vm, ObjectClosure *closure){
+   for(int32_t i = 0; i < vm->frame_count; i++){
+      if(vm->frames[i].closure == closure){
+         return true;
+      }
+   }
+
+   return false;
+}
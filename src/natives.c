@@ -1,4 +1,14 @@
 #include "natives.h"
+#include "list.h"
+#include "f64_array.h"
+#include "map.h"
+#include "fiber.h"
+#include "event_loop.h"
+#include "channel.h"
+#include "isolate.h"
+#include "parallel.h"
+#include "alloc_sites.h"
+#include "f64_kernels.h"
 #include "var_mapping.h"
 #include "value_array.h"
 #include "stack.h"
@@ -7,11 +17,14 @@
 #include <time.h>
 #include <stdlib.h>
 
-static ObjectNative*   new_native(NativeFunction func);
+static ObjectNative*   new_native(NativeFunction func, int32_t arity);
 static int32_t         print_native(void);
 static ObjectNative*   native_from_value(Value value);
 static Object*         native_as_object(ObjectNative* native);
 static void            register_all_natives(VM *vm);
+static void            register_native_names(void);
+static int32_t         native_index(ObjectNative *native);
+static const char*     native_name(ObjectNative *native);
 
 const ObjectNativeAPI ant_native = {
     .new          = new_native,
@@ -19,19 +32,133 @@ const ObjectNativeAPI ant_native = {
     .from_value   = native_from_value,
     .as_object    = native_as_object,
     .register_all = register_all_natives,
+    .register_names = register_native_names,
+    .index = native_index,
+    .name = native_name,
 };
 
 /* Private */
-static void define_native_function(VM *vm, const char *name, NativeFunction func);
+static void define_native_function(VM *vm, const char *name, NativeFunction func, int32_t arity);
 
 /* Native Functions */
-static Value native_clock(int32_t arg_count, Value *args);
+static Value native_clock(VM *vm, int32_t arg_count, Value *args);
+static Value native_length(VM *vm, int32_t arg_count, Value *args);
+static Value native_push(VM *vm, int32_t arg_count, Value *args);
+static Value native_pop(VM *vm, int32_t arg_count, Value *args);
+
+/* f64array natives */
+static Value native_f64array(VM *vm, int32_t arg_count, Value *args);
+static Value native_sum(VM *vm, int32_t arg_count, Value *args);
+static Value native_dot(VM *vm, int32_t arg_count, Value *args);
+static Value native_min(VM *vm, int32_t arg_count, Value *args);
+static Value native_max(VM *vm, int32_t arg_count, Value *args);
+static Value native_scale(VM *vm, int32_t arg_count, Value *args);
+static Value native_axpy(VM *vm, int32_t arg_count, Value *args);
+static Value native_vec_add(VM *vm, int32_t arg_count, Value *args);
+static Value native_vec_sub(VM *vm, int32_t arg_count, Value *args);
+static Value native_vec_mul(VM *vm, int32_t arg_count, Value *args);
+static Value native_vec_div(VM *vm, int32_t arg_count, Value *args);
+
+/* map natives */
+static Value native_has(VM *vm, int32_t arg_count, Value *args);
+static Value native_delete(VM *vm, int32_t arg_count, Value *args);
+static Value native_keys(VM *vm, int32_t arg_count, Value *args);
+static Value native_values(VM *vm, int32_t arg_count, Value *args);
+
+/* fiber natives */
+static Value native_fiber(VM *vm, int32_t arg_count, Value *args);
+static Value native_resume(VM *vm, int32_t arg_count, Value *args);
+static Value native_yield(VM *vm, int32_t arg_count, Value *args);
+static Value native_done(VM *vm, int32_t arg_count, Value *args);
+
+/* event loop natives */
+static Value native_sleep(VM *vm, int32_t arg_count, Value *args);
+static Value native_timer(VM *vm, int32_t arg_count, Value *args);
+static Value native_spawn(VM *vm, int32_t arg_count, Value *args);
+static Value native_read_file_async(VM *vm, int32_t arg_count, Value *args);
+static Value native_tcp_connect(VM *vm, int32_t arg_count, Value *args);
+static Value native_tcp_read(VM *vm, int32_t arg_count, Value *args);
+static Value native_tcp_write(VM *vm, int32_t arg_count, Value *args);
+static Value native_tcp_close(VM *vm, int32_t arg_count, Value *args);
+
+/* isolate natives */
+static Value native_channel(VM *vm, int32_t arg_count, Value *args);
+static Value native_send(VM *vm, int32_t arg_count, Value *args);
+static Value native_receive(VM *vm, int32_t arg_count, Value *args);
+static Value native_close_channel(VM *vm, int32_t arg_count, Value *args);
+static Value native_isolate(VM *vm, int32_t arg_count, Value *args);
+static Value native_isolate_channel(VM *vm, int32_t arg_count, Value *args);
+
+/* parallel natives */
+static Value native_parallel_map(VM *vm, int32_t arg_count, Value *args);
+static Value native_parallel_reduce(VM *vm, int32_t arg_count, Value *args);
+
+/* profiling natives */
+static Value native_allocation_sites(VM *vm, int32_t arg_count, Value *args);
+
+static bool  check_fd(VM *vm, const char *name, Value value);
+
+static bool  check_f64_arrays(VM *vm, const char *name, Value *args, int32_t count);
+static Value elementwise(VM *vm, const char *name, Value *args,
+                         void (*kernel)(const double *, const double *, double *, int32_t));
+
+/* the order fixes the global index of each native, every context must register them the same way */
+
+typedef struct {
+   const char     *name;
+   NativeFunction func;
+   int32_t        arity;
+}NativeDefinition;
+
+static const NativeDefinition natives[] = {
+   {"clock",     native_clock,      0},
+   {"length",    native_length,     1},
+   {"push",      native_push,       2},
+   {"pop",       native_pop,        1},
+   {"f64array",  native_f64array,   1},
+   {"sum",       native_sum,        1},
+   {"dot",       native_dot,        2},
+   {"min",       native_min,        1},
+   {"max",       native_max,        1},
+   {"scale",     native_scale,      2},
+   {"axpy",      native_axpy,       3},
+   {"vec_add",   native_vec_add,    2},
+   {"vec_sub",   native_vec_sub,    2},
+   {"vec_mul",   native_vec_mul,    2},
+   {"vec_div",   native_vec_div,    2},
+   {"has",       native_has,        2},
+   {"delete",    native_delete,     2},
+   {"keys",      native_keys,       1},
+   {"values",    native_values,     1},
+   {"fiber",     native_fiber,      1},
+   {"resume",    native_resume,     2},
+   {"yield",     native_yield,      1},
+   {"done",      native_done,       1},
+   {"sleep",     native_sleep,      1},
+   {"timer",     native_timer,      2},
+   {"spawn",     native_spawn,      1},
+   {"read_file_async", native_read_file_async, 1},
+   {"tcp_connect", native_tcp_connect, 1},
+   {"tcp_read",  native_tcp_read,   1},
+   {"tcp_write", native_tcp_write,  2},
+   {"tcp_close", native_tcp_close,  1},
+   {"channel",   native_channel,    1},
+   {"send",      native_send,       2},
+   {"receive",   native_receive,    1},
+   {"close_channel", native_close_channel, 1},
+   {"isolate",   native_isolate,    2},
+   {"isolate_channel", native_isolate_channel, 0},
+   {"parallel_map", native_parallel_map, 2},
+   {"parallel_reduce", native_parallel_reduce, 3},
+   {"allocation_sites", native_allocation_sites, 1},
+};
 
 /* API Implementation */
 
-static ObjectNative *new_native(NativeFunction func){
+static ObjectNative *new_native(NativeFunction func, int32_t arity){
    ObjectNative *native = (ObjectNative*)ant_object.allocate(sizeof(ObjectNative), OBJ_NATIVE);
-   native->func = func;
+   native->func  = func;
+   native->arity = arity;
 
    return native;
 }
@@ -50,14 +177,48 @@ static int32_t print_native(void){
 }
 
 static void register_all_natives(VM *vm){
-   define_native_function(vm, "clock", native_clock);
+   ant_f64_kernels.detect();
+
+   for(size_t i = 0; i < sizeof(natives) / sizeof(natives[0]); i++){
+      define_native_function(vm, natives[i].name, natives[i].func, natives[i].arity);
+   }
+}
+
+/* */
+
+static void register_native_names(void){
+   for(size_t i = 0; i < sizeof(natives) / sizeof(natives[0]); i++){
+      ObjectString *name = ant_string.new(natives[i].name, (int32_t)strlen(natives[i].name));
+      ant_mapping.add(name);
+   }
+}
+
+/* natives sit in the first globals in table order, so the index is also their global slot */
+
+static int32_t native_index(ObjectNative *native){
+   for(size_t i = 0; i < sizeof(natives) / sizeof(natives[0]); i++){
+      if(natives[i].func == native->func){
+         return (int32_t)i;
+      }
+   }
+
+   return -1;
+}
+
+/* */
+
+static const char *native_name(ObjectNative *native){
+   int32_t index = native_index(native);
+   return index < 0 ? "native" : natives[index].name;
 }
 
 /* Private */
 
-static void define_native_function(VM *vm, const char *name, NativeFunction func) {
+static void define_native_function(VM *vm, const char *name, NativeFunction func, int32_t arity) {
+   Stack *stack = vm->stack;
+
    ObjectString *func_name    = ant_string.new(name, (int32_t)strlen(name));
-   ObjectNative *native_func  = ant_native.new(func);
+   ObjectNative *native_func  = ant_native.new(func, arity);
 
    STACK_PUSH(ant_value.from_object(ant_string.as_object(func_name)));
    STACK_PUSH(ant_value.from_object(ant_native.as_object(native_func)));
@@ -71,6 +232,630 @@ static void define_native_function(VM *vm, const char *name, NativeFunction func
 
 /* Native Functions */
 
-static Value native_clock(int32_t arg_count, Value *args){
+static Value native_clock(VM *vm, int32_t arg_count, Value *args){
+   (void)vm;
    return ant_value.from_number((double)clock()/CLOCKS_PER_SEC);
 }
+
+/* length(list), length(string), length(f64array) or length(map) */
+
+static Value native_length(VM *vm, int32_t arg_count, Value *args){
+
+   if(OBJECT_IS_LIST(args[0])){
+      return ant_value.from_number(LIST_FROM_VALUE(args[0])->items.count);
+   }
+
+   if(OBJECT_IS_STRING(args[0])){
+      return ant_value.from_number(STRING_FROM_VALUE(args[0])->length);
+   }
+
+   if(OBJECT_IS_F64ARRAY(args[0])){
+      return ant_value.from_number(F64_ARRAY_FROM_VALUE(args[0])->length);
+   }
+
+   if(OBJECT_IS_MAP(args[0])){
+      return ant_value.from_number(MAP_FROM_VALUE(args[0])->count);
+   }
+
+   ant_vm.runtime_error(vm, "length() expects a list, a string, a f64array or a map");
+   return ant_value.make_undefined();
+}
+
+/* push(list, value) returns the new length */
+
+static Value native_push(VM *vm, int32_t arg_count, Value *args){
+
+   if(!OBJECT_IS_LIST(args[0])){
+      ant_vm.runtime_error(vm, "push() expects a list as first argument");
+      return ant_value.make_undefined();
+   }
+
+   ObjectList *list = LIST_FROM_VALUE(args[0]);
+   ant_list.append(list, args[1]);
+
+   return ant_value.from_number(list->items.count);
+}
+
+/* pop(list) returns the removed last item */
+
+static Value native_pop(VM *vm, int32_t arg_count, Value *args){
+
+   if(!OBJECT_IS_LIST(args[0])){
+      ant_vm.runtime_error(vm, "pop() expects a list");
+      return ant_value.make_undefined();
+   }
+
+   Value item;
+
+   if(!ant_list.pop(LIST_FROM_VALUE(args[0]), &item)){
+      ant_vm.runtime_error(vm, "pop() from an empty list");
+      return ant_value.make_undefined();
+   }
+
+   return item;
+}
+
+/* f64array natives */
+
+/* f64array(length) is zero filled, f64array(list) copies a list of numbers */
+
+static Value native_f64array(VM *vm, int32_t arg_count, Value *args){
+
+   if(VALUE_IS_NUMBER(args[0])){
+      double length = VALUE_AS_NUMBER(args[0]);
+
+      if(length < 0 || length != (double)(int32_t)length){
+         ant_vm.runtime_error(vm, "f64array() length must be a positive integer");
+         return ant_value.make_undefined();
+      }
+
+      ObjectF64Array *array = ant_f64_array.new((int32_t)length);
+      return ant_value.from_object(ant_f64_array.as_object(array));
+   }
+
+   if(!OBJECT_IS_LIST(args[0])){
+      ant_vm.runtime_error(vm, "f64array() expects a length or a list of numbers");
+      return ant_value.make_undefined();
+   }
+
+   ObjectList *list = LIST_FROM_VALUE(args[0]);
+
+   for(int32_t i = 0; i < list->items.count; i++){
+      if(!VALUE_IS_NUMBER(list->items.values[i])){
+         ant_vm.runtime_error(vm, "f64array() list item %d is not a number", i);
+         return ant_value.make_undefined();
+      }
+   }
+
+   ObjectF64Array *array = ant_f64_array.new(list->items.count);
+
+   for(int32_t i = 0; i < list->items.count; i++){
+      array->values[i] = VALUE_AS_NUMBER(list->items.values[i]);
+   }
+
+   return ant_value.from_object(ant_f64_array.as_object(array));
+}
+
+/* */
+
+static Value native_sum(VM *vm, int32_t arg_count, Value *args){
+   if(!check_f64_arrays(vm, "sum", args, 1)){
+      return ant_value.make_undefined();
+   }
+
+   ObjectF64Array *x = F64_ARRAY_FROM_VALUE(args[0]);
+   return ant_value.from_number(ant_f64_kernels.sum(x->values, x->length));
+}
+
+/* */
+
+static Value native_dot(VM *vm, int32_t arg_count, Value *args){
+   if(!check_f64_arrays(vm, "dot", args, 2)){
+      return ant_value.make_undefined();
+   }
+
+   ObjectF64Array *x = F64_ARRAY_FROM_VALUE(args[0]);
+   ObjectF64Array *y = F64_ARRAY_FROM_VALUE(args[1]);
+   return ant_value.from_number(ant_f64_kernels.dot(x->values, y->values, x->length));
+}
+
+/* */
+
+static Value native_min(VM *vm, int32_t arg_count, Value *args){
+   if(!check_f64_arrays(vm, "min", args, 1)){
+      return ant_value.make_undefined();
+   }
+
+   ObjectF64Array *x = F64_ARRAY_FROM_VALUE(args[0]);
+
+   if(x->length == 0){
+      ant_vm.runtime_error(vm, "min() of an empty f64array");
+      return ant_value.make_undefined();
+   }
+
+   return ant_value.from_number(ant_f64_kernels.min(x->values, x->length));
+}
+
+/* */
+
+static Value native_max(VM *vm, int32_t arg_count, Value *args){
+   if(!check_f64_arrays(vm, "max", args, 1)){
+      return ant_value.make_undefined();
+   }
+
+   ObjectF64Array *x = F64_ARRAY_FROM_VALUE(args[0]);
+
+   if(x->length == 0){
+      ant_vm.runtime_error(vm, "max() of an empty f64array");
+      return ant_value.make_undefined();
+   }
+
+   return ant_value.from_number(ant_f64_kernels.max(x->values, x->length));
+}
+
+/* scale(x, k) scales x in place and returns it */
+
+static Value native_scale(VM *vm, int32_t arg_count, Value *args){
+   if(!check_f64_arrays(vm, "scale", args, 1)){
+      return ant_value.make_undefined();
+   }
+
+   if(!VALUE_IS_NUMBER(args[1])){
+      ant_vm.runtime_error(vm, "scale() expects a number as second argument");
+      return ant_value.make_undefined();
+   }
+
+   ObjectF64Array *x = F64_ARRAY_FROM_VALUE(args[0]);
+   ant_f64_kernels.scale(x->values, VALUE_AS_NUMBER(args[1]), x->length);
+   return args[0];
+}
+
+/* axpy(a, x, y) computes y = a * x + y in place and returns y */
+
+static Value native_axpy(VM *vm, int32_t arg_count, Value *args){
+   if(!VALUE_IS_NUMBER(args[0])){
+      ant_vm.runtime_error(vm, "axpy() expects a number as first argument");
+      return ant_value.make_undefined();
+   }
+
+   if(!check_f64_arrays(vm, "axpy", args + 1, 2)){
+      return ant_value.make_undefined();
+   }
+
+   ObjectF64Array *x = F64_ARRAY_FROM_VALUE(args[1]);
+   ObjectF64Array *y = F64_ARRAY_FROM_VALUE(args[2]);
+   ant_f64_kernels.axpy(VALUE_AS_NUMBER(args[0]), x->values, y->values, x->length);
+   return args[2];
+}
+
+/* */
+
+static Value native_vec_add(VM *vm, int32_t arg_count, Value *args){
+   return elementwise(vm, "vec_add", args, ant_f64_kernels.add);
+}
+
+static Value native_vec_sub(VM *vm, int32_t arg_count, Value *args){
+   return elementwise(vm, "vec_sub", args, ant_f64_kernels.sub);
+}
+
+static Value native_vec_mul(VM *vm, int32_t arg_count, Value *args){
+   return elementwise(vm, "vec_mul", args, ant_f64_kernels.mul);
+}
+
+static Value native_vec_div(VM *vm, int32_t arg_count, Value *args){
+   return elementwise(vm, "vec_div", args, ant_f64_kernels.div);
+}
+
+/* all count args must be f64arrays of the same length */
+
+static bool check_f64_arrays(VM *vm, const char *name, Value *args, int32_t count){
+
+   for(int32_t i = 0; i < count; i++){
+      if(!OBJECT_IS_F64ARRAY(args[i])){
+         ant_vm.runtime_error(vm, "%s() expects f64array arguments", name);
+         return false;
+      }
+
+      if(F64_ARRAY_FROM_VALUE(args[i])->length != F64_ARRAY_FROM_VALUE(args[0])->length){
+         ant_vm.runtime_error(vm, "%s() f64arrays must have the same length", name);
+         return false;
+      }
+   }
+
+   return true;
+}
+
+/* returns a new f64array with kernel(a, b) */
+
+static Value elementwise(VM *vm, const char *name, Value *args,
+                         void (*kernel)(const double *, const double *, double *, int32_t)){
+
+   if(!check_f64_arrays(vm, name, args, 2)){
+      return ant_value.make_undefined();
+   }
+
+   ObjectF64Array *a   = F64_ARRAY_FROM_VALUE(args[0]);
+   ObjectF64Array *b   = F64_ARRAY_FROM_VALUE(args[1]);
+   ObjectF64Array *out = ant_f64_array.new(a->length);
+
+   kernel(a->values, b->values, out->values, a->length);
+   return ant_value.from_object(ant_f64_array.as_object(out));
+}
+
+/* map natives */
+
+/* has(map, key) */
+
+static Value native_has(VM *vm, int32_t arg_count, Value *args){
+
+   if(!OBJECT_IS_MAP(args[0])){
+      ant_vm.runtime_error(vm, "has() expects a map as first argument");
+      return ant_value.make_undefined();
+   }
+
+   Value value;
+   return ant_value.from_bool(ant_map.get(MAP_FROM_VALUE(args[0]), args[1], &value));
+}
+
+/* delete(map, key) returns true if the key was in the map */
+
+static Value native_delete(VM *vm, int32_t arg_count, Value *args){
+
+   if(!OBJECT_IS_MAP(args[0])){
+      ant_vm.runtime_error(vm, "delete() expects a map as first argument");
+      return ant_value.make_undefined();
+   }
+
+   return ant_value.from_bool(ant_map.delete(MAP_FROM_VALUE(args[0]), args[1]));
+}
+
+/* keys(map) returns a new list, in no particular order */
+
+static Value native_keys(VM *vm, int32_t arg_count, Value *args){
+
+   if(!OBJECT_IS_MAP(args[0])){
+      ant_vm.runtime_error(vm, "keys() expects a map");
+      return ant_value.make_undefined();
+   }
+
+   ObjectList *list = ant_list.new();
+   int32_t cursor = 0;
+   Value key, value;
+
+   while(ant_map.next(MAP_FROM_VALUE(args[0]), &cursor, &key, &value)){
+      ant_list.append(list, key);
+   }
+
+   return ant_value.from_object(LIST_AS_OBJECT(list));
+}
+
+/* values(map) returns a new list, in the same order as keys(map) */
+
+static Value native_values(VM *vm, int32_t arg_count, Value *args){
+
+   if(!OBJECT_IS_MAP(args[0])){
+      ant_vm.runtime_error(vm, "values() expects a map");
+      return ant_value.make_undefined();
+   }
+
+   ObjectList *list = ant_list.new();
+   int32_t cursor = 0;
+   Value key, value;
+
+   while(ant_map.next(MAP_FROM_VALUE(args[0]), &cursor, &key, &value)){
+      ant_list.append(list, value);
+   }
+
+   return ant_value.from_object(LIST_AS_OBJECT(list));
+}
+
+/* fiber natives */
+
+/* fiber(fn) wraps a function taking at most one argument, it runs on the first resume */
+
+static Value native_fiber(VM *vm, int32_t arg_count, Value *args){
+
+   if(!OBJECT_IS_CLOSURE(args[0]) || CLOSURE_FROM_VALUE(args[0])->func->arity > 1){
+      ant_vm.runtime_error(vm, "fiber() expects a function taking 0 or 1 arguments");
+      return ant_value.make_undefined();
+   }
+
+   ObjectFiber *fiber = ant_fiber.new(CLOSURE_FROM_VALUE(args[0]));
+   return ant_value.from_object(ant_fiber.as_object(fiber));
+}
+
+/* resume(fiber, value) switches to the fiber, the nil returned is replaced by what it yields */
+
+static Value native_resume(VM *vm, int32_t arg_count, Value *args){
+
+   if(!OBJECT_IS_FIBER(args[0])){
+      ant_vm.runtime_error(vm, "resume() expects a fiber as first argument");
+      return ant_value.make_undefined();
+   }
+
+   if(!ant_fiber.resume(vm, FIBER_FROM_VALUE(args[0]), args[1])){
+      return ant_value.make_undefined();
+   }
+
+   return ant_value.make_nil();
+}
+
+/* yield(value) switches back to the caller, the nil returned is replaced by the next resume */
+
+static Value native_yield(VM *vm, int32_t arg_count, Value *args){
+
+   if(!ant_fiber.yield(vm, args[0])){
+      return ant_value.make_undefined();
+   }
+
+   return ant_value.make_nil();
+}
+
+/* done(fiber) is true once the fiber function returned */
+
+static Value native_done(VM *vm, int32_t arg_count, Value *args){
+
+   if(!OBJECT_IS_FIBER(args[0])){
+      ant_vm.runtime_error(vm, "done() expects a fiber");
+      return ant_value.make_undefined();
+   }
+
+   return ant_value.from_bool(FIBER_FROM_VALUE(args[0])->state == FIBER_DONE);
+}
+
+/* event loop natives, see event_loop.h. Inside a fiber they park it and return nil at first */
+
+/* sleep(ms) */
+
+static Value native_sleep(VM *vm, int32_t arg_count, Value *args){
+
+   if(!VALUE_IS_NUMBER(args[0]) || VALUE_AS_NUMBER(args[0]) < 0){
+      ant_vm.runtime_error(vm, "sleep() expects a positive number of milliseconds");
+      return ant_value.make_undefined();
+   }
+
+   return ant_event_loop.sleep(vm, VALUE_AS_NUMBER(args[0]));
+}
+
+/* timer(ms, fn) runs fn in a new fiber after ms and returns the fiber */
+
+static Value native_timer(VM *vm, int32_t arg_count, Value *args){
+
+   if(!VALUE_IS_NUMBER(args[0]) || VALUE_AS_NUMBER(args[0]) < 0){
+      ant_vm.runtime_error(vm, "timer() expects a positive number of milliseconds");
+      return ant_value.make_undefined();
+   }
+
+   if(!OBJECT_IS_CLOSURE(args[1]) || CLOSURE_FROM_VALUE(args[1])->func->arity > 1){
+      ant_vm.runtime_error(vm, "timer() expects a function taking 0 or 1 arguments");
+      return ant_value.make_undefined();
+   }
+
+   return ant_event_loop.spawn(vm, CLOSURE_FROM_VALUE(args[1]), VALUE_AS_NUMBER(args[0]));
+}
+
+/* spawn(fn) runs fn in a new fiber on the next turn of the loop */
+
+static Value native_spawn(VM *vm, int32_t arg_count, Value *args){
+
+   if(!OBJECT_IS_CLOSURE(args[0]) || CLOSURE_FROM_VALUE(args[0])->func->arity > 1){
+      ant_vm.runtime_error(vm, "spawn() expects a function taking 0 or 1 arguments");
+      return ant_value.make_undefined();
+   }
+
+   return ant_event_loop.spawn(vm, CLOSURE_FROM_VALUE(args[0]), 0);
+}
+
+/* read_file_async(path) returns the contents, nil if the file can't be read */
+
+static Value native_read_file_async(VM *vm, int32_t arg_count, Value *args){
+
+   if(!OBJECT_IS_STRING(args[0])){
+      ant_vm.runtime_error(vm, "read_file_async() expects a path");
+      return ant_value.make_undefined();
+   }
+
+   return ant_event_loop.read_file(vm, STRING_FROM_VALUE(args[0]));
+}
+
+/* tcp_connect(port) connects to localhost, returns the socket or nil */
+
+static Value native_tcp_connect(VM *vm, int32_t arg_count, Value *args){
+   double port = VALUE_IS_NUMBER(args[0]) ? VALUE_AS_NUMBER(args[0]) : -1;
+
+   if(port < 1 || port > 65535 || port != (double)(int32_t)port){
+      ant_vm.runtime_error(vm, "tcp_connect() expects a port number");
+      return ant_value.make_undefined();
+   }
+
+   return ant_event_loop.connect(vm, (int32_t)port);
+}
+
+/* tcp_read(socket) returns what arrived, an empty string at the end, nil on errors */
+
+static Value native_tcp_read(VM *vm, int32_t arg_count, Value *args){
+
+   if(!check_fd(vm, "tcp_read", args[0])){
+      return ant_value.make_undefined();
+   }
+
+   return ant_event_loop.read(vm, (int32_t)VALUE_AS_NUMBER(args[0]));
+}
+
+/* tcp_write(socket, string) returns the bytes written, nil on errors */
+
+static Value native_tcp_write(VM *vm, int32_t arg_count, Value *args){
+
+   if(!check_fd(vm, "tcp_write", args[0])){
+      return ant_value.make_undefined();
+   }
+
+   if(!OBJECT_IS_STRING(args[1])){
+      ant_vm.runtime_error(vm, "tcp_write() expects a string as second argument");
+      return ant_value.make_undefined();
+   }
+
+   return ant_event_loop.write(vm, (int32_t)VALUE_AS_NUMBER(args[0]), STRING_FROM_VALUE(args[1]));
+}
+
+/* tcp_close(socket) */
+
+static Value native_tcp_close(VM *vm, int32_t arg_count, Value *args){
+
+   if(!check_fd(vm, "tcp_close", args[0])){
+      return ant_value.make_undefined();
+   }
+
+   ant_event_loop.close(vm, (int32_t)VALUE_AS_NUMBER(args[0]));
+   return ant_value.make_nil();
+}
+
+/* isolate natives, see isolate.h and channel.h */
+
+/* channel(capacity) */
+
+static Value native_channel(VM *vm, int32_t arg_count, Value *args){
+   double capacity = VALUE_IS_NUMBER(args[0]) ? VALUE_AS_NUMBER(args[0]) : 0;
+
+   if(capacity < 1 || capacity > INT32_MAX || capacity != (double)(int32_t)capacity){
+      ant_vm.runtime_error(vm, "channel() expects a capacity of at least 1");
+      return ant_value.make_undefined();
+   }
+
+   ObjectChannel *channel = ant_channel.wrap(ant_channel.new((int32_t)capacity));
+   return ant_value.from_object(ant_channel.as_object(channel));
+}
+
+/* send(channel, value) waits while the channel is full, false if it is closed */
+
+static Value native_send(VM *vm, int32_t arg_count, Value *args){
+
+   if(!OBJECT_IS_CHANNEL(args[0])){
+      ant_vm.runtime_error(vm, "send() expects a channel as first argument");
+      return ant_value.make_undefined();
+   }
+
+   return ant_channel.send(vm, CHANNEL_FROM_VALUE(args[0])->channel, args[1]);
+}
+
+/* receive(channel) waits while the channel is empty, nil once it is closed and empty */
+
+static Value native_receive(VM *vm, int32_t arg_count, Value *args){
+
+   if(!OBJECT_IS_CHANNEL(args[0])){
+      ant_vm.runtime_error(vm, "receive() expects a channel");
+      return ant_value.make_undefined();
+   }
+
+   return ant_channel.receive(vm, CHANNEL_FROM_VALUE(args[0])->channel);
+}
+
+/* close_channel(channel) */
+
+static Value native_close_channel(VM *vm, int32_t arg_count, Value *args){
+
+   if(!OBJECT_IS_CHANNEL(args[0])){
+      ant_vm.runtime_error(vm, "close_channel() expects a channel");
+      return ant_value.make_undefined();
+   }
+
+   ant_channel.close(CHANNEL_FROM_VALUE(args[0])->channel);
+   return ant_value.make_nil();
+}
+
+/* isolate(path, channel) runs the script at path on a new thread, channel can be nil */
+
+static Value native_isolate(VM *vm, int32_t arg_count, Value *args){
+
+   if(!OBJECT_IS_STRING(args[0])){
+      ant_vm.runtime_error(vm, "isolate() expects a path as first argument");
+      return ant_value.make_undefined();
+   }
+
+   if(!OBJECT_IS_CHANNEL(args[1]) && !VALUE_IS_NIL(args[1])){
+      ant_vm.runtime_error(vm, "isolate() expects a channel or nil as second argument");
+      return ant_value.make_undefined();
+   }
+
+   Channel *channel = VALUE_IS_NIL(args[1]) ? NULL : CHANNEL_FROM_VALUE(args[1])->channel;
+
+   if(!ant_isolate.spawn(vm, STRING_FROM_VALUE(args[0]), channel)){
+      return ant_value.make_undefined();
+   }
+
+   return ant_value.make_nil();
+}
+
+/* isolate_channel() is the channel the isolate was started with, nil otherwise */
+
+static Value native_isolate_channel(VM *vm, int32_t arg_count, Value *args){
+
+   if(vm->channel == NULL){
+      return ant_value.make_nil();
+   }
+
+   ant_channel.retain(vm->channel);
+   return ant_value.from_object(ant_channel.as_object(ant_channel.wrap(vm->channel)));
+}
+
+/* parallel natives, see parallel.h */
+
+/* parallel_map(list, fn) is a new list of fn(item) for each item, fn runs on the worker threads */
+
+static Value native_parallel_map(VM *vm, int32_t arg_count, Value *args){
+
+   if(!OBJECT_IS_LIST(args[0])){
+      ant_vm.runtime_error(vm, "parallel_map() expects a list as first argument");
+      return ant_value.make_undefined();
+   }
+
+   if(!OBJECT_IS_CLOSURE(args[1]) || CLOSURE_FROM_VALUE(args[1])->func->arity != 1){
+      ant_vm.runtime_error(vm, "parallel_map() expects a function taking 1 argument");
+      return ant_value.make_undefined();
+   }
+
+   return ant_parallel.map(vm, LIST_FROM_VALUE(args[0]), CLOSURE_FROM_VALUE(args[1]));
+}
+
+/* parallel_reduce(list, fn, initial) folds the items with fn(accumulated, item) */
+
+static Value native_parallel_reduce(VM *vm, int32_t arg_count, Value *args){
+
+   if(!OBJECT_IS_LIST(args[0])){
+      ant_vm.runtime_error(vm, "parallel_reduce() expects a list as first argument");
+      return ant_value.make_undefined();
+   }
+
+   if(!OBJECT_IS_CLOSURE(args[1]) || CLOSURE_FROM_VALUE(args[1])->func->arity != 2){
+      ant_vm.runtime_error(vm, "parallel_reduce() expects a function taking 2 arguments");
+      return ant_value.make_undefined();
+   }
+
+   return ant_parallel.reduce(vm, LIST_FROM_VALUE(args[0]), CLOSURE_FROM_VALUE(args[1]), args[2]);
+}
+
+/* allocation_sites(limit) lists the top sites so far, nil unless run with ant --alloc-sites */
+
+static Value native_allocation_sites(VM *vm, int32_t arg_count, Value *args){
+   double limit = VALUE_IS_NUMBER(args[0]) ? VALUE_AS_NUMBER(args[0]) : -1;
+
+   if(limit < 0 || limit != (double)(int32_t)limit){
+      ant_vm.runtime_error(vm, "allocation_sites() expects a count of sites");
+      return ant_value.make_undefined();
+   }
+
+   return ant_alloc_sites.report(vm, (int32_t)limit);
+}
+
+/* */
+
+static bool check_fd(VM *vm, const char *name, Value value){
+   double fd = VALUE_IS_NUMBER(value) ? VALUE_AS_NUMBER(value) : -1;
+
+   if(fd < 0 || fd != (double)(int32_t)fd){
+      ant_vm.runtime_error(vm, "%s() expects a socket", name);
+      return false;
+   }
+
+   return true;
+}
@@ -3,6 +3,13 @@
 #include "functions.h"
 #include "memory.h"
 #include "natives.h"
+#include "list.h"
+#include "map.h"
+#include "f64_array.h"
+#include "fiber.h"
+#include "channel.h"
+#include "context.h"
+#include "alloc_sites.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -10,35 +17,66 @@
   (type *)allocate_object(sizeof(type), objectType)
 
 static ObjectType get_type(Value value);
+static const char *type_name(ObjectType type);
 static bool is_string(Value value);
 static bool is_function(Value value);
 static bool is_native(Value value);
 static bool is_closure(Value value);
+static bool is_list(Value value);
+static bool is_map(Value value);
 
 static bool is_object_type(Value value, ObjectType type);
 static int32_t print_object(Value value, bool debug);
+static bool enter_object(Object *object);
+static void leave_object(void);
 
 static Object *allocate_object(size_t size, ObjectType object_type);
 static void free_object(Object *object);
 
 ObjectAPI ant_object = {
     .type = get_type,
+    .type_name = type_name,
     .is_string = is_string,
     .is_function = is_function,
     .is_native = is_native,
     .is_closure = is_closure,
+    .is_list = is_list,
+    .is_map = is_map,
     .print = print_object,
+    .enter = enter_object,
+    .leave = leave_object,
     .allocate = allocate_object,
     .free = free_object,
 };
 
+/* per thread, isolates and parallel workers print on their own */
+static _Thread_local Object *printing[OPTION_PRINT_DEPTH_MAX];
+static _Thread_local int32_t printing_count = 0;
+
 /* */
 
 static ObjectType get_type(Value value) {
   return ant_value.as_object(value)->type;
 }
 
-/* */
+/* for messages, lowercase like the natives creating them */
+
+static const char *type_name(ObjectType type) {
+  switch (type) {
+  case OBJ_STRING:   return "string";
+  case OBJ_FUNCTION: return "function";
+  case OBJ_CLOSURE:  return "closure";
+  case OBJ_NATIVE:   return "native";
+  case OBJ_UPVALUE:  return "upvalue";
+  case OBJ_LIST:     return "list";
+  case OBJ_F64ARRAY: return "f64array";
+  case OBJ_MAP:      return "map";
+  case OBJ_FIBER:    return "fiber";
+  case OBJ_CHANNEL:  return "channel";
+  }
+
+  return "object";
+}
 
 static bool is_string(Value value) { return is_object_type(value, OBJ_STRING); }
 static bool is_function(Value value) {
@@ -48,6 +86,8 @@ static bool is_native(Value value) { return is_object_type(value, OBJ_NATIVE); }
 static bool is_closure(Value value) {
   return is_object_type(value, OBJ_CLOSURE);
 }
+static bool is_list(Value value) { return is_object_type(value, OBJ_LIST); }
+static bool is_map(Value value) { return is_object_type(value, OBJ_MAP); }
 
 /* */
 
@@ -65,6 +105,10 @@ static Object *allocate_object(size_t size, ObjectType object_type) {
 
   object->type = object_type;
 
+  if (CURRENT_CONTEXT()->sites != NULL) {
+    ant_alloc_sites.record(CURRENT_CONTEXT()->sites, object_type, size, 1);
+  }
+
   return ant_memory.add_object(object);
 }
 
@@ -88,18 +132,58 @@ static int32_t print_object(Value value, bool debug) {
   case OBJ_UPVALUE:
     return printf("Upvalue");
 
+  case OBJ_LIST:
+    return ant_list.print(ant_list.from_value(value), debug);
+
+  case OBJ_F64ARRAY:
+    return ant_f64_array.print(ant_f64_array.from_value(value));
+
+  case OBJ_MAP:
+    return ant_map.print(ant_map.from_value(value), debug);
+
+  case OBJ_FIBER:
+    return ant_fiber.print(ant_fiber.from_value(value));
+
+  case OBJ_CHANNEL:
+    return ant_channel.print(ant_channel.from_value(value));
+
   default:
     fprintf(stderr, "Error: Attempted to print object of unkown type.\n");
     return 0;
   }
 }
 
+/* */
+
+static bool enter_object(Object *object) {
+  if (printing_count == OPTION_PRINT_DEPTH_MAX) {
+    return false;
+  }
+
+  for (int32_t i = 0; i < printing_count; i++) {
+    if (printing[i] == object) {
+      return false;
+    }
+  }
+
+  printing[printing_count++] = object;
+  return true;
+}
+
+static void leave_object(void) { printing_count--; }
+
 static void free_object(Object *object) {
 
   switch (object->type) {
   case OBJ_STRING: {
     ObjectString *string = (ObjectString *)object;
-    FREE_ARRAY(char, string->chars, string->length + 1);
+
+    if (string->shared != NULL) {
+      ant_string.release_shared(string->shared);
+    } else {
+      FREE_ARRAY(char, string->chars, string->length + 1);
+    }
+
     FREE(ObjectString, string);
     break;
   }
@@ -133,6 +217,41 @@ static void free_object(Object *object) {
     break;
   }
 
+  case OBJ_LIST: {
+    ObjectList *list = (ObjectList *)object;
+    ant_value_array.free(&list->items);
+    FREE(ObjectList, list);
+    break;
+  }
+
+  case OBJ_F64ARRAY: {
+    ObjectF64Array *array = (ObjectF64Array *)object;
+    FREE_ARRAY(double, array->values, array->length);
+    FREE(ObjectF64Array, array);
+    break;
+  }
+
+  case OBJ_MAP: {
+    ObjectMap *map = (ObjectMap *)object;
+    ant_table.free(&map->table);
+    FREE(ObjectMap, map);
+    break;
+  }
+
+  case OBJ_FIBER: {
+    ObjectFiber *fiber = (ObjectFiber *)object;
+    ant_fiber.release(fiber);
+    FREE(ObjectFiber, fiber);
+    break;
+  }
+
+  case OBJ_CHANNEL: {
+    ObjectChannel *channel = (ObjectChannel *)object;
+    ant_channel.release(channel->channel);
+    FREE(ObjectChannel, channel);
+    break;
+  }
+
   default:
     fprintf(stderr, "Error: Attempted to free object of unkown type: %d\n",
             object->type);
@@ -0,0 +1,564 @@
+#include "parallel.h"
+#include "message.h"
+#include "memory.h"
+#include "context.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+typedef enum {
+   JOB_MAP,
+   JOB_REDUCE,
+   JOB_COMBINE,   /* folds the chunk results of a reduce, a single chunk */
+}JobKind;
+
+typedef struct {
+   JobKind         kind;
+   ObjectList*     list;           /* items, in the heap of the caller */
+   ObjectClosure*  closure;
+   Value           initial;
+   AntContext*     context;        /* of the caller, parent of the worker contexts */
+   Value*          globals;        /* of the caller */
+   int32_t         global_count;
+   int32_t         chunk_size;
+   int32_t         chunk_count;
+   Message*        inputs;         /* chunk results a combine folds */
+   int32_t         input_count;
+   Message*        results;        /* one per item for a map, per chunk otherwise */
+   int32_t         remaining;      /* chunks not done, under the pool lock */
+   atomic_bool     failed;         /* later chunks are skipped */
+}Job;
+
+typedef struct {
+   Job*     job;
+   int32_t  chunk;
+}Task;
+
+/* the owner works from the back, thieves take from the front */
+typedef struct {
+   pthread_mutex_t  lock;
+   Task*            tasks;   /* ring */
+   int32_t          head;
+   int32_t          count;
+   int32_t          capacity;
+}Deque;
+
+typedef struct Worker {
+   pthread_t     thread;
+   int32_t       index;
+   Deque         deque;
+   struct Pool*  pool;
+}Worker;
+
+typedef struct Pool {
+   Worker*          workers;
+   int32_t          count;
+   int32_t          next;         /* deque the next job starts filling */
+   pthread_mutex_t  lock;         /* queued, next, shutting_down and the remaining of the jobs */
+   pthread_cond_t   work;
+   pthread_cond_t   done;
+   int32_t          queued;       /* tasks in the deques no worker claimed yet */
+   bool             shutting_down;
+}Pool;
+
+static Value  parallel_map(VM *vm, ObjectList *list, ObjectClosure *closure);
+static Value  parallel_reduce(VM *vm, ObjectList *list, ObjectClosure *closure, Value initial);
+static bool   start_pool(int32_t thread_count);
+static void   stop_pool(void);
+
+const ParallelAPI ant_parallel = {
+   .map = parallel_map,
+   .reduce = parallel_reduce,
+   .start = start_pool,
+   .stop = stop_pool,
+};
+
+/* one pool for the process, shared by the VMs of every thread */
+static Pool              *shared_pool = NULL;
+static pthread_mutex_t   pool_start   = PTHREAD_MUTEX_INITIALIZER;
+static _Thread_local bool in_worker   = false;
+
+/* Private */
+static Pool    *get_pool(VM *vm, const char *name);
+static void     init_job(Job *job, JobKind kind, Pool *pool, VM *vm, ObjectList *list, ObjectClosure *closure);
+static bool     run_job(VM *vm, Pool *pool, Job *job, const char *name);
+static void    *work(void *arg);
+static Task     take_task(Pool *pool, Worker *worker);
+static void     run_chunk(VM *vm, Task task);
+static bool     map_chunk(VM *vm, Job *job, int32_t from, int32_t to);
+static bool     reduce_chunk(VM *vm, Job *job, int32_t chunk, int32_t from, int32_t to);
+static bool     combine(VM *vm, Job *job);
+static void     push_task(Deque *deque, Task task);
+static bool     pop_back(Deque *deque, Task *task);
+static bool     pop_front(Deque *deque, Task *task);
+
+/* Implementation */
+
+static Value parallel_map(VM *vm, ObjectList *list, ObjectClosure *closure){
+   Pool *pool = get_pool(vm, "parallel_map");
+
+   if(pool == NULL){
+      return ant_value.make_undefined();
+   }
+
+   Job job;
+   init_job(&job, JOB_MAP, pool, vm, list, closure);
+   job.results = ALLOCATE(Message, list->items.count);
+   memset(job.results, 0, sizeof(Message) * list->items.count);
+
+   bool ok = run_job(vm, pool, &job, "parallel_map");
+   ObjectList *mapped = ant_list.new();
+
+   for(int32_t i = 0; i < list->items.count; i++){
+      if(ok){
+         ant_list.append(mapped, ant_message.decode(&job.results[i]));
+      } else {
+         ant_message.free(&job.results[i]);
+      }
+   }
+
+   FREE_ARRAY(Message, job.results, list->items.count);
+   return ok ? ant_value.from_object(LIST_AS_OBJECT(mapped)) : ant_value.make_undefined();
+}
+
+/* the chunk results are folded by one more job of a single chunk */
+
+static Value parallel_reduce(VM *vm, ObjectList *list, ObjectClosure *closure, Value initial){
+   Pool *pool = get_pool(vm, "parallel_reduce");
+
+   if(pool == NULL || !ant_message.check(vm, initial, "parallel_reduce")){
+      return ant_value.make_undefined();
+   }
+
+   if(list->items.count == 0){
+      return initial;
+   }
+
+   Job job;
+   init_job(&job, JOB_REDUCE, pool, vm, list, closure);
+   job.initial = initial;
+   job.results = ALLOCATE(Message, job.chunk_count);
+   memset(job.results, 0, sizeof(Message) * job.chunk_count);
+
+   bool ok = run_job(vm, pool, &job, "parallel_reduce");
+
+   if(ok && job.chunk_count > 1){
+      Job fold;
+
+      init_job(&fold, JOB_COMBINE, pool, vm, list, closure);
+      fold.chunk_count = 1;
+      fold.inputs      = job.results;
+      fold.input_count = job.chunk_count;
+      fold.results     = ALLOCATE(Message, 1);
+      memset(fold.results, 0, sizeof(Message));
+
+      ok = run_job(vm, pool, &fold, "parallel_reduce");
+
+      /* the combine took over every chunk result */
+      FREE_ARRAY(Message, job.results, job.chunk_count);
+      job.results     = fold.results;
+      job.chunk_count = 1;
+   }
+
+   Value result = ok ? ant_message.decode(&job.results[0]) : ant_value.make_undefined();
+
+   for(int32_t i = ok ? 1 : 0; i < job.chunk_count; i++){
+      ant_message.free(&job.results[i]);
+   }
+
+   FREE_ARRAY(Message, job.results, job.chunk_count);
+   return result;
+}
+
+/* */
+
+static bool start_pool(int32_t thread_count){
+   if(thread_count < 1 || thread_count > OPTION_POOL_MAX_THREADS){
+      fprintf(stderr, "Error: Parallel thread count must be between 1 and %d\n", OPTION_POOL_MAX_THREADS);
+      return false;
+   }
+
+   pthread_mutex_lock(&pool_start);
+
+   if(shared_pool != NULL){
+      pthread_mutex_unlock(&pool_start);
+      return false;
+   }
+
+   Pool *started = ALLOCATE(Pool, 1);
+   memset(started, 0, sizeof(Pool));
+
+   pthread_mutex_init(&started->lock, NULL);
+   pthread_cond_init(&started->work, NULL);
+   pthread_cond_init(&started->done, NULL);
+   started->workers = ALLOCATE(Worker, thread_count);
+
+   for(int32_t i = 0; i < thread_count; i++){
+      Worker *worker = &started->workers[i];
+      worker->index  = i;
+      worker->pool   = started;
+      memset(&worker->deque, 0, sizeof(Deque));
+      pthread_mutex_init(&worker->deque.lock, NULL);
+   }
+
+   /* count only grows before any task is queued, workers read it once there is one */
+   for(int32_t i = 0; i < thread_count; i++){
+      if(pthread_create(&started->workers[i].thread, NULL, work, &started->workers[i]) != 0){
+         fprintf(stderr, "Error: Could not start parallel worker %d\n", i);
+         break;
+      }
+      started->count++;
+   }
+
+   shared_pool = started;
+   pthread_mutex_unlock(&pool_start);
+
+   if(started->count == 0){
+      stop_pool();
+      return false;
+   }
+
+   return true;
+}
+
+/* */
+
+static void stop_pool(void){
+   pthread_mutex_lock(&pool_start);
+   Pool *pool = shared_pool;
+
+   if(pool == NULL){
+      pthread_mutex_unlock(&pool_start);
+      return;
+   }
+
+   pthread_mutex_lock(&pool->lock);
+   pool->shutting_down = true;
+   pthread_cond_broadcast(&pool->work);
+   pthread_mutex_unlock(&pool->lock);
+
+   for(int32_t i = 0; i < pool->count; i++){
+      pthread_join(pool->workers[i].thread, NULL);
+   }
+
+   for(int32_t i = 0; i < pool->count; i++){
+      Deque *deque = &pool->workers[i].deque;
+      pthread_mutex_destroy(&deque->lock);
+      FREE_ARRAY(Task, deque->tasks, deque->capacity);
+   }
+
+   pthread_mutex_destroy(&pool->lock);
+   pthread_cond_destroy(&pool->work);
+   pthread_cond_destroy(&pool->done);
+   FREE_ARRAY(Worker, pool->workers, pool->count);
+   FREE(Pool, pool);
+
+   shared_pool = NULL;
+   pthread_mutex_unlock(&pool_start);
+}
+
+/* Private */
+
+/* NULL after a runtime error. A worker waiting on the pool it runs in could wait forever */
+
+static Pool *get_pool(VM *vm, const char *name){
+   if(in_worker){
+      ant_vm.runtime_error(vm, "%s() can't be called from a parallel function", name);
+      return NULL;
+   }
+
+   pthread_mutex_lock(&pool_start);
+   Pool *pool = shared_pool;
+   pthread_mutex_unlock(&pool_start);
+
+   if(pool == NULL){
+      long cores = sysconf(_SC_NPROCESSORS_ONLN);
+      start_pool(cores < 1 ? 1 : cores > OPTION_POOL_MAX_THREADS ? OPTION_POOL_MAX_THREADS : (int32_t)cores);
+
+      pthread_mutex_lock(&pool_start);
+      pool = shared_pool;
+      pthread_mutex_unlock(&pool_start);
+   }
+
+   if(pool == NULL){
+      ant_vm.runtime_error(vm, "%s() could not start its threads", name);
+   }
+
+   return pool;
+}
+
+/* several chunks per worker so the ones done first have something to steal */
+
+static void init_job(Job *job, JobKind kind, Pool *pool, VM *vm, ObjectList *list, ObjectClosure *closure){
+   int32_t count   = list->items.count;
+   int32_t workers = pool->count;
+   int32_t chunks  = workers * OPTION_PARALLEL_CHUNKS_PER_THREAD;
+
+   job->kind         = kind;
+   job->list         = list;
+   job->closure      = closure;
+   job->initial      = ant_value.make_nil();
+   job->context      = vm->context;
+   job->globals      = vm->globals.values;
+   job->global_count = vm->globals.count;
+   job->chunk_size   = count / chunks + (count % chunks != 0);
+   job->chunk_size   = job->chunk_size < 1 ? 1 : job->chunk_size;
+   job->chunk_count  = count / job->chunk_size + (count % job->chunk_size != 0);
+   job->inputs       = NULL;
+   job->input_count  = 0;
+   job->results      = NULL;
+   job->remaining    = 0;
+   atomic_init(&job->failed, false);
+}
+
+/* false after reporting a runtime error, the workers reported theirs */
+
+static bool run_job(VM *vm, Pool *pool, Job *job, const char *name){
+   job->remaining = job->chunk_count;
+
+   pthread_mutex_lock(&pool->lock);
+   int32_t first = pool->next;
+   pool->next    = (pool->next + job->chunk_count) % pool->count;
+   pthread_mutex_unlock(&pool->lock);
+
+   for(int32_t i = 0; i < job->chunk_count; i++){
+      push_task(&pool->workers[(first + i) % pool->count].deque, (Task){.job = job, .chunk = i});
+   }
+
+   pthread_mutex_lock(&pool->lock);
+   pool->queued += job->chunk_count;
+   pthread_cond_broadcast(&pool->work);
+
+   while(job->remaining > 0){
+      pthread_cond_wait(&pool->done, &pool->lock);
+   }
+
+   pthread_mutex_unlock(&pool->lock);
+
+   if(atomic_load(&job->failed)){
+      ant_vm.runtime_error(vm, "%s() function failed in a worker", name);
+      return false;
+   }
+
+   return true;
+}
+
+/* Each worker claims a queued task before looking for one, so there is always one to find.
+ * Its VM lives as long as the pool and is reset after each chunk.
+ */
+
+static void *work(void *arg){
+   Worker *worker = (Worker*)arg;
+   Pool *pool     = worker->pool;
+   VM *vm         = ant_vm.new();
+   in_worker      = true;
+
+   while(true){
+      pthread_mutex_lock(&pool->lock);
+
+      while(pool->queued == 0 && !pool->shutting_down){
+         pthread_cond_wait(&pool->work, &pool->lock);
+      }
+
+      if(pool->queued == 0){
+         pthread_mutex_unlock(&pool->lock);
+         break;
+      }
+
+      pool->queued--;
+      pthread_mutex_unlock(&pool->lock);
+
+      Task task = take_task(pool, worker);
+      run_chunk(vm, task);
+
+      pthread_mutex_lock(&pool->lock);
+
+      if(--task.job->remaining == 0){
+         pthread_cond_broadcast(&pool->done);
+      }
+
+      pthread_mutex_unlock(&pool->lock);
+   }
+
+   ant_vm.free(vm);
+   return NULL;
+}
+
+/* */
+
+static Task take_task(Pool *pool, Worker *worker){
+   Task task;
+
+   while(true){
+      if(pop_back(&worker->deque, &task)){
+         return task;
+      }
+
+      for(int32_t i = 1; i < pool->count; i++){
+         if(pop_front(&pool->workers[(worker->index + i) % pool->count].deque, &task)){
+            return task;
+         }
+      }
+   }
+}
+
+/* the worker VM sees the globals of the caller, as they were when the call started */
+
+static void run_chunk(VM *vm, Task task){
+   Job *job     = task.job;
+   int32_t from = task.chunk * job->chunk_size;
+   int32_t to   = from + job->chunk_size;
+   to           = to > job->list->items.count ? job->list->items.count : to;
+
+   if(atomic_load_explicit(&job->failed, memory_order_relaxed)){
+      return;
+   }
+
+   vm->context->parent = job->context;
+   ant_context.make_current(vm->context);
+
+   for(int32_t i = vm->native_count; i < job->global_count; i++){
+      ant_value_array.write_at(&vm->globals, job->globals[i], i);
+   }
+
+   bool ok = false;
+
+   switch(job->kind){
+      case JOB_MAP:     ok = map_chunk(vm, job, from, to); break;
+      case JOB_REDUCE:  ok = reduce_chunk(vm, job, task.chunk, from, to); break;
+      case JOB_COMBINE: ok = combine(vm, job); break;
+   }
+
+   if(!ok){
+      atomic_store(&job->failed, true);
+   }
+
+   ant_vm.reset(vm);
+}
+
+/* */
+
+static bool map_chunk(VM *vm, Job *job, int32_t from, int32_t to){
+   Value result;
+
+   for(int32_t i = from; i < to; i++){
+      if(ant_vm.call(vm, job->closure, 1, &job->list->items.values[i], &result) != INTERPRET_OK){
+         return false;
+      }
+
+      if(!ant_message.check(vm, result, "parallel_map")){
+         return false;
+      }
+
+      job->results[i] = ant_message.encode(result, MESSAGE_COPY);
+   }
+
+   return true;
+}
+
+/* initial is copied into the worker heap, fn may return it changed */
+
+static bool reduce_chunk(VM *vm, Job *job, int32_t chunk, int32_t from, int32_t to){
+   Message initial = ant_message.encode(job->initial, MESSAGE_COPY);
+   Value args[2]   = {ant_message.decode(&initial)};
+
+   for(int32_t i = from; i < to; i++){
+      args[1] = job->list->items.values[i];
+
+      if(ant_vm.call(vm, job->closure, 2, args, &args[0]) != INTERPRET_OK){
+         return false;
+      }
+   }
+
+   if(!ant_message.check(vm, args[0], "parallel_reduce")){
+      return false;
+   }
+
+   job->results[chunk] = ant_message.encode(args[0], MESSAGE_COPY);
+   return true;
+}
+
+/* every input is decoded first so none is left behind by an error */
+
+static bool combine(VM *vm, Job *job){
+   ObjectList *inputs = ant_list.new();
+
+   for(int32_t i = 0; i < job->input_count; i++){
+      ant_list.append(inputs, ant_message.decode(&job->inputs[i]));
+   }
+
+   Value args[2] = {inputs->items.values[0]};
+
+   for(int32_t i = 1; i < inputs->items.count; i++){
+      args[1] = inputs->items.values[i];
+
+      if(ant_vm.call(vm, job->closure, 2, args, &args[0]) != INTERPRET_OK){
+         return false;
+      }
+   }
+
+   if(!ant_message.check(vm, args[0], "parallel_reduce")){
+      return false;
+   }
+
+   job->results[0] = ant_message.encode(args[0], MESSAGE_COPY);
+   return true;
+}
+
+/* */
+
+static void push_task(Deque *deque, Task task){
+   pthread_mutex_lock(&deque->lock);
+
+   if(deque->count == deque->capacity){
+      int32_t capacity = GROW_CAPACITY(deque->capacity);
+      Task *tasks      = ALLOCATE(Task, capacity);
+
+      for(int32_t i = 0; i < deque->count; i++){
+         tasks[i] = deque->tasks[(deque->head + i) % deque->capacity];
+      }
+
+      FREE_ARRAY(Task, deque->tasks, deque->capacity);
+      deque->tasks    = tasks;
+      deque->capacity = capacity;
+      deque->head     = 0;
+   }
+
+   deque->tasks[(deque->head + deque->count) % deque->capacity] = task;
+   deque->count++;
+   pthread_mutex_unlock(&deque->lock);
+}
+
+/* */
+
+static bool pop_back(Deque *deque, Task *task){
+   pthread_mutex_lock(&deque->lock);
+   bool found = deque->count > 0;
+
+   if(found){
+      deque->count--;
+      *task = deque->tasks[(deque->head + deque->count) % deque->capacity];
+   }
+
+   pthread_mutex_unlock(&deque->lock);
+   return found;
+}
+
+/* */
+
+static bool pop_front(Deque *deque, Task *task){
+   pthread_mutex_lock(&deque->lock);
+   bool found = deque->count > 0;
+
+   if(found){
+      *task       = deque->tasks[deque->head];
+      deque->head = (deque->head + 1) % deque->capacity;
+      deque->count--;
+   }
+
+   pthread_mutex_unlock(&deque->lock);
+   return found;
+}
@@ -0,0 +1,333 @@
+#include "perf.h"
+#include "memory.h"
+#include "strings.h"
+
+#include <linux/perf_event.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define PERF_FUNCTION_NAME_MAX 40
+
+typedef enum {
+   COUNTER_CYCLES,
+   COUNTER_INSTRUCTIONS,
+   COUNTER_BRANCH_MISSES,
+   COUNTER_L1D_MISSES,
+   COUNTER_TASK_CLOCK,   /* ns, software so it opens where the others don't */
+   COUNTER_COUNT,
+}Counter;
+
+typedef struct {
+   const ObjectFunction*  func;    /* NULL for an empty slot */
+   uint64_t               calls;
+   uint64_t               counts[COUNTER_COUNT];
+   char                   name[PERF_FUNCTION_NAME_MAX];
+}FunctionCounts;
+
+struct PerfSession {
+   int       leader;                     /* fd read for the whole group */
+   int       fds[COUNTER_COUNT];         /* -1 when the counter could not be opened */
+   int32_t   slots[COUNTER_COUNT];       /* position of each counter in a group read */
+   int32_t   opened;
+   uint64_t  last[COUNTER_COUNT];        /* at the previous sync */
+   uint64_t  totals[COUNTER_COUNT];      /* when stopped */
+
+   bool                   functions;
+   const ObjectFunction*  running;
+   FunctionCounts*        table;         /* open addressing on the function */
+   int32_t                count;
+   int32_t                capacity;
+};
+
+static PerfSession*  open_session(bool functions);
+static void          sync_session(PerfSession *session, ObjectFunction *running, bool is_call);
+static void          report_session(PerfSession *session, FILE *file, int32_t limit);
+static void          close_session(PerfSession *session);
+
+const PerfAPI ant_perf = {
+   .open = open_session,
+   .sync = sync_session,
+   .report = report_session,
+   .close = close_session,
+};
+
+/* Private */
+static int              open_counter(Counter counter, int group);
+static bool             read_counters(PerfSession *session, uint64_t *values);
+static FunctionCounts*  find_function(PerfSession *session, const ObjectFunction *func);
+static int              compare_functions(const void *a, const void *b);
+static void             print_counts(FILE *file, PerfSession *session, const uint64_t *counts);
+
+static const char *counter_names[] = {
+   [COUNTER_CYCLES]        = "cycles",
+   [COUNTER_INSTRUCTIONS]  = "instructions",
+   [COUNTER_BRANCH_MISSES] = "branch-misses",
+   [COUNTER_L1D_MISSES]    = "L1d-misses",
+   [COUNTER_TASK_CLOCK]    = "task-clock",
+};
+
+/* before the first call and after the last return, compiling or loading the cache */
+static const char outside_site;
+#define OUTSIDE_SITE ((const ObjectFunction *)&outside_site)
+
+/* Implementation */
+static PerfSession *open_session(bool functions) {
+   PerfSession *session = calloc(1, sizeof(PerfSession));
+   session->leader      = -1;
+   session->functions   = functions;
+   session->running     = OUTSIDE_SITE;
+
+   for (Counter counter = 0; counter < COUNTER_COUNT; counter++) {
+      session->fds[counter] = open_counter(counter, session->leader);
+
+      if (session->fds[counter] < 0) {
+         continue;
+      }
+
+      if (session->leader < 0) {
+         session->leader = session->fds[counter];
+      }
+
+      session->slots[counter] = session->opened++;
+   }
+
+   if (session->leader < 0) {
+      free(session);
+      return NULL;
+   }
+
+   ioctl(session->leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+   ioctl(session->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+   return session;
+}
+
+/* */
+
+static void sync_session(PerfSession *session, ObjectFunction *running, bool is_call) {
+   uint64_t values[COUNTER_COUNT];
+
+   if (!read_counters(session, values)) {
+      return;
+   }
+
+   FunctionCounts *counts = find_function(session, session->running);
+
+   for (int32_t i = 0; i < COUNTER_COUNT; i++) {
+      counts->counts[i] += values[i] - session->last[i];
+      session->last[i]   = values[i];
+   }
+
+   session->running = running == NULL ? OUTSIDE_SITE : running;
+
+   if (is_call) {
+      find_function(session, session->running)->calls++;
+   }
+}
+
+/* */
+
+static void report_session(PerfSession *session, FILE *file, int32_t limit) {
+   ioctl(session->leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+   if (session->functions) {
+      sync_session(session, NULL, false);
+   }
+
+   read_counters(session, session->totals);
+
+   fprintf(file, "\n== perf counters ==\n\n");
+
+   for (Counter counter = 0; counter < COUNTER_COUNT; counter++) {
+      if (session->fds[counter] < 0) {
+         fprintf(file, "%16s %16s\n", "n/a", counter_names[counter]);
+      } else if (counter == COUNTER_TASK_CLOCK) {
+         fprintf(file, "%16.3f %16s ms\n", session->totals[counter] / 1e6, counter_names[counter]);
+      } else {
+         fprintf(file, "%16lu %16s\n", (unsigned long)session->totals[counter], counter_names[counter]);
+      }
+   }
+
+   print_counts(file, session, session->totals);
+
+   if (!session->functions) {
+      return;
+   }
+
+   FunctionCounts *sorted = malloc(sizeof(FunctionCounts) * (session->count > 0 ? session->count : 1));
+   int32_t count          = 0;
+
+   for (int32_t i = 0; i < session->capacity; i++) {
+      if (session->table[i].func != NULL) {
+         sorted[count++] = session->table[i];
+      }
+   }
+
+   qsort(sorted, count, sizeof(FunctionCounts), compare_functions);
+
+   fprintf(file, "\n== functions, self ==\n\n");
+
+   for (int32_t i = 0; i < count && i < limit; i++) {
+      fprintf(file, "%-32s %10lu calls %7.2f%% time", sorted[i].name, (unsigned long)sorted[i].calls,
+              session->totals[COUNTER_TASK_CLOCK] == 0 ? 0.0
+                  : 100.0 * sorted[i].counts[COUNTER_TASK_CLOCK] / session->totals[COUNTER_TASK_CLOCK]);
+      print_counts(file, session, sorted[i].counts);
+   }
+
+   free(sorted);
+}
+
+/* */
+
+static void close_session(PerfSession *session) {
+   if (session == NULL) {
+      return;
+   }
+
+   for (Counter counter = 0; counter < COUNTER_COUNT; counter++) {
+      if (session->fds[counter] >= 0) {
+         close(session->fds[counter]);
+      }
+   }
+
+   free(session->table);
+   free(session);
+}
+
+/* Private */
+
+static int open_counter(Counter counter, int group) {
+   struct perf_event_attr attr;
+   memset(&attr, 0, sizeof(attr));
+
+   attr.size           = sizeof(attr);
+   attr.disabled       = group < 0;
+   attr.exclude_kernel = 1;
+   attr.exclude_hv     = 1;
+   attr.read_format    = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+   switch (counter) {
+   case COUNTER_CYCLES:
+      attr.type   = PERF_TYPE_HARDWARE;
+      attr.config = PERF_COUNT_HW_CPU_CYCLES;
+      break;
+   case COUNTER_INSTRUCTIONS:
+      attr.type   = PERF_TYPE_HARDWARE;
+      attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+      break;
+   case COUNTER_BRANCH_MISSES:
+      attr.type   = PERF_TYPE_HARDWARE;
+      attr.config = PERF_COUNT_HW_BRANCH_MISSES;
+      break;
+   case COUNTER_L1D_MISSES:
+      attr.type   = PERF_TYPE_HW_CACHE;
+      attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+      break;
+   default:
+      attr.type   = PERF_TYPE_SOFTWARE;
+      attr.config = PERF_COUNT_SW_TASK_CLOCK;
+      break;
+   }
+
+   return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+/* scaled up when the kernel multiplexed the group with other users of the PMU */
+
+static bool read_counters(PerfSession *session, uint64_t *values) {
+   uint64_t buffer[3 + COUNTER_COUNT];
+
+   if (read(session->leader, buffer, sizeof(buffer)) < (ssize_t)(sizeof(uint64_t) * (3 + session->opened))) {
+      return false;
+   }
+
+   double scale = buffer[2] == 0 ? 0 : (double)buffer[1] / buffer[2];
+
+   for (Counter counter = 0; counter < COUNTER_COUNT; counter++) {
+      values[counter] = session->fds[counter] < 0 ? 0 : (uint64_t)(buffer[3 + session->slots[counter]] * scale);
+   }
+
+   return true;
+}
+
+/* */
+
+static FunctionCounts *find_function(PerfSession *session, const ObjectFunction *func) {
+   if ((session->count + 1) * 4 > session->capacity * 3) {
+      FunctionCounts *old = session->table;
+      int32_t capacity    = session->capacity;
+
+      session->capacity = GROW_CAPACITY(capacity);
+      session->table    = calloc(session->capacity, sizeof(FunctionCounts));
+      session->count    = 0;
+
+      for (int32_t i = 0; i < capacity; i++) {
+         if (old[i].func != NULL) {
+            *find_function(session, old[i].func) = old[i];
+         }
+      }
+
+      free(old);
+   }
+
+   uint32_t index = (uint32_t)((uintptr_t)func >> 4) & (session->capacity - 1);
+
+   for (;;) {
+      FunctionCounts *counts = &session->table[index];
+
+      if (counts->func == func) {
+         return counts;
+      }
+
+      if (counts->func == NULL) {
+         const char *name = func == OUTSIDE_SITE ? "(no frame)" : func->name == NULL ? "script" : func->name->chars;
+
+         counts->func = func;
+         strncpy(counts->name, name, PERF_FUNCTION_NAME_MAX - 1);
+         session->count++;
+         return counts;
+      }
+
+      index = (index + 1) & (session->capacity - 1);
+   }
+}
+
+/* by cycles, by time without a PMU */
+
+static int compare_functions(const void *a, const void *b) {
+   const FunctionCounts *x = a;
+   const FunctionCounts *y = b;
+
+   if (x->counts[COUNTER_CYCLES] != y->counts[COUNTER_CYCLES]) {
+      return x->counts[COUNTER_CYCLES] < y->counts[COUNTER_CYCLES] ? 1 : -1;
+   }
+
+   if (x->counts[COUNTER_TASK_CLOCK] != y->counts[COUNTER_TASK_CLOCK]) {
+      return x->counts[COUNTER_TASK_CLOCK] < y->counts[COUNTER_TASK_CLOCK] ? 1 : -1;
+   }
+
+   return strcmp(x->name, y->name);
+}
+
+/* the rates the raw counts are read for, left out when a counter they need is missing */
+
+static void print_counts(FILE *file, PerfSession *session, const uint64_t *counts) {
+   uint64_t instructions = counts[COUNTER_INSTRUCTIONS];
+   bool has_instructions = session->fds[COUNTER_INSTRUCTIONS] >= 0 && instructions > 0;
+
+   if (has_instructions && session->fds[COUNTER_CYCLES] >= 0 && counts[COUNTER_CYCLES] > 0) {
+      fprintf(file, "  IPC %5.2f", (double)instructions / counts[COUNTER_CYCLES]);
+   }
+
+   if (has_instructions && session->fds[COUNTER_BRANCH_MISSES] >= 0) {
+      fprintf(file, "  branch-misses/1k instr %6.2f", 1000.0 * counts[COUNTER_BRANCH_MISSES] / instructions);
+   }
+
+   if (has_instructions && session->fds[COUNTER_L1D_MISSES] >= 0) {
+      fprintf(file, "  L1d-misses/1k instr %6.2f", 1000.0 * counts[COUNTER_L1D_MISSES] / instructions);
+   }
+
+   fprintf(file, "\n");
+}
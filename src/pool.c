@@ -0,0 +1,308 @@
+#include "pool.h"
+#include "config.h"
+#include "memory.h"
+#include "utils.h"
+#include "vm.h"
+#include "program.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct PoolJob {
+   char *source;
+   int32_t length;
+   struct PoolJob *next;
+}PoolJob;
+
+/* a compiled script keyed by its source */
+typedef struct CachedProgram {
+   char *source;
+   int32_t length;
+   uint32_t hash;
+   AntProgram *program;   /* NULL if compilation failed */
+   bool ready;
+   struct CachedProgram *next;
+}CachedProgram;
+
+struct AntPool {
+   pthread_t threads[OPTION_POOL_MAX_THREADS];
+   int32_t thread_count;
+
+   /* one lock for the queue, the cache and the stats */
+   pthread_mutex_t lock;
+   pthread_cond_t has_jobs;
+   pthread_cond_t idle;
+   pthread_cond_t compiled;
+
+   PoolJob *head;
+   PoolJob *tail;
+   int64_t pending;  /* queued or running */
+   bool shutting_down;
+
+   CachedProgram *cache[OPTION_POOL_CACHE_BUCKETS];
+   PoolStats stats;
+};
+
+static AntPool*   new_pool(int32_t thread_count);
+static void       free_pool(AntPool *pool);
+static bool       submit(AntPool *pool, const char *source);
+static void       wait_pool(AntPool *pool);
+static PoolStats  pool_stats(AntPool *pool);
+
+const AntPoolAPI ant_pool = {
+   .new = new_pool,
+   .free = free_pool,
+   .submit = submit,
+   .wait = wait_pool,
+   .stats = pool_stats,
+};
+
+/* Private */
+static void           *worker(void *arg);
+static void           run_job(AntPool *pool, VM *vm, PoolJob *job);
+static CachedProgram  *find_or_compile(AntPool *pool, PoolJob *job);
+static void           free_cache(AntPool *pool);
+
+static AntPool *new_pool(int32_t thread_count){
+   if(thread_count < 1 || thread_count > OPTION_POOL_MAX_THREADS){
+      fprintf(stderr, "Error: Pool thread count must be between 1 and %d\n", OPTION_POOL_MAX_THREADS);
+      return NULL;
+   }
+
+   AntPool *pool = ALLOCATE(AntPool, 1);
+   memset(pool, 0, sizeof(AntPool));
+
+   pthread_mutex_init(&pool->lock, NULL);
+   pthread_cond_init(&pool->has_jobs, NULL);
+   pthread_cond_init(&pool->idle, NULL);
+   pthread_cond_init(&pool->compiled, NULL);
+
+   for(int32_t i = 0; i < thread_count; i++){
+      if(pthread_create(&pool->threads[i], NULL, worker, pool) != 0){
+         fprintf(stderr, "Error: Could not start pool worker %d\n", i);
+         break;
+      }
+      pool->thread_count++;
+   }
+
+   return pool;
+}
+
+/* */
+
+static void free_pool(AntPool *pool){
+   pthread_mutex_lock(&pool->lock);
+   pool->shutting_down = true;
+   pthread_cond_broadcast(&pool->has_jobs);
+   pthread_mutex_unlock(&pool->lock);
+
+   for(int32_t i = 0; i < pool->thread_count; i++){
+      pthread_join(pool->threads[i], NULL);
+   }
+
+   free_cache(pool);
+
+   pthread_mutex_destroy(&pool->lock);
+   pthread_cond_destroy(&pool->has_jobs);
+   pthread_cond_destroy(&pool->idle);
+   pthread_cond_destroy(&pool->compiled);
+   FREE(AntPool, pool);
+}
+
+/* */
+
+static bool submit(AntPool *pool, const char *source){
+   int32_t length = (int32_t)strlen(source);
+
+   PoolJob *job = ALLOCATE(PoolJob, 1);
+   job->source  = ALLOCATE(char, length + 1);
+   job->length  = length;
+   job->next    = NULL;
+   memcpy(job->source, source, length + 1);
+
+   pthread_mutex_lock(&pool->lock);
+
+   if(pool->shutting_down){
+      pthread_mutex_unlock(&pool->lock);
+      FREE_ARRAY(char, job->source, length + 1);
+      FREE(PoolJob, job);
+      return false;
+   }
+
+   if(pool->tail == NULL){
+      pool->head = job;
+   } else {
+      pool->tail->next = job;
+   }
+
+   pool->tail = job;
+   pool->pending++;
+
+   pthread_cond_signal(&pool->has_jobs);
+   pthread_mutex_unlock(&pool->lock);
+   return true;
+}
+
+/* */
+
+static void wait_pool(AntPool *pool){
+   pthread_mutex_lock(&pool->lock);
+
+   while(pool->pending > 0){
+      pthread_cond_wait(&pool->idle, &pool->lock);
+   }
+
+   pthread_mutex_unlock(&pool->lock);
+}
+
+/* */
+
+static PoolStats pool_stats(AntPool *pool){
+   pthread_mutex_lock(&pool->lock);
+   PoolStats stats = pool->stats;
+   pthread_mutex_unlock(&pool->lock);
+
+   return stats;
+}
+
+/* Private */
+
+/* The worker VM lives for the whole pool. Anything a script allocates is freed
+ * by the reset right after it. Shutdown drains the queue first.
+ */
+
+static void *worker(void *arg){
+   AntPool *pool = (AntPool*)arg;
+   VM *vm        = ant_vm.new();
+
+   while(true){
+      pthread_mutex_lock(&pool->lock);
+
+      while(pool->head == NULL && !pool->shutting_down){
+         pthread_cond_wait(&pool->has_jobs, &pool->lock);
+      }
+
+      PoolJob *job = pool->head;
+
+      if(job == NULL){
+         pthread_mutex_unlock(&pool->lock);
+         break;
+      }
+
+      pool->head = job->next;
+
+      if(pool->head == NULL){
+         pool->tail = NULL;
+      }
+
+      pthread_mutex_unlock(&pool->lock);
+
+      run_job(pool, vm, job);
+      ant_vm.reset(vm);
+
+      FREE_ARRAY(char, job->source, job->length + 1);
+      FREE(PoolJob, job);
+
+      pthread_mutex_lock(&pool->lock);
+
+      if(--pool->pending == 0){
+         pthread_cond_broadcast(&pool->idle);
+      }
+
+      pthread_mutex_unlock(&pool->lock);
+   }
+
+   ant_vm.free(vm);
+   return NULL;
+}
+
+/* */
+
+static void run_job(AntPool *pool, VM *vm, PoolJob *job){
+   CachedProgram *cached  = find_or_compile(pool, job);
+   InterpretResult result = INTERPRET_COMPILE_ERROR;
+
+   if(cached->program != NULL){
+      result = ant_program.run(vm, cached->program, PROGRAM_GLOBALS_FRESH);
+   }
+
+   pthread_mutex_lock(&pool->lock);
+
+   switch(result){
+      case INTERPRET_OK:            pool->stats.ok++; break;
+      case INTERPRET_COMPILE_ERROR: pool->stats.compile_errors++; break;
+      case INTERPRET_RUNTIME_ERROR: pool->stats.runtime_errors++; break;
+   }
+
+   pthread_mutex_unlock(&pool->lock);
+}
+
+/* Compiles outside the lock. Workers needing a program still being compiled wait for it. */
+
+static CachedProgram *find_or_compile(AntPool *pool, PoolJob *job){
+   uint32_t hash = ant_utils.hash(job->source, job->length);
+   CachedProgram **bucket = &pool->cache[hash % OPTION_POOL_CACHE_BUCKETS];
+
+   pthread_mutex_lock(&pool->lock);
+
+   for(CachedProgram *program = *bucket; program != NULL; program = program->next){
+      bool same = program->hash == hash && 
+                  program->length == job->length &&
+                  memcmp(program->source, job->source, job->length) == 0;
+
+      if(!same){
+         continue;
+      }
+
+      while(!program->ready){
+         pthread_cond_wait(&pool->compiled, &pool->lock);
+      }
+
+      pool->stats.cache_hits++;
+      pthread_mutex_unlock(&pool->lock);
+      return program;
+   }
+
+   /* the job source is freed after the run, the cache keeps its own copy */
+   CachedProgram *program = ALLOCATE(CachedProgram, 1);
+   program->source = ALLOCATE(char, job->length + 1);
+   program->length = job->length;
+   program->hash   = hash;
+   program->program = NULL;
+   program->ready  = false;
+   program->next   = *bucket;
+   memcpy(program->source, job->source, job->length + 1);
+
+   *bucket = program;
+   pool->stats.cache_misses++;
+   pthread_mutex_unlock(&pool->lock);
+
+   AntProgram *compiled = ant_program.compile(program->source);
+
+   pthread_mutex_lock(&pool->lock);
+   program->program = compiled;
+   program->ready = true;
+   pthread_cond_broadcast(&pool->compiled);
+   pthread_mutex_unlock(&pool->lock);
+
+   return program;
+}
+
+static void free_cache(AntPool *pool){
+   for(int32_t i = 0; i < OPTION_POOL_CACHE_BUCKETS; i++){
+      CachedProgram *program = pool->cache[i];
+
+      while(program != NULL){
+         CachedProgram *next = program->next;
+
+         ant_program.free(program->program);
+         FREE_ARRAY(char, program->source, program->length + 1);
+         FREE(CachedProgram, program);
+         program = next;
+      }
+
+      pool->cache[i] = NULL;
+   }
+}
@@ -0,0 +1,258 @@
+#include "profiler.h"
+#include "config.h"
+#include "fiber.h"
+#include "lines.h"
+#include "strings.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+typedef struct {
+   char*     stack;     /* folded, without the count. NULL for an empty slot */
+   uint32_t  hash;
+   uint64_t  ticks;
+}Sample;
+
+/* open addressing on the hash of the stack, one entry per distinct stack */
+typedef struct {
+   Sample*   entries;
+   int32_t   count;
+   int32_t   capacity;  /* a power of 2 */
+}Samples;
+
+static bool  start_profiler(VM *vm);
+static void  stop_profiler(VM *vm);
+static void  take_sample(VM *vm);
+static bool  write_samples(const char *path);
+
+const ProfilerAPI ant_profiler = {
+   .start = start_profiler,
+   .stop = stop_profiler,
+   .sample = take_sample,
+   .write = write_samples,
+};
+
+/* Private */
+static void     on_sigprof(int signal);
+static int32_t  append_frame(char *buffer, int32_t length, int32_t capacity, CallFrame *frame);
+static void     add_sample(const char *stack, int32_t length, uint64_t ticks);
+static Sample  *find_sample(Sample *entries, int32_t capacity, const char *stack, uint32_t hash);
+static uint32_t hash_stack(const char *stack, int32_t length);
+static int      compare_samples(const void *a, const void *b);
+
+/* set by start, read by the handler */
+static VM *volatile profiled_vm = NULL;
+static Samples samples          = {NULL, 0, 0};
+
+/* Implementation */
+static bool start_profiler(VM *vm) {
+   atomic_store(&vm->sample_ticks, 0);
+   profiled_vm = vm;
+
+   struct sigaction action;
+   memset(&action, 0, sizeof(action));
+   action.sa_handler = on_sigprof;
+   action.sa_flags   = SA_RESTART;
+   sigemptyset(&action.sa_mask);
+
+   struct itimerval timer = {
+       .it_interval = {.tv_sec = 0, .tv_usec = OPTION_PROFILE_INTERVAL_US},
+       .it_value    = {.tv_sec = 0, .tv_usec = OPTION_PROFILE_INTERVAL_US},
+   };
+
+   if (sigaction(SIGPROF, &action, NULL) != 0 || setitimer(ITIMER_PROF, &timer, NULL) != 0) {
+      stop_profiler(vm);
+      return false;
+   }
+
+   return true;
+}
+
+/* ignoring SIGPROF drops a signal still pending, its default action ends the process */
+
+static void stop_profiler(VM *vm) {
+   struct itimerval timer;
+   memset(&timer, 0, sizeof(timer));
+   setitimer(ITIMER_PROF, &timer, NULL);
+   signal(SIGPROF, SIG_IGN);
+
+   atomic_store(&vm->sample_ticks, 0);
+   profiled_vm = NULL;
+}
+
+/* walks the fibers like the stack trace of runtime_error, then reverses the frames. The ticks
+ * counted since the last safepoint all go to this stack, a long native call included */
+
+static void take_sample(VM *vm) {
+   uint64_t ticks = atomic_exchange_explicit(&vm->sample_ticks, 0, memory_order_relaxed);
+
+   if (ticks == 0) {
+      return;
+   }
+
+   CallFrame *frames[OPTION_PROFILE_DEPTH_MAX];
+   int32_t depth = 0;
+
+   ObjectFiber *fiber  = vm->fiber;
+   CallFrame *fiber_frames = vm->frames;
+   int32_t frame_count = vm->frame_count;
+
+   while (fiber != NULL && depth < OPTION_PROFILE_DEPTH_MAX) {
+      for (int32_t i = frame_count - 1; i >= 0 && depth < OPTION_PROFILE_DEPTH_MAX; i--) {
+         frames[depth++] = &fiber_frames[i];
+      }
+
+      fiber = fiber->caller;
+
+      if (fiber != NULL) {
+         fiber_frames = fiber->frames;
+         frame_count  = fiber->frame_count;
+      }
+   }
+
+   if (depth == 0) {
+      return;
+   }
+
+   char stack[64 * OPTION_PROFILE_DEPTH_MAX];
+   int32_t length = 0;
+
+   for (int32_t i = depth - 1; i >= 0; i--) {
+      length = append_frame(stack, length, (int32_t)sizeof(stack), frames[i]);
+   }
+
+   add_sample(stack, length, ticks);
+}
+
+/* sorted by stack so the file is the same from run to run */
+
+static bool write_samples(const char *path) {
+   FILE *file = fopen(path, "w");
+
+   if (file == NULL) {
+      return false;
+   }
+
+   int32_t count = 0;
+
+   for (int32_t i = 0; i < samples.capacity; i++) {
+      if (samples.entries[i].stack != NULL) {
+         samples.entries[count++] = samples.entries[i];
+      }
+   }
+
+   if (count > 0) {
+      qsort(samples.entries, count, sizeof(Sample), compare_samples);
+   }
+
+   for (int32_t i = 0; i < count; i++) {
+      fprintf(file, "%s %llu\n", samples.entries[i].stack, (unsigned long long)samples.entries[i].ticks);
+      free(samples.entries[i].stack);
+   }
+
+   free(samples.entries);
+   samples = (Samples){NULL, 0, 0};
+
+   return fclose(file) == 0;
+}
+
+/* Private */
+
+/* lock-free atomics are safe in a handler, whatever the thread it interrupted */
+
+static void on_sigprof(int signal) {
+   (void)signal;
+   VM *vm = profiled_vm;
+
+   if (vm != NULL) {
+      atomic_fetch_add_explicit(&vm->sample_ticks, 1, memory_order_relaxed);
+   }
+}
+
+/* `;name:line`, the leading ; left out for the root. Truncated past capacity */
+
+static int32_t append_frame(char *buffer, int32_t length, int32_t capacity, CallFrame *frame) {
+   ObjectFunction *func = frame->closure->func;
+
+   /* -1 as ip is past the instruction, like runtime_error */
+   int32_t offset = (int32_t)(frame->ip - func->chunk.code - 1);
+   int32_t line   = ant_line.get(&func->chunk.lines, offset);
+
+   int written = snprintf(buffer + length, capacity - length, "%s%s:%d", length == 0 ? "" : ";",
+                          func->name == NULL ? "script" : func->name->chars, line);
+
+   return written < capacity - length ? length + written : capacity - 1;
+}
+
+/* the stack is only copied the first time it is seen */
+
+static void add_sample(const char *stack, int32_t length, uint64_t ticks) {
+   if (samples.count + 1 > samples.capacity * OPTION_TABLE_LOAD_FACTOR) {
+      int32_t capacity = samples.capacity < OPTION_ARRAY_MIN_CAPACITY ? OPTION_ARRAY_MIN_CAPACITY
+                                                                      : samples.capacity * OPTION_ARRAY_GROW_FACTOR;
+      Sample *entries  = calloc(capacity, sizeof(Sample));
+
+      for (int32_t i = 0; i < samples.capacity; i++) {
+         Sample *entry = &samples.entries[i];
+
+         if (entry->stack != NULL) {
+            *find_sample(entries, capacity, entry->stack, entry->hash) = *entry;
+         }
+      }
+
+      free(samples.entries);
+      samples.entries  = entries;
+      samples.capacity = capacity;
+   }
+
+   uint32_t hash  = hash_stack(stack, length);
+   Sample *sample = find_sample(samples.entries, samples.capacity, stack, hash);
+
+   if (sample->stack == NULL) {
+      sample->stack = malloc(length + 1);
+      memcpy(sample->stack, stack, length);
+      sample->stack[length] = '\0';
+      sample->hash          = hash;
+      samples.count++;
+   }
+
+   sample->ticks += ticks;
+}
+
+/* the entry of the stack, or the empty slot where it goes */
+
+static Sample *find_sample(Sample *entries, int32_t capacity, const char *stack, uint32_t hash) {
+   uint32_t index = hash & (capacity - 1);
+
+   for (;;) {
+      Sample *entry = &entries[index];
+
+      if (entry->stack == NULL || (entry->hash == hash && strcmp(entry->stack, stack) == 0)) {
+         return entry;
+      }
+
+      index = (index + 1) & (capacity - 1);
+   }
+}
+
+/* FNV-1a, like the hash of strings */
+
+static uint32_t hash_stack(const char *stack, int32_t length) {
+   uint32_t hash = 2166136261u;
+
+   for (int32_t i = 0; i < length; i++) {
+      hash ^= (uint8_t)stack[i];
+      hash *= 16777619;
+   }
+
+   return hash;
+}
+
+/* */
+
+static int compare_samples(const void *a, const void *b) {
+   return strcmp(((const Sample *)a)->stack, ((const Sample *)b)->stack);
+}
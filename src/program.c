@@ -0,0 +1,69 @@
+#include "program.h"
+#include "context.h"
+#include "memory.h"
+#include "natives.h"
+
+struct AntProgram {
+   AntContext *context;
+   ObjectFunction *func;
+};
+
+static AntProgram*      compile_program(const char *source);
+static void             free_program(AntProgram *program);
+static InterpretResult  run_program(VM *vm, const AntProgram *program, ProgramGlobals globals);
+
+const AntProgramAPI ant_program = {
+   .compile = compile_program,
+   .free = free_program,
+   .run = run_program,
+};
+
+/* Natives are registered by name only, so global indices line up with any VM running it.
+ * Strings in the source are copied into the context by the compiler.
+ */
+
+static AntProgram *compile_program(const char *source){
+   AntContext *previous = CURRENT_CONTEXT();
+   AntContext *context  = ant_context.new();
+
+   ant_context.make_current(context);
+   ant_native.register_names();
+
+   Compiler compiler;
+   ant_compiler.init(&compiler, COMPILATION_TYPE_SCRIPT);
+   ObjectFunction *func = ant_compiler.compile(&compiler, source);
+
+   ant_context.make_current(previous);
+
+   if(func == NULL){
+      ant_context.free(context);
+      return NULL;
+   }
+
+   AntProgram *program = ALLOCATE(AntProgram, 1);
+   program->context    = context;
+   program->func       = func;
+   return program;
+}
+
+/* */
+
+static void free_program(AntProgram *program){
+   if(program == NULL){
+      return;
+   }
+
+   ant_context.free(program->context);
+   FREE(AntProgram, program);
+}
+
+/* The parent tells which program the VM globals belong to */
+
+static InterpretResult run_program(VM *vm, const AntProgram *program, ProgramGlobals globals){
+   if(globals == PROGRAM_GLOBALS_FRESH || vm->context->parent != program->context){
+      ant_vm.reset(vm);
+   }
+
+   vm->context->parent = program->context;
+   return ant_vm.execute(vm, program->func);
+}
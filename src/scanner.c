@@ -3,9 +3,78 @@
 #include <stdlib.h>
 #include <string.h>
 
+/* Runs of blanks, identifier chars, digits, comments and string chars are skipped 16 bytes at
+ * a time with SSE2, baseline on x86_64. The loads are aligned, so none crosses into the page
+ * after the '\0' that ends every run, but they do read past the end of the source within that
+ * page: sanitizer builds use the scalar loops. */
+#if defined(__SSE2__) && !defined(__SANITIZE_ADDRESS__)
+#define SCANNER_SSE2
+#endif
+
+#if defined(SCANNER_SSE2) && defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#undef SCANNER_SSE2
+#endif
+#endif
+
+#ifdef SCANNER_SSE2
+#include <emmintrin.h>
+#endif
+
+/* most runs are a blank or a short name, so blocks are only loaded past the first few chars */
+#ifndef SCANNER_SCALAR_PREFIX
+#define SCANNER_SCALAR_PREFIX 4
+#endif
+
+typedef enum {
+  CHARS_BLANK,        /* ' ', '\t' and '\r', newlines are counted one at a time */
+  CHARS_IDENTIFIER,   /* letters, digits and '_' */
+  CHARS_DIGIT,
+  CHARS_COMMENT,      /* all but '\n' */
+  CHARS_STRING,       /* all but '"', '\n' and '$' */
+} CharClass;
+
+typedef struct {
+  const char *name;
+  int32_t length;
+  TokenType type;
+} Keyword;
+
+/* Keywords are found with a perfect hash of their first and last chars and their length: the
+ * constants were searched so each keyword gets a slot of its own. Two keywords in one slot
+ * would make -Woverride-init warn. */
+#define KEYWORD_SLOTS 32
+#define KEYWORD_LENGTH_MIN 2
+#define KEYWORD_LENGTH_MAX 6
+#define KEYWORD_SLOT(first, last, length) \
+  ((((uint32_t)(first)) * 2 + ((uint32_t)(last)) * 14 + ((uint32_t)(length)) * 13) & (KEYWORD_SLOTS - 1))
+#define KEYWORD(name, first, last, type) \
+  [KEYWORD_SLOT(first, last, sizeof(name) - 1)] = {name, sizeof(name) - 1, type}
+
+static const Keyword keywords[KEYWORD_SLOTS] = {
+    KEYWORD("and", 'a', 'd', TOKEN_AND),
+    KEYWORD("class", 'c', 's', TOKEN_CLASS),
+    KEYWORD("else", 'e', 'e', TOKEN_ELSE),
+    KEYWORD("false", 'f', 'e', TOKEN_FALSE),
+    KEYWORD("for", 'f', 'r', TOKEN_FOR),
+    KEYWORD("fn", 'f', 'n', TOKEN_FN),
+    KEYWORD("if", 'i', 'f', TOKEN_IF),
+    KEYWORD("import", 'i', 't', TOKEN_IMPORT),
+    KEYWORD("in", 'i', 'n', TOKEN_IN),
+    KEYWORD("let", 'l', 't', TOKEN_LET),
+    KEYWORD("nil", 'n', 'l', TOKEN_NIL),
+    KEYWORD("or", 'o', 'r', TOKEN_OR),
+    KEYWORD("print", 'p', 't', TOKEN_PRINT),
+    KEYWORD("return", 'r', 'n', TOKEN_RETURN),
+    KEYWORD("super", 's', 'r', TOKEN_SUPER),
+    KEYWORD("this", 't', 's', TOKEN_THIS),
+    KEYWORD("true", 't', 'e', TOKEN_TRUE),
+    KEYWORD("while", 'w', 'e', TOKEN_WHILE),
+};
+
 static void init_scanner(Scanner *scanner, const char *source);
 static Token scan_token(Scanner *scanner);
-static Token error_token(const char *message);
+static Token error_token(Scanner *scanner, const char *message);
 
 AntScannerAPI ant_scanner = {
     .init = init_scanner,
@@ -13,22 +82,20 @@ AntScannerAPI ant_scanner = {
 };
 
 /* helpers */
-static Token string_token(Scanner *scanner);
+static Token string_token(Scanner *scanner, TokenType closing_type);
 static Token number_token(Scanner *scanner);
 static Token indentifier_token(Scanner *scanner);
 static Token make_token(Scanner *scanner, TokenType type);
 
 static TokenType identifier_type(Scanner *scanner);
-static TokenType check_keyword(Scanner *scanner, int32_t start, int32_t length,
-                               const char *rest, TokenType type);
 
 static void skip_whitespace(Scanner *scanner);
-static void skip_comments(Scanner *scanner);
+static const char *skip_chars(const char *at, CharClass chars);
 static char eat_char(Scanner *scanner);
 static char peek_char(Scanner *scanner);
+static char peek_next_char(Scanner *scanner);
 
 static bool reached_end(Scanner *scanner);
-static bool is_last_char(Scanner *scanner);
 static bool match_char(Scanner *scanner, char expected);
 static bool is_digit(char c);
 static bool is_alpha(char c);
@@ -36,17 +103,20 @@ static bool is_alpha(char c);
 static void init_scanner(Scanner *scanner, const char *source) {
   scanner->start = source;
   scanner->current = source;
+  scanner->line_start = source;
   scanner->line = 1;
+  scanner->interpolation_depth = 0;
 }
 
 static Token scan_token(Scanner *scanner) {
 
   skip_whitespace(scanner);
   scanner->start = scanner->current;
+  scanner->column = (int32_t)(scanner->start - scanner->line_start) + 1;
 
   if (reached_end(scanner))
     return (Token){
-        .type = TOKEN_EOF, .start = "EOF", .length = 3, .line = scanner->line};
+        .type = TOKEN_EOF, .start = "EOF", .length = 3, .line = scanner->line, .column = scanner->column};
 
   char c = eat_char(scanner);
 
@@ -64,15 +134,36 @@ static Token scan_token(Scanner *scanner) {
   case ')':
     return make_token(scanner, TOKEN_RIGHT_PAREN);
   case '{':
+    if (scanner->interpolation_depth > 0) {
+      scanner->braces[scanner->interpolation_depth - 1]++;
+    }
     return make_token(scanner, TOKEN_LEFT_BRACE);
+
   case '}':
+    /* a '}' with no open braces closes the "${" and resumes the string */
+    if (scanner->interpolation_depth > 0) {
+      int32_t *braces = &scanner->braces[scanner->interpolation_depth - 1];
+
+      if (*braces == 0) {
+        scanner->interpolation_depth--;
+        return string_token(scanner, TOKEN_INTERPOLATION_END);
+      }
+
+      (*braces)--;
+    }
     return make_token(scanner, TOKEN_RIGHT_BRACE);
+  case '[':
+    return make_token(scanner, TOKEN_LEFT_BRACKET);
+  case ']':
+    return make_token(scanner, TOKEN_RIGHT_BRACKET);
+  case ':':
+    return make_token(scanner, TOKEN_COLON);
   case ';':
     return make_token(scanner, TOKEN_SEMICOLON);
   case ',':
     return make_token(scanner, TOKEN_COMMA);
   case '.':
-    return make_token(scanner, TOKEN_DOT);
+    return make_token(scanner, match_char(scanner, '.') ? TOKEN_DOT_DOT : TOKEN_DOT);
   case '-':
     return make_token(scanner, TOKEN_MINUS);
   case '+':
@@ -104,43 +195,71 @@ static Token scan_token(Scanner *scanner) {
   }
 
   case '"':
-    return string_token(scanner);
+    return string_token(scanner, TOKEN_STRING);
   }
 
-  return error_token("Unexpected character.");
+  return error_token(scanner, "Unexpected character.");
 }
 
 /* Helpers */
 
-static Token string_token(Scanner *scanner) {
+/*  Interpolated strings are split into segments around each "${ expression }":
+ *
+ *   "today is ${day}, ${month}!"
+ *
+ *   TOKEN_INTERPOLATION_START   "today is ${
+ *   <expression tokens>         day
+ *   TOKEN_INTERPOLATION_START   }, ${
+ *   <expression tokens>         month
+ *   TOKEN_INTERPOLATION_END     }!"
+ *
+ *  closing_type is the token returned when we reach the closing quote:
+ *  TOKEN_STRING for a plain string, TOKEN_INTERPOLATION_END when resuming after a '}'.
+ * */
+
+static Token string_token(Scanner *scanner, TokenType closing_type) {
 
   while (peek_char(scanner) != '"' && !reached_end(scanner)) {
+    scanner->current = skip_chars(scanner->current, CHARS_STRING);
+
+    if (peek_char(scanner) == '"' || reached_end(scanner)) {
+      break;
+    }
+
     if (peek_char(scanner) == '\n') {
       scanner->line++;
+      scanner->line_start = scanner->current + 1;
+    }
+
+    if (peek_char(scanner) == '$' && peek_next_char(scanner) == '{') {
+      if (scanner->interpolation_depth == OPTION_INTERPOLATION_MAX_DEPTH) {
+        return error_token(scanner, "Interpolation nested too deeply.");
+      }
+
+      eat_char(scanner);
+      eat_char(scanner);
+      scanner->braces[scanner->interpolation_depth++] = 0;
+      return make_token(scanner, TOKEN_INTERPOLATION_START);
     }
+
     eat_char(scanner);
   }
 
   if (reached_end(scanner)) {
-    return error_token("Unterminated string.");
+    return error_token(scanner, "Unterminated string.");
   }
 
   eat_char(scanner);
-  return make_token(scanner, TOKEN_STRING);
+  return make_token(scanner, closing_type);
 }
 
 static Token number_token(Scanner *scanner) {
 
-  while (is_digit(peek_char(scanner))) {
-    eat_char(scanner);
-  }
+  scanner->current = skip_chars(scanner->current, CHARS_DIGIT);
 
-  if (peek_char(scanner) == '.' && is_digit(peek_char(scanner + 1))) {
+  if (peek_char(scanner) == '.' && is_digit(peek_next_char(scanner))) {
     eat_char(scanner);
-
-    while (is_digit(peek_char(scanner))) {
-      eat_char(scanner);
-    }
+    scanner->current = skip_chars(scanner->current, CHARS_DIGIT);
   }
 
   return make_token(scanner, TOKEN_NUMBER);
@@ -148,18 +267,17 @@ static Token number_token(Scanner *scanner) {
 
 static Token indentifier_token(Scanner *scanner) {
   /* accepts both digits and alphas as long as first char is alpha */
-  while (is_alpha(peek_char(scanner)) || is_digit(peek_char(scanner))) {
-    eat_char(scanner);
-  }
+  scanner->current = skip_chars(scanner->current, CHARS_IDENTIFIER);
   return make_token(scanner, identifier_type(scanner));
 }
 
-static Token error_token(const char *message) {
+static Token error_token(Scanner *scanner, const char *message) {
   return (Token){
       .type = TOKEN_ERROR,
       .start = message,
       .length = (int32_t)strlen(message),
-      .line = -1,
+      .line = scanner->line,
+      .column = scanner->column,
   };
 }
 
@@ -169,70 +287,22 @@ static Token make_token(Scanner *scanner, TokenType type) {
       .start = scanner->start,
       .length = (int32_t)(scanner->current - scanner->start),
       .line = scanner->line,
+      .column = scanner->column,
   };
 }
 
 static TokenType identifier_type(Scanner *scanner) {
-  switch (scanner->start[0]) {
-  case 'a':
-    return check_keyword(scanner, 1, 2, "nd", TOKEN_AND);
-  case 'c':
-    return check_keyword(scanner, 1, 4, "lass", TOKEN_CLASS);
-  case 'e':
-    return check_keyword(scanner, 1, 3, "lse", TOKEN_ELSE);
-  case 'i':
-    return check_keyword(scanner, 1, 1, "f", TOKEN_IF);
-  case 'n':
-    return check_keyword(scanner, 1, 2, "il", TOKEN_NIL);
-  case 'o':
-    return check_keyword(scanner, 1, 1, "r", TOKEN_OR);
-  case 'p':
-    return check_keyword(scanner, 1, 4, "rint", TOKEN_PRINT);
-  case 'r':
-    return check_keyword(scanner, 1, 5, "eturn", TOKEN_RETURN);
-  case 's':
-    return check_keyword(scanner, 1, 4, "uper", TOKEN_SUPER);
-  case 'l':
-    return check_keyword(scanner, 1, 2, "et", TOKEN_LET);
-  case 'w':
-    return check_keyword(scanner, 1, 4, "hile", TOKEN_WHILE);
-
-  case 'f':
-    if (is_last_char(scanner))
-      break;
-
-    switch (scanner->start[1]) {
-    case 'n':
-      return TOKEN_FN;
-    case 'a':
-      return check_keyword(scanner, 2, 3, "lse", TOKEN_FALSE);
-    case 'o':
-      return check_keyword(scanner, 2, 1, "r", TOKEN_FOR);
-    }
+  int32_t length = (int32_t)(scanner->current - scanner->start);
 
-  case 't':
-    if (is_last_char(scanner))
-      break;
-
-    switch (scanner->start[1]) {
-    case 'h':
-      return check_keyword(scanner, 2, 2, "is", TOKEN_THIS);
-
-    case 'r':
-      return check_keyword(scanner, 2, 2, "ue", TOKEN_TRUE);
-    }
+  if (length < KEYWORD_LENGTH_MIN || length > KEYWORD_LENGTH_MAX) {
+    return TOKEN_IDENTIFIER;
   }
 
-  return TOKEN_IDENTIFIER;
-}
-
-static TokenType check_keyword(Scanner *scanner, int32_t start, int32_t length,
-                               const char *rest, TokenType type) {
-
-  bool has_keyword_length = scanner->current - scanner->start == length + start;
+  const Keyword *keyword =
+      &keywords[KEYWORD_SLOT(scanner->start[0], scanner->start[length - 1], length)];
 
-  if (has_keyword_length && memcmp(scanner->start + start, rest, length) == 0) {
-    return type;
+  if (keyword->length == length && memcmp(keyword->name, scanner->start, length) == 0) {
+    return keyword->type;
   }
 
   return TOKEN_IDENTIFIER;
@@ -245,18 +315,19 @@ static void skip_whitespace(Scanner *scanner) {
     bool is_whitespace = c == ' ' || c == '\r' || c == '\t';
 
     if (is_whitespace) {
-      eat_char(scanner);
+      scanner->current = skip_chars(scanner->current, CHARS_BLANK);
       continue;
     }
 
     if (c == '#') {
-      skip_comments(scanner);
+      scanner->current = skip_chars(scanner->current, CHARS_COMMENT);
       continue;
     }
 
     if (c == '\n') {
       scanner->line++;
       eat_char(scanner);
+      scanner->line_start = scanner->current;
       continue;
     }
 
@@ -264,12 +335,105 @@ static void skip_whitespace(Scanner *scanner) {
   }
 }
 
-static void skip_comments(Scanner *scanner) {
-  while (peek_char(scanner) != '\n' && !reached_end(scanner)) {
-    eat_char(scanner);
+static inline bool in_class(char c, CharClass chars) {
+  switch (chars) {
+  case CHARS_BLANK:
+    return c == ' ' || c == '\t' || c == '\r';
+  case CHARS_IDENTIFIER:
+    return is_alpha(c) || is_digit(c);
+  case CHARS_DIGIT:
+    return is_digit(c);
+  case CHARS_COMMENT:
+    return c != '\n' && c != '\0';
+  default:
+    return c != '"' && c != '\n' && c != '$' && c != '\0';
+  }
+}
+
+#ifdef SCANNER_SSE2
+
+/* bit i set when byte i of the block is in the class */
+static inline uint32_t class_mask(__m128i block, CharClass chars) {
+  __m128i in;
+
+  switch (chars) {
+  case CHARS_BLANK:
+    in = _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(' ')),
+                      _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('\t')),
+                                   _mm_cmpeq_epi8(block, _mm_set1_epi8('\r'))));
+    break;
+
+  case CHARS_IDENTIFIER: {
+    /* signed compares, bytes above 0x7f are negative and in no range */
+    __m128i lower = _mm_or_si128(block, _mm_set1_epi8(0x20));
+    __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                   _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+    __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8('0' - 1)),
+                                  _mm_cmplt_epi8(block, _mm_set1_epi8('9' + 1)));
+    in = _mm_or_si128(_mm_or_si128(letter, digit), _mm_cmpeq_epi8(block, _mm_set1_epi8('_')));
+    break;
+  }
+
+  case CHARS_DIGIT:
+    in = _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8('0' - 1)),
+                       _mm_cmplt_epi8(block, _mm_set1_epi8('9' + 1)));
+    break;
+
+  case CHARS_COMMENT:
+    in = _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('\n')),
+                      _mm_cmpeq_epi8(block, _mm_setzero_si128()));
+    return ~(uint32_t)_mm_movemask_epi8(in) & 0xFFFF;
+
+  default:
+    in = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('"')),
+                                   _mm_cmpeq_epi8(block, _mm_set1_epi8('\n'))),
+                      _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('$')),
+                                   _mm_cmpeq_epi8(block, _mm_setzero_si128())));
+    return ~(uint32_t)_mm_movemask_epi8(in) & 0xFFFF;
+  }
+
+  return (uint32_t)_mm_movemask_epi8(in);
+}
+
+/* past the run of chars in the class starting at at. '\0' is in no class, so a block is only
+ * loaded when every byte before it was in the run, and then holds a byte of the source */
+static inline const char *skip_chars(const char *at, CharClass chars) {
+  for (int32_t i = 0; i < SCANNER_SCALAR_PREFIX; i++, at++) {
+    if (!in_class(*at, chars)) {
+      return at;
+    }
+  }
+
+  uintptr_t offset = (uintptr_t)at & 15;
+  const __m128i *block = (const __m128i *)(at - offset);
+  uint32_t stop = (~class_mask(_mm_load_si128(block), chars) & 0xFFFF) >> offset;
+
+  if (stop != 0) {
+    return at + __builtin_ctz(stop);
+  }
+
+  while (true) {
+    block++;
+    stop = ~class_mask(_mm_load_si128(block), chars) & 0xFFFF;
+
+    if (stop != 0) {
+      return (const char *)block + __builtin_ctz(stop);
+    }
   }
 }
 
+#else
+
+static const char *skip_chars(const char *at, CharClass chars) {
+  while (in_class(*at, chars)) {
+    at++;
+  }
+
+  return at;
+}
+
+#endif // SCANNER_SSE2
+
 static char eat_char(Scanner *scanner) {
   char c = *(scanner->current);
   scanner->current++;
@@ -277,10 +441,10 @@ static char eat_char(Scanner *scanner) {
 }
 
 static char peek_char(Scanner *scanner) { return *(scanner->current); }
-static bool reached_end(Scanner *scanner) { return *scanner->current == '\0'; }
-static bool is_last_char(Scanner *scanner) {
-  return (scanner->current - scanner->start <= 1);
+static char peek_next_char(Scanner *scanner) {
+  return reached_end(scanner) ? '\0' : scanner->current[1];
 }
+static bool reached_end(Scanner *scanner) { return *scanner->current == '\0'; }
 
 static bool match_char(Scanner *scanner, char expected) {
   if (reached_end(scanner))
@@ -1,17 +1,29 @@
 #include "stack.h"
+#include "memory.h"
 #include <stdio.h>
 
-Stack stack;
+void init_stack(Stack *stack, int32_t capacity) {
+  stack->slots = ALLOCATE(Value, capacity);
+  stack->top   = stack->slots;
+  stack->end   = stack->slots + capacity;
+}
+
+void free_stack(Stack *stack) {
+  FREE_ARRAY(Value, stack->slots, stack->end - stack->slots);
+  stack->slots = NULL;
+  stack->top   = NULL;
+  stack->end   = NULL;
+}
 
-void print_stack(void) {
+void print_stack(Stack *stack) {
   printf("        ");
-  for (Value *slot = stack.slots; slot < stack.top; slot++) {
+  for (Value *slot = stack->slots; slot < stack->top; slot++) {
     printf("[");
     ant_value.print(*slot, true);
     printf("]");
   }
 
-  if (stack.top == stack.slots) {
+  if (stack->top == stack->slots) {
     printf("[]");
   }
 
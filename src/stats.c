@@ -0,0 +1,182 @@
+#include "stats.h"
+#include "debug.h"
+#include "memory.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+   uint64_t  count;
+   uint8_t   first;
+   uint8_t   second;   /* the opcode itself for single opcodes */
+}StatsRow;
+
+static OpcodeStats*  new_stats(void);
+static void          free_stats(OpcodeStats *stats);
+static void          print_stats(OpcodeStats *stats, FILE *file, int32_t limit);
+static bool          write_json(OpcodeStats *stats, const char *path);
+
+const StatsAPI ant_stats = {
+   .new = new_stats,
+   .free = free_stats,
+   .print = print_stats,
+   .write_json = write_json,
+};
+
+/* Private */
+static int32_t   opcode_rows(OpcodeStats *stats, StatsRow *rows, uint64_t *total);
+static int32_t   pair_rows(OpcodeStats *stats, StatsRow *rows, uint64_t *total);
+static int       compare_rows(const void *a, const void *b);
+
+/* Implementation */
+static OpcodeStats *new_stats(void) {
+#ifdef DEBUG_OPCODE_STATS
+   OpcodeStats *stats = ALLOCATE(OpcodeStats, 1);
+   memset(stats, 0, sizeof(OpcodeStats));
+   return stats;
+#else
+   return NULL;
+#endif
+}
+
+/* */
+
+static void free_stats(OpcodeStats *stats) {
+   if (stats != NULL) {
+      FREE(OpcodeStats, stats);
+   }
+}
+
+/* cycles are the mean per execution, they include the dispatch of the opcode */
+
+static void print_stats(OpcodeStats *stats, FILE *file, int32_t limit) {
+   StatsRow *rows = malloc(sizeof(StatsRow) * STATS_OPCODE_COUNT * STATS_OPCODE_COUNT);
+   uint64_t total;
+
+   int32_t count = opcode_rows(stats, rows, &total);
+
+   fprintf(file, "\n== opcodes: %lu executed ==\n\n", (unsigned long)total);
+   fprintf(file, "%-24s %14s %8s", "opcode", "count", "%");
+   if (STATS_HAS_CYCLES) {
+      fprintf(file, " %10s", "cycles");
+   }
+   fputc('\n', file);
+
+   for (int32_t i = 0; i < count && i < limit; i++) {
+      StatsRow row = rows[i];
+
+      fprintf(file, "%-24s %14lu %7.2f%%", ant_debug.opcode_name(row.first),
+              (unsigned long)row.count, 100.0 * row.count / total);
+
+      if (STATS_HAS_CYCLES) {
+         fprintf(file, " %10.1f", (double)stats->cycles[row.first] / row.count);
+      }
+
+      fprintf(file, "\n");
+   }
+
+   count = pair_rows(stats, rows, &total);
+
+   fprintf(file, "\n== pairs ==\n\n");
+   fprintf(file, "%-48s %14s %8s\n", "previous -> next", "count", "%");
+
+   for (int32_t i = 0; i < count && i < limit; i++) {
+      StatsRow row = rows[i];
+      char pair[64];
+
+      snprintf(pair, sizeof(pair), "%s -> %s", ant_debug.opcode_name(row.first), ant_debug.opcode_name(row.second));
+      fprintf(file, "%-48s %14lu %7.2f%%\n", pair, (unsigned long)row.count, 100.0 * row.count / total);
+   }
+
+   free(rows);
+}
+
+/* every opcode and pair that ran, most frequent first */
+
+static bool write_json(OpcodeStats *stats, const char *path) {
+   FILE *file = fopen(path, "w");
+
+   if (file == NULL) {
+      return false;
+   }
+
+   StatsRow *rows = malloc(sizeof(StatsRow) * STATS_OPCODE_COUNT * STATS_OPCODE_COUNT);
+   uint64_t total;
+
+   int32_t count = opcode_rows(stats, rows, &total);
+
+   fprintf(file, "{\"executed\": %lu, \"cycles\": %s, \"opcodes\": [\n", (unsigned long)total,
+           STATS_HAS_CYCLES ? "true" : "false");
+
+   for (int32_t i = 0; i < count; i++) {
+      fprintf(file, "  {\"name\": \"%s\", \"count\": %lu, \"cycles\": %lu}%s\n",
+              ant_debug.opcode_name(rows[i].first), (unsigned long)rows[i].count,
+              (unsigned long)stats->cycles[rows[i].first], i + 1 < count ? "," : "");
+   }
+
+   count = pair_rows(stats, rows, &total);
+
+   fprintf(file, "], \"pairs\": [\n");
+
+   for (int32_t i = 0; i < count; i++) {
+      fprintf(file, "  {\"previous\": \"%s\", \"next\": \"%s\", \"count\": %lu}%s\n",
+              ant_debug.opcode_name(rows[i].first), ant_debug.opcode_name(rows[i].second),
+              (unsigned long)rows[i].count, i + 1 < count ? "," : "");
+   }
+
+   fprintf(file, "]}\n");
+   free(rows);
+
+   return fclose(file) == 0;
+}
+
+/* Private */
+
+static int32_t opcode_rows(OpcodeStats *stats, StatsRow *rows, uint64_t *total) {
+   int32_t count = 0;
+   *total        = 0;
+
+   for (int32_t op = 0; op < STATS_OPCODE_COUNT; op++) {
+      if (stats->counts[op] > 0) {
+         rows[count++] = (StatsRow){.count = stats->counts[op], .first = op, .second = op};
+         *total += stats->counts[op];
+      }
+   }
+
+   qsort(rows, count, sizeof(StatsRow), compare_rows);
+   return count;
+}
+
+/* */
+
+static int32_t pair_rows(OpcodeStats *stats, StatsRow *rows, uint64_t *total) {
+   int32_t count = 0;
+   *total        = 0;
+
+   for (int32_t first = 0; first < STATS_OPCODE_COUNT; first++) {
+      for (int32_t second = 0; second < STATS_OPCODE_COUNT; second++) {
+         uint64_t pair = stats->pairs[first][second];
+
+         if (pair > 0) {
+            rows[count++] = (StatsRow){.count = pair, .first = first, .second = second};
+            *total += pair;
+         }
+      }
+   }
+
+   qsort(rows, count, sizeof(StatsRow), compare_rows);
+   return count;
+}
+
+/* by count descending, then by opcode so the output is stable */
+
+static int compare_rows(const void *a, const void *b) {
+   const StatsRow *x = a;
+   const StatsRow *y = b;
+
+   if (x->count != y->count) {
+      return x->count < y->count ? 1 : -1;
+   }
+
+   return x->first != y->first ? x->first - y->first : x->second - y->second;
+}
@@ -1,35 +1,55 @@
 #include "strings.h"
+#include "functions.h"
+#include "closure.h"
+#include "list.h"
+#include "f64_array.h"
+#include "map.h"
 #include "memory.h"
+#include "context.h"
+#include "alloc_sites.h"
 
 #include <stdio.h>
 #include <string.h>
 static ObjectString *to_obj_string(Value value);
 static ObjectString *new_string(const char *chars, int length);
 static ObjectString *concat_string(Value a, Value b);
+static ObjectString *build_string(Value *parts, int32_t count);
 static char *as_cstring(ObjectString *string);
 static int32_t print_string(ObjectString *string, bool debug);
 ;
 static Object *as_object(ObjectString *string);
 static void free_strings_table(void);
+static SharedChars *share_string(ObjectString *string);
+static ObjectString *from_shared(SharedChars *shared);
+static void release_shared(SharedChars *shared);
 
 StringAPI ant_string = {
     .new = new_string,
     .free_table = free_strings_table,
     .as_cstring = as_cstring,
     .concat = concat_string,
+    .build = build_string,
     .from_value = to_obj_string,
     .print = print_string,
     .as_object = as_object,
+    .share = share_string,
+    .from_shared = from_shared,
+    .release_shared = release_shared,
 };
 
-Table strings = {.count = 0, .capacity = 0, .entries = NULL};
-
 /* Private */
 static ObjectString *allocate_string(char *chars, int32_t length, uint32_t hash); 
+static ObjectString *take_string(char *chars, int32_t length);
+static ObjectString *find_interned(const char *chars, int32_t length, uint32_t hash);
+static SharedChars *new_shared(char *chars, int32_t length, uint32_t hash);
+static int32_t stringify_value(Value value, char *dest, size_t size);
+static int32_t stringify_list(ObjectList *list, char *dest, size_t size);
+static int32_t stringify_f64_array(ObjectF64Array *array, char *dest, size_t size);
+static int32_t stringify_map(ObjectMap *map, char *dest, size_t size);
 static uint32_t hash_string(const char *key, int32_t length);
 
 void free_strings_table(void) { 
-   ant_table.free(&strings); 
+   ant_table.free(&CURRENT_CONTEXT()->strings); 
 }
 
 /* */
@@ -56,15 +76,31 @@ static ObjectString *concat_string(Value a, Value b) {
 
   chars[length] = '\0';
 
-  uint32_t hash = hash_string(chars, length);
-  ObjectString *str = ant_table.find(&strings, chars, length, hash);
+  return take_string(chars, length);
+}
 
-  if (str != NULL) {
-    FREE_ARRAY(char, chars, length + 1);
-    return str;
+/* Builds a string out of count values in a single allocation.
+ * Non string values are converted with the same format used by print.
+ * */
+
+static ObjectString *build_string(Value *parts, int32_t count) {
+  int32_t length = 0;
+
+  /* first pass only measures */
+  for (int32_t i = 0; i < count; i++) {
+    length += stringify_value(parts[i], NULL, 0);
   }
 
-  return allocate_string(chars, length, hash);
+  char *chars    = ALLOCATE(char, length + 1);
+  int32_t offset = 0;
+
+  for (int32_t i = 0; i < count; i++) {
+    offset += stringify_value(parts[i], chars + offset, length + 1 - offset);
+  }
+
+  chars[length] = '\0';
+
+  return take_string(chars, length);
 }
 
 /* */
@@ -73,7 +109,7 @@ static ObjectString *new_string(const char *chars, int32_t length) {
 
   /* checks wether the const char* already exists in string table */
   uint32_t hash = hash_string(chars, length);
-  ObjectString *str = ant_table.find(&strings, chars, length, hash);
+  ObjectString *str = find_interned(chars, length, hash);
 
   if (str != NULL) {
     return str;
@@ -101,6 +137,56 @@ int32_t print_string(ObjectString *string, bool debug) {
 
 Object *as_object(ObjectString *string) { return (Object *)string; }
 
+/* the first share moves the chars of the string into the shared block, nothing is copied.
+ * Other contexts may be reading a parent string on their own threads, so it stays untouched
+ * and gets a copy */
+
+static SharedChars *share_string(ObjectString *string) {
+  if (string->shared != NULL) {
+    atomic_fetch_add_explicit(&string->shared->refs, 1, memory_order_relaxed);
+    return string->shared;
+  }
+
+  AntContext *context = CURRENT_CONTEXT();
+  ObjectString *own = ant_table.find(&context->strings, string->chars, string->length, string->hash);
+
+  if (own != string) {
+    char *chars = ALLOCATE(char, string->length + 1);
+    memcpy(chars, string->chars, string->length + 1);
+    return new_shared(chars, string->length, string->hash);
+  }
+
+  string->shared = new_shared(string->chars, string->length, string->hash);
+  atomic_fetch_add_explicit(&string->shared->refs, 1, memory_order_relaxed);
+  return string->shared;
+}
+
+/* */
+
+static ObjectString *from_shared(SharedChars *shared) {
+  ObjectString *str = find_interned(shared->chars, shared->length, shared->hash);
+
+  if (str != NULL) {
+    release_shared(shared);
+    return str;
+  }
+
+  str = allocate_string(shared->chars, shared->length, shared->hash);
+  str->shared = shared;
+  return str;
+}
+
+/* the release before the last reference orders the reads of the chars before the free */
+
+static void release_shared(SharedChars *shared) {
+  if (atomic_fetch_sub_explicit(&shared->refs, 1, memory_order_acq_rel) != 1) {
+    return;
+  }
+
+  FREE_ARRAY(char, shared->chars, shared->length + 1);
+  FREE(SharedChars, shared);
+}
+
 /* */
 
 static ObjectString *allocate_string(char *chars, int32_t length, uint32_t hash) {
@@ -110,12 +196,216 @@ static ObjectString *allocate_string(char *chars, int32_t length, uint32_t hash)
   str->length = length;
   str->chars = chars;
   str->hash = hash;
+  str->shared = NULL;
+
+  if (CURRENT_CONTEXT()->sites != NULL) {
+    ant_alloc_sites.record(CURRENT_CONTEXT()->sites, OBJ_STRING, length + 1, 0);
+  }
 
   // using table as a set, do not need to store value
-  ant_table.set(&strings, str, ant_value.make_nil());
+  ant_table.set(&CURRENT_CONTEXT()->strings, str, ant_value.make_nil());
   return str;
 }
 
+/* takes ownership of heap allocated chars. Frees it if the string is already interned */
+
+/* A parent context is frozen while children run, so a string
+ * is either always found in a parent or never.
+ * This keeps interned strings unique across all the tables.
+ * Parents chain when a parallel worker runs functions of a VM running a program. */
+
+static ObjectString *find_interned(const char *chars, int32_t length, uint32_t hash) {
+  AntContext *context = CURRENT_CONTEXT();
+
+  for (AntContext *parent = context->parent; parent != NULL; parent = parent->parent) {
+    ObjectString *str = ant_table.find(&parent->strings, chars, length, hash);
+
+    if (str != NULL) {
+      return str;
+    }
+  }
+
+  return ant_table.find(&context->strings, chars, length, hash);
+}
+
+/* */
+
+static ObjectString *take_string(char *chars, int32_t length) {
+  uint32_t hash = hash_string(chars, length);
+  ObjectString *str = find_interned(chars, length, hash);
+
+  if (str != NULL) {
+    FREE_ARRAY(char, chars, length + 1);
+    return str;
+  }
+
+  return allocate_string(chars, length, hash);
+}
+
+/* one reference, held by the caller */
+
+static SharedChars *new_shared(char *chars, int32_t length, uint32_t hash) {
+  SharedChars *shared = ALLOCATE(SharedChars, 1);
+  atomic_init(&shared->refs, 1);
+  shared->length = length;
+  shared->hash   = hash;
+  shared->chars  = chars;
+  return shared;
+}
+
+/* snprintf like: writes at most size bytes to dest and returns the full length.
+ * Passing dest as NULL only measures the value.
+ * */
+
+static int32_t stringify_value(Value value, char *dest, size_t size) {
+  switch (value.type) {
+  case VAL_NUMBER:
+    return snprintf(dest, size, "%g", value.as.number);
+
+  case VAL_BOOL:
+    return snprintf(dest, size, "%s", value.as.boolean ? "true" : "false");
+
+  case VAL_NIL:
+    return snprintf(dest, size, "nil");
+
+  case VAL_UNDEFINED:
+    return snprintf(dest, size, "Undefined");
+
+  case VAL_OBJECT:
+    break;
+  }
+
+  Object *object = value.as.object;
+
+  switch (object->type) {
+  case OBJ_STRING: {
+    ObjectString *str = (ObjectString *)object;
+
+    if (dest != NULL) {
+      memcpy(dest, str->chars, str->length);
+    }
+    return str->length;
+  }
+
+  case OBJ_CLOSURE:
+    object = FUNCTION_AS_OBJECT(((ObjectClosure *)object)->func);
+    /* fall through */
+
+  case OBJ_FUNCTION: {
+    ObjectFunction *func = (ObjectFunction *)object;
+
+    if (func->name == NULL) {
+      return snprintf(dest, size, "<script>");
+    }
+    return snprintf(dest, size, "<fn %s>", func->name->chars);
+  }
+
+  case OBJ_NATIVE:
+    return snprintf(dest, size, "<native fn>");
+
+  case OBJ_UPVALUE:
+    return snprintf(dest, size, "Upvalue");
+
+  case OBJ_LIST:
+    return stringify_list((ObjectList *)object, dest, size);
+
+  case OBJ_F64ARRAY:
+    return stringify_f64_array((ObjectF64Array *)object, dest, size);
+
+  case OBJ_MAP:
+    return stringify_map((ObjectMap *)object, dest, size);
+
+  case OBJ_FIBER:
+    return snprintf(dest, size, "<fiber>");
+
+  case OBJ_CHANNEL:
+    return snprintf(dest, size, "<channel>");
+  }
+
+  return 0;
+}
+
+/* same format as ant_list.print */
+
+static int32_t stringify_list(ObjectList *list, char *dest, size_t size) {
+#define WRITE_AT(length) ((dest) != NULL ? (dest) + (length) : NULL)
+#define SIZE_AT(length) ((dest) != NULL ? (size) - (length) : 0)
+
+  if (!ant_object.enter(LIST_AS_OBJECT(list))) {
+    return snprintf(dest, size, "[...]");
+  }
+
+  int32_t length = snprintf(dest, size, "[");
+
+  for (int32_t i = 0; i < list->items.count; i++) {
+    length += stringify_value(list->items.values[i], WRITE_AT(length), SIZE_AT(length));
+
+    if (i < list->items.count - 1) {
+      length += snprintf(WRITE_AT(length), SIZE_AT(length), ", ");
+    }
+  }
+
+  ant_object.leave();
+  length += snprintf(WRITE_AT(length), SIZE_AT(length), "]");
+  return length;
+
+#undef WRITE_AT
+#undef SIZE_AT
+}
+
+/* same format as ant_f64_array.print */
+
+static int32_t stringify_f64_array(ObjectF64Array *array, char *dest, size_t size) {
+#define WRITE_AT(length) ((dest) != NULL ? (dest) + (length) : NULL)
+#define SIZE_AT(length) ((dest) != NULL ? (size) - (length) : 0)
+
+  int32_t length = snprintf(dest, size, "f64[");
+
+  for (int32_t i = 0; i < array->length; i++) {
+    const char *format = i < array->length - 1 ? "%g, " : "%g";
+    length += snprintf(WRITE_AT(length), SIZE_AT(length), format, array->values[i]);
+  }
+
+  length += snprintf(WRITE_AT(length), SIZE_AT(length), "]");
+  return length;
+
+#undef WRITE_AT
+#undef SIZE_AT
+}
+
+/* same format as ant_map.print */
+
+static int32_t stringify_map(ObjectMap *map, char *dest, size_t size) {
+#define WRITE_AT(length) ((dest) != NULL ? (dest) + (length) : NULL)
+#define SIZE_AT(length) ((dest) != NULL ? (size) - (length) : 0)
+
+  if (!ant_object.enter(MAP_AS_OBJECT(map))) {
+    return snprintf(dest, size, "{...}");
+  }
+
+  int32_t length = snprintf(dest, size, "{");
+  int32_t cursor = 0;
+  int32_t written = 0;
+  Value key, value;
+
+  while (ant_map.next(map, &cursor, &key, &value)) {
+    length += stringify_value(key, WRITE_AT(length), SIZE_AT(length));
+    length += snprintf(WRITE_AT(length), SIZE_AT(length), ": ");
+    length += stringify_value(value, WRITE_AT(length), SIZE_AT(length));
+
+    if (++written < map->count) {
+      length += snprintf(WRITE_AT(length), SIZE_AT(length), ", ");
+    }
+  }
+
+  ant_object.leave();
+  length += snprintf(WRITE_AT(length), SIZE_AT(length), "}");
+  return length;
+
+#undef WRITE_AT
+#undef SIZE_AT
+}
+
 /* FNV Hash: http://www.isthe.com/chongo/tech/comp/fnv/ */
 static uint32_t hash_string(const char *str, int32_t length) {
 
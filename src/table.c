@@ -1,6 +1,8 @@
 #include "table.h"
 #include "config.h"
 #include "memory.h"
+#include "object.h"
+#include "strings.h"
 #include <string.h>
 #include <stdio.h>
 
@@ -12,10 +14,17 @@ static bool table_delete(Table *table, ObjectString *key);
 static void copy_table(Table *from, Table *to);
 static ObjectString *find_key(Table *table, const char *chars, int32_t length, uint32_t hash);
 
+static bool table_set_value(Table *table, Value key, Value value);
+static bool table_get_value(Table *table, Value key, Value *value);
+static bool table_delete_value(Table *table, Value key);
+static bool is_hashable(Value key);
+
 static void adjust_capacity(Table *table, int32_t capacity);
 
 /* Entries */
-static Entry *find_entry(Entry *entries, int32_t capacity, ObjectString *key);
+static Entry *find_entry(Entry *entries, int32_t capacity, Value key);
+static uint32_t hash_value(Value key);
+static bool keys_equal(Value a, Value b);
 
 TableAPI ant_table = {
     .init = init_table,
@@ -25,9 +34,15 @@ TableAPI ant_table = {
     .copy = copy_table,
     .delete = table_delete,
     .find = find_key,
-    
+    .set_value = table_set_value,
+    .get_value = table_get_value,
+    .delete_value = table_delete_value,
+    .is_hashable = is_hashable,
 };
 
+#define STRING_KEY(key) VALUE_FROM_OBJECT(STRING_AS_OBJECT(key))
+#define IS_EMPTY_KEY(entry) (VALUE_IS_UNDEFINED((entry)->key))
+
 static void init_table(Table *table) {
   table->count = 0;
   table->capacity = 0;
@@ -39,7 +54,23 @@ static void free_table(Table *table) {
   init_table(table);
 }
 
+/* */
+
 static bool table_set(Table *table, ObjectString *key, Value value) {
+  return table_set_value(table, STRING_KEY(key), value);
+}
+
+static bool table_get(Table *table, ObjectString *key, Value *value) {
+  return table_get_value(table, STRING_KEY(key), value);
+}
+
+static bool table_delete(Table *table, ObjectString *key) {
+  return table_delete_value(table, STRING_KEY(key));
+}
+
+/* */
+
+static bool table_set_value(Table *table, Value key, Value value) {
 
   if (table->count + 1 > table->capacity * OPTION_TABLE_LOAD_FACTOR) {
     int32_t capacity = GROW_CAPACITY(table->capacity);
@@ -47,12 +78,11 @@ static bool table_set(Table *table, ObjectString *key, Value value) {
   }
 
   Entry *entry = find_entry(table->entries, table->capacity, key);
+  bool is_new  = IS_EMPTY_KEY(entry);
 
   /* check if value is nil to not increment count when re-using a tombstone
    * value */
-  bool is_new = entry->key == NULL && ant_value.is_nil(entry->value);
-
-  if (is_new) table->count++;
+  if (is_new && ant_value.is_nil(entry->value)) table->count++;
 
   entry->key = key;
   entry->value = value;
@@ -60,26 +90,26 @@ static bool table_set(Table *table, ObjectString *key, Value value) {
   return is_new;
 }
 
-static bool table_get(Table *table, ObjectString *key, Value *value) {
+static bool table_get_value(Table *table, Value key, Value *value) {
   if (table->count == 0)
     return false; // Empty table
 
   Entry *entry = find_entry(table->entries, table->capacity, key);
 
-  if (entry->key == NULL)
+  if (IS_EMPTY_KEY(entry))
     return false;
 
   *value = entry->value;
   return true;
 }
 
-static bool table_delete(Table *table, ObjectString *key) {
+static bool table_delete_value(Table *table, Value key) {
   if (table->count == 0)
     return false;
 
   Entry *entry = find_entry(table->entries, table->capacity, key);
 
-  if (entry->key == NULL)
+  if (IS_EMPTY_KEY(entry))
     return false;
 
   /* Mark the entry as deleted with a "tombstone value"
@@ -87,12 +117,22 @@ static bool table_delete(Table *table, ObjectString *key) {
    * We don't decrement the count as we are not actually removing the entry
    */
 
-  entry->key = NULL;
+  entry->key = ant_value.make_undefined();
   entry->value = ant_value.from_bool(true);
 
   return true;
 }
 
+/* undefined is internal to the VM and NaN is never equal to itself */
+
+static bool is_hashable(Value key) {
+  if (VALUE_IS_UNDEFINED(key)) {
+    return false;
+  }
+
+  return !(VALUE_IS_NUMBER(key) && VALUE_AS_NUMBER(key) != VALUE_AS_NUMBER(key));
+}
+
 static void copy_table(Table *from, Table *to) {
 
   // NOTE: Don't need to check capacity as the new table will be resized
@@ -100,13 +140,15 @@ static void copy_table(Table *from, Table *to) {
   for (int32_t i = 0; i < from->capacity; i++) {
     Entry *entry = &from->entries[i];
 
-    if (entry->key == NULL)
+    if (IS_EMPTY_KEY(entry))
       continue;
 
-    table_set(to, entry->key, entry->value);
+    table_set_value(to, entry->key, entry->value);
   }
 }
 
+/* only used by the interning table, all keys are strings */
+
 static ObjectString *find_key(Table *table, const char *chars, int32_t length, uint32_t hash) {
   if (table->count == 0) return NULL;
 
@@ -115,37 +157,37 @@ static ObjectString *find_key(Table *table, const char *chars, int32_t length, u
   while (true) {
     Entry *entry =  &table->entries[index];
 
-    /* Not found */
-    if (entry->key == NULL && ant_value.is_nil(entry->value)) {
-      return NULL;
-    }
+    if (IS_EMPTY_KEY(entry)) {
+      /* Not found */
+      if (ant_value.is_nil(entry->value)) {
+        return NULL;
+      }
 
-    bool found = entry->key->length == length &&
-                 entry->key->hash == hash && 
-                 memcmp(entry->key->chars, chars, length) == 0;
+    } else {
+      ObjectString *key = STRING_FROM_VALUE(entry->key);
 
-    if (found) {
-      return entry->key;
+      bool found = key->length == length &&
+                   key->hash == hash && 
+                   memcmp(key->chars, chars, length) == 0;
+
+      if (found) {
+        return key;
+      }
     }
 
     index = (index + 1) % table->capacity;
   }
 }
 
-static Entry *find_entry(Entry *entries, int32_t capacity, ObjectString *key) {
+static Entry *find_entry(Entry *entries, int32_t capacity, Value key) {
 
-  uint32_t index = key->hash % capacity;
+  uint32_t index = hash_value(key) % capacity;
   Entry *tombstone = NULL;
 
   while (true) {
     Entry *entry = &entries[index];
 
-    // NOTE: this comparison is valid because ant interns ALL its strings
-    if (entry->key == key) {
-      return entry;
-    }
-
-    if (entry->key == NULL) {
+    if (IS_EMPTY_KEY(entry)) {
       /*  found nil key and value, return the empty entry or a tombstone any was
        * found */
       if (ant_value.is_nil(entry->value)) {
@@ -155,21 +197,81 @@ static Entry *find_entry(Entry *entries, int32_t capacity, ObjectString *key) {
       /* We found a tombstone value, assign for next iteration
        * But we keep going as the don't want the probing sequence to break
        */
-      if (ant_value.is_bool(entry->value)) {
-        if (tombstone == NULL)
-          tombstone = entry;
-      }
+      if (tombstone == NULL)
+        tombstone = entry;
+
+    } else if (keys_equal(entry->key, key)) {
+      return entry;
     }
 
     index = (index + 1) % capacity;
   }
 }
 
+/* */
+
+static uint32_t hash_value(Value key) {
+  switch (key.type) {
+  case VAL_BOOL:
+    return key.as.boolean ? 3 : 5;
+
+  case VAL_NIL:
+    return 7;
+
+  case VAL_NUMBER: {
+    /* -0 and 0 are equal, so they must hash the same */
+    double number = key.as.number == 0 ? 0 : key.as.number;
+    uint64_t bits;
+    memcpy(&bits, &number, sizeof(bits));
+
+    bits ^= bits >> 33;
+    bits *= 0xff51afd7ed558ccdULL;
+    bits ^= bits >> 33;
+    return (uint32_t)bits;
+  }
+
+  case VAL_OBJECT: {
+    if (key.as.object->type == OBJ_STRING) {
+      return STRING_FROM_VALUE(key)->hash; /* cached on creation */
+    }
+
+    uintptr_t address = (uintptr_t)key.as.object;
+    return (uint32_t)((address >> 4) ^ (address >> 32));
+  }
+
+  case VAL_UNDEFINED:
+    break;
+  }
+
+  return 0;
+}
+
+/* NOTE: comparing objects by address is valid for strings because ant interns ALL its strings */
+
+static bool keys_equal(Value a, Value b) {
+  if (a.type != b.type) {
+    return false;
+  }
+
+  switch (a.type) {
+  case VAL_OBJECT:
+    return a.as.object == b.as.object;
+  case VAL_NUMBER:
+    return a.as.number == b.as.number;
+  case VAL_BOOL:
+    return a.as.boolean == b.as.boolean;
+  case VAL_NIL:
+    return true;
+  default:
+    return false;
+  }
+}
+
 static void adjust_capacity(Table *table, int32_t new_capacity) {
   Entry *new_entries = ALLOCATE(Entry, new_capacity);
 
   for (int32_t i = 0; i < new_capacity; i++) {
-    new_entries[i].key = NULL;
+    new_entries[i].key = ant_value.make_undefined();
     new_entries[i].value = ant_value.make_nil();
   }
 
@@ -180,7 +282,7 @@ static void adjust_capacity(Table *table, int32_t new_capacity) {
     Entry *entry = &table->entries[i];
 
     /* tombstone values will be also discarted */
-    if (entry->key == NULL) {
+    if (IS_EMPTY_KEY(entry)) {
       continue;
     }
 
@@ -36,6 +36,12 @@ static const char *token_type_name(TokenType type) {
     return "TOKEN_SLASH";
   case TOKEN_STAR:
     return "TOKEN_STAR";
+  case TOKEN_LEFT_BRACKET:
+    return "TOKEN_LEFT_BRACKET";
+  case TOKEN_RIGHT_BRACKET:
+    return "TOKEN_RIGHT_BRACKET";
+  case TOKEN_COLON:
+    return "TOKEN_COLON";
   case TOKEN_BANG:
     return "TOKEN_BANG";
   case TOKEN_BANG_EQUAL:
@@ -52,6 +58,8 @@ static const char *token_type_name(TokenType type) {
     return "TOKEN_LESS";
   case TOKEN_LESS_EQUAL:
     return "TOKEN_LESS_EQUAL";
+  case TOKEN_DOT_DOT:
+    return "TOKEN_DOT_DOT";
   case TOKEN_IDENTIFIER:
     return "TOKEN_IDENTIFIER";
   case TOKEN_STRING:
@@ -76,6 +84,8 @@ static const char *token_type_name(TokenType type) {
     return "TOKEN_FN";
   case TOKEN_IF:
     return "TOKEN_IF";
+  case TOKEN_IN:
+    return "TOKEN_IN";
   case TOKEN_NIL:
     return "TOKEN_NIL";
   case TOKEN_OR:
@@ -94,6 +104,8 @@ static const char *token_type_name(TokenType type) {
     return "TOKEN_LET";
   case TOKEN_WHILE:
     return "TOKEN_WHILE";
+  case TOKEN_IMPORT:
+    return "TOKEN_IMPORT";
   case TOKEN_ERROR:
     return "TOKEN_ERROR";
   case TOKEN_EOF:
@@ -0,0 +1,179 @@
+#include "trace.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TRACE_NAME_MAX 40
+
+typedef struct {
+   atomic_uint_fast64_t  sequence;   /* index of the event + 1 once written */
+   uint64_t              timestamp;  /* ns */
+   uint64_t              duration;
+   uintptr_t             track;
+   uint32_t              thread;
+   TracePhase            phase;
+   char                  name[TRACE_NAME_MAX];
+}TraceEvent;
+
+static bool      start_trace(void);
+static void      record_event(TracePhase phase, const void *track, const char *name, uint64_t timestamp, uint64_t duration);
+static uint64_t  now_ns(void);
+static bool      write_trace(const char *path);
+
+const TraceAPI ant_trace = {
+   .start = start_trace,
+   .record = record_event,
+   .now = now_ns,
+   .write = write_trace,
+};
+
+/* Private */
+static uint32_t  thread_number(void);
+static void      write_name(FILE *file, const char *name);
+
+static TraceEvent *ring                  = NULL;
+static atomic_uint_fast64_t next_event   = 0;
+static atomic_uint_fast32_t next_thread  = 0;
+static _Thread_local uint32_t this_thread = 0;   /* 0 until the first event of the thread */
+
+/* Implementation */
+static bool start_trace(void) {
+#ifdef DEBUG_TRACE_EVENTS
+   if (ring == NULL) {
+      ring = calloc(OPTION_TRACE_EVENTS, sizeof(TraceEvent));
+   }
+
+   return ring != NULL;
+#else
+   return false;
+#endif
+}
+
+/* the slot is published last, a slot still being written is skipped by write */
+
+static void record_event(TracePhase phase, const void *track, const char *name, uint64_t timestamp, uint64_t duration) {
+   if (ring == NULL) {
+      return;
+   }
+
+   uint64_t index    = atomic_fetch_add_explicit(&next_event, 1, memory_order_relaxed);
+   TraceEvent *event = &ring[index & (OPTION_TRACE_EVENTS - 1)];
+
+   atomic_store_explicit(&event->sequence, 0, memory_order_relaxed);
+   event->timestamp = timestamp == 0 ? now_ns() : timestamp;
+   event->duration  = duration;
+   event->track     = (uintptr_t)track;
+   event->thread    = thread_number();
+   event->phase     = phase;
+
+   strncpy(event->name, name, TRACE_NAME_MAX - 1);
+   event->name[TRACE_NAME_MAX - 1] = '\0';
+
+   atomic_store_explicit(&event->sequence, index + 1, memory_order_release);
+}
+
+/* */
+
+static uint64_t now_ns(void) {
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/* timestamps are in µs from the first event kept, fibers are numbered by their pointer */
+
+static bool write_trace(const char *path) {
+   if (ring == NULL) {
+      return false;
+   }
+
+   FILE *file = fopen(path, "w");
+
+   if (file == NULL) {
+      free(ring);
+      ring = NULL;
+      return false;
+   }
+
+   static const char phases[] = {[TRACE_BEGIN] = 'B', [TRACE_END] = 'E', [TRACE_COMPLETE] = 'X'};
+
+   uint64_t count = atomic_load(&next_event);
+   uint64_t first = count > OPTION_TRACE_EVENTS ? count - OPTION_TRACE_EVENTS : 0;
+   uint64_t start = 0;
+   bool comma     = false;
+
+   fprintf(file, "{\"displayTimeUnit\": \"ns\", \"otherData\": {\"dropped\": %lu}, \"traceEvents\": [\n",
+           (unsigned long)first);
+
+   for (uint64_t i = first; i < count; i++) {
+      TraceEvent *event = &ring[i & (OPTION_TRACE_EVENTS - 1)];
+
+      if (atomic_load_explicit(&event->sequence, memory_order_acquire) != i + 1) {
+         continue;
+      }
+
+      start = start == 0 || event->timestamp < start ? event->timestamp : start;
+   }
+
+   for (uint64_t i = first; i < count; i++) {
+      TraceEvent *event = &ring[i & (OPTION_TRACE_EVENTS - 1)];
+
+      if (atomic_load_explicit(&event->sequence, memory_order_acquire) != i + 1) {
+         continue;
+      }
+
+      fprintf(file, "%s  {\"name\": ", comma ? ",\n" : "");
+      write_name(file, event->name);
+      fprintf(file, ", \"ph\": \"%c\", \"ts\": %.3f, \"pid\": %u, \"tid\": %lu",
+              phases[event->phase], (event->timestamp - start) / 1e3, event->thread,
+              (unsigned long)(event->track >> 4 & 0xffffffff));
+
+      if (event->phase == TRACE_COMPLETE) {
+         fprintf(file, ", \"dur\": %.3f", event->duration / 1e3);
+      }
+
+      fprintf(file, "}");
+      comma = true;
+   }
+
+   fprintf(file, "\n]}\n");
+
+   free(ring);
+   ring = NULL;
+   atomic_store(&next_event, 0);
+
+   return fclose(file) == 0;
+}
+
+/* Private */
+
+static uint32_t thread_number(void) {
+   if (this_thread == 0) {
+      this_thread = (uint32_t)atomic_fetch_add(&next_thread, 1) + 1;
+   }
+
+   return this_thread;
+}
+
+/* module paths may hold anything */
+
+static void write_name(FILE *file, const char *name) {
+   fputc('"', file);
+
+   for (const char *c = name; *c != '\0'; c++) {
+      if (*c == '"' || *c == '\\') {
+         fputc('\\', file);
+      }
+
+      if ((unsigned char)*c < 0x20) {
+         fprintf(file, "\\u%04x", *c);
+      } else {
+         fputc(*c, file);
+      }
+   }
+
+   fputc('"', file);
+}
@@ -3,10 +3,12 @@
 
 static int32_t unpack_int32(uint8_t *bytes, int32_t num_bytes);
 static uint16_t unpack_uint16(uint8_t *bytes);
+static uint32_t hash_bytes(const char *bytes, int32_t length);
 
 Utils ant_utils = {
     .unpack_int32 = unpack_int32,
     .unpack_uint16 = unpack_uint16,
+    .hash = hash_bytes,
 };
 
 /**
@@ -42,3 +44,15 @@ static uint16_t unpack_uint16(uint8_t *bytes) {
 }
 
 // let i = 0; while( i < 4) { print i; i = i + 1;}
+
+/* FNV Hash: http://www.isthe.com/chongo/tech/comp/fnv/ */
+static uint32_t hash_bytes(const char *bytes, int32_t length) {
+  uint32_t hash = 2166136261u;
+
+  for (int32_t i = 0; i < length; i++) {
+    hash ^= (uint8_t)bytes[i];
+    hash *= 16777619;
+  }
+
+  return hash;
+}
@@ -1,79 +1,113 @@
 #include "var_mapping.h"
+#include "context.h"
 #include "strings.h"
 #include "table.h"
 #include "value.h"
 #include <stdio.h>
 
-VarMapping mapping;
-
 void init_mapping(void);
 void free_mapping(void);
 Value add_mapping(ObjectString *name);
 ObjectString *get_variable_name(int32_t index);
+int32_t find_mapping(ObjectString *name);
+void truncate_mapping(int32_t count);
 
 const VarMappingAPI ant_mapping = {
     .init = init_mapping,
     .free = free_mapping,
     .add =  add_mapping,
     .find_name = get_variable_name,
+    .find = find_mapping,
+    .truncate = truncate_mapping,
 };
 
 void init_mapping(void) {
-  mapping.count = 0;
-  ant_table.init(&mapping.table);
-  ant_value_array.init(&mapping.reverse_lookup);
+  VarMapping *mapping = &CURRENT_CONTEXT()->mapping;
+
+  mapping->count = 0;
+  ant_table.init(&mapping->table);
+  ant_value_array.init(&mapping->reverse_lookup);
 }
 
 void free_mapping(void) {
-  ant_table.free(&mapping.table);
-  ant_value_array.free(&mapping.reverse_lookup);
-  mapping.count = -1;
+  VarMapping *mapping = &CURRENT_CONTEXT()->mapping;
+
+  ant_table.free(&mapping->table);
+  ant_value_array.free(&mapping->reverse_lookup);
+  mapping->count = -1;
 }
 
 Value add_mapping(ObjectString *name) {
+   VarMapping *mapping = &CURRENT_CONTEXT()->mapping;
 
-   if(mapping.count == -1) {
+   if(mapping->count == -1) {
     fprintf(stderr, "Error: Mapping is not initialized.\n");
     return ant_value.make_nil();
    }
 
-   if(mapping.count != mapping.reverse_lookup.count) {
+   if(mapping->count != mapping->reverse_lookup.count) {
     fprintf(stderr, "Error: Mapping reverse lookup index mismatch: mapping: %d <> lookup: %d\n",
-          mapping.count, mapping.reverse_lookup.count);
+          mapping->count, mapping->reverse_lookup.count);
 
     return ant_value.make_nil();
    }
 
   Value index_value;
-  bool found = ant_table.get(&mapping.table, name, &index_value);
+  bool found = ant_table.get(&mapping->table, name, &index_value);
 
   if (found) {
     return index_value;
   }
 
-  index_value       = ant_value.from_number(mapping.count);
-  bool is_new       = ant_table.set(&mapping.table, name, index_value);
+  index_value       = ant_value.from_number(mapping->count);
+  bool is_new       = ant_table.set(&mapping->table, name, index_value);
 
   if (!is_new) {
     fprintf(stderr, "Warning: Variable '%s' being overwritten in mapping.\n", name->chars);
   }
 
   Value name_value = ant_value.from_object(ant_string.as_object(name));
-  ant_value_array.write(&mapping.reverse_lookup, name_value);
+  ant_value_array.write(&mapping->reverse_lookup, name_value);
 
-  mapping.count++;
+  mapping->count++;
   return index_value;
 }
 
 ObjectString *get_variable_name(int32_t index){
+   VarMapping *mapping = &CURRENT_CONTEXT()->mapping;
 
-   if(index < 0 || index >= mapping.count || index >= mapping.reverse_lookup.count) {
+   if(index < 0 || index >= mapping->count || index >= mapping->reverse_lookup.count) {
     fprintf(stderr, "Error: Invalid variable index: %d. mapping->count: %d, reverse_lookup->count: %d\n",
-          index, mapping.count, mapping.reverse_lookup.count);
+          index, mapping->count, mapping->reverse_lookup.count);
 
     return NULL;
    }
 
-   Value name_value = ant_value_array.at(&mapping.reverse_lookup, index);
+   Value name_value = ant_value_array.at(&mapping->reverse_lookup, index);
    return ant_string.from_value(name_value);
 }
+
+int32_t find_mapping(ObjectString *name){
+   Value index_value;
+
+   if(!ant_table.get(&CURRENT_CONTEXT()->mapping.table, name, &index_value)){
+      return -1;
+   }
+
+   return (int32_t)ant_value.as_number(index_value);
+}
+
+/* forgets every name from count on, the next add reuses their indices */
+
+void truncate_mapping(int32_t count){
+   VarMapping *mapping = &CURRENT_CONTEXT()->mapping;
+
+   for(int32_t i = count; i < mapping->count; i++){
+      ant_table.delete(&mapping->table, ant_string.from_value(mapping->reverse_lookup.values[i]));
+   }
+
+   if(count < mapping->count){
+      mapping->count                = count;
+      mapping->reverse_lookup.count = count;
+   }
+}
@@ -9,10 +9,22 @@
 #include "value_array.h"
 #include "functions.h"
 #include "closure.h"
+#include "list.h"
+#include "map.h"
+#include "f64_array.h"
 #include "natives.h"
 #include "var_mapping.h"
 #include "upvalues.h"
 #include "stack.h"
+#include "context.h"
+#include "fiber.h"
+#include "event_loop.h"
+#include "isolate.h"
+#include "module.h"
+#include "profiler.h"
+#include "trace.h"
+#include "alloc_sites.h"
+#include "perf.h"
 
 #include "debug.h"
 #include <stdarg.h>
@@ -23,24 +35,38 @@
 /* Public */
 static VM *new_vm();
 static InterpretResult interpret(VM *vm, const char *source);
+static ObjectFunction *compile(VM *vm, const char *source);
+static InterpretResult execute(VM *vm, ObjectFunction *main_func);
+static void reset(VM *vm);
 static void repl(VM *vm);
 static void free_vm(VM *vm);
+static InterpretResult run_fiber(VM *vm, ObjectFiber *fiber, Value value);
+static InterpretResult call_closure(VM *vm, ObjectClosure *closure, int32_t arg_count, Value *args, Value *result);
+static void runtime_error(VM *vm, const char *format, ...);
 
 AntVMAPI ant_vm = {
     .new = new_vm,
     .free = free_vm,
     .interpret = interpret,
+    .compile = compile,
+    .execute = execute,
+    .reset = reset,
     .repl = repl,
+    .run_fiber = run_fiber,
+    .call = call_closure,
+    .runtime_error = runtime_error,
 };
 
 /* VM */
 static InterpretResult run(VM *vm);
-static void runtime_error(VM *vm, const char *format, ...);
 
 /* functions */
 static bool call_value(VM *vm, Value callee, int32_t arg_count);
 static bool call(VM* vm, ObjectClosure *closure, int32_t arg_count);
 
+/* lists and f64arrays */
+static bool resolve_index(VM *vm, Value index_value, int32_t count, int32_t *index);
+
 /* Implementation */
 static VM *new_vm() {
   VM *vm = (VM *)malloc(sizeof(VM));
@@ -50,12 +76,29 @@ static VM *new_vm() {
     exit(1);
   }
 
-  STACK_RESET();
-  ant_mapping.init();
-  ant_compiler.init(&vm->compiler, COMPILATION_TYPE_SCRIPT);
+  /* everything allocated from now on belongs to this VM */
+  vm->context = ant_context.new();
+  ant_context.make_current(vm->context);
+
+  /* allocated before the natives mark, reset keeps it */
+  vm->root   = ant_fiber.new(NULL);
+  vm->fiber  = vm->root;
+  vm->stack  = &vm->root->stack;
+  vm->frames = vm->root->frames;
+  vm->host     = NULL;
+  vm->loop     = NULL;
+  vm->isolates = NULL;
+  vm->channel  = NULL;
+  vm->stats    = ant_stats.new();
+  atomic_init(&vm->sample_ticks, 0);
+  vm->perf     = NULL;
+
   ant_value_array.init_undefined(&vm->globals);
+  ant_table.init(&vm->modules);
   ant_native.register_all(vm);
 
+  vm->native_count       = vm->globals.count;
+  vm->natives_mark       = ant_context.mark(vm->context);
   vm->open_upvalues.head = NULL;
   vm->frame_count        = 0;
   return vm;
@@ -64,13 +107,38 @@ static VM *new_vm() {
 /* */
 
 static InterpretResult interpret(VM *vm, const char *source) {
-
-  ObjectFunction *main_func = ant_compiler.compile(&vm->compiler, source);
+  ObjectFunction *main_func = compile(vm, source);
 
   if (main_func == NULL) {
     return INTERPRET_COMPILE_ERROR;
   }
 
+  return execute(vm, main_func);
+}
+
+/* */
+
+/* a compiler per call, names of globals persist through the context mapping */
+
+static ObjectFunction *compile(VM *vm, const char *source) {
+  ant_context.make_current(vm->context);
+
+  uint64_t started = TRACE_CLOCK();
+
+  Compiler compiler;
+  ant_compiler.init(&compiler, COMPILATION_TYPE_SCRIPT);
+  ObjectFunction *func = ant_compiler.compile(&compiler, source);
+
+  TRACE_SPAN(vm->fiber, "compile", started);
+  return func;
+}
+
+/* */
+
+static InterpretResult execute(VM *vm, ObjectFunction *main_func) {
+  Stack *stack = vm->stack;
+  ant_context.make_current(vm->context);
+
   /* add main func or type COMPILATION_TYPE_SCRIPT to slot 0 in the stack and calls it
      note that in locals.c:init_local_stack, we claim the slot 0 for the VM for this purpose 
    */
@@ -81,7 +149,48 @@ static InterpretResult interpret(VM *vm, const char *source) {
   STACK_PUSH(VALUE_FROM_OBJECT(CLOSURE_AS_OBJECT(closure)));
 
   call(vm, closure, 0);
-  return run(vm);
+  InterpretResult result = run(vm);
+
+  if (result == INTERPRET_OK) {
+    STACK_POP();
+  }
+
+  /* fibers still waiting on timers or fds finish before the script does */
+  if (result == INTERPRET_OK && !ant_event_loop.drain(vm)) {
+    result = INTERPRET_RUNTIME_ERROR;
+  }
+
+  /* and so do the isolates it started, whatever the result */
+  ant_isolate.join_all(vm);
+
+  return result;
+}
+
+/* */
+
+static void reset(VM *vm) {
+  ant_context.make_current(vm->context);
+  ant_fiber.unwind(vm);
+  ant_event_loop.free(vm);
+  ant_isolate.join_all(vm);
+
+  Stack *stack = vm->stack;
+
+  STACK_RESET();
+  vm->frame_count        = 0;
+  vm->open_upvalues.head = NULL;
+
+  for (int32_t i = vm->native_count; i < vm->globals.count; i++) {
+    vm->globals.values[i] = ant_value.make_undefined();
+  }
+
+  /* names of the globals go with the strings released below, so do the modules */
+  ant_mapping.truncate(vm->native_count);
+  ant_table.free(&vm->modules);
+  ant_table.init(&vm->modules);
+
+  vm->context->parent = NULL;
+  ant_context.release(vm->context, vm->natives_mark);
 }
 
 
@@ -106,9 +215,6 @@ static void repl(VM *vm) {
       break;
     }
 
-
-    // FIX ME: this is a hack to reset the compiler state. look into a better way to do this
-    ant_compiler.init(&vm->compiler, COMPILATION_TYPE_SCRIPT);
     interpret(vm, line);
     printf("\n");
   }
@@ -117,14 +223,15 @@ static void repl(VM *vm) {
 /* */
 
 static void free_vm(VM *vm) {
-  ant_memory.free_objects();
-
-  /* this only clear entries in the hash table
-   * the actual strings allocations are managed by the garbage collector
-   * */
-  ant_string.free_table();
+  ant_event_loop.free(vm);
+  ant_isolate.join_all(vm);
   ant_value_array.free(&vm->globals);
-  ant_mapping.free();
+  ant_table.free(&vm->modules);
+  ant_stats.free(vm->stats);
+  ant_alloc_sites.stop(vm);
+
+  /* all objects, the strings table and the mapping */
+  ant_context.free(vm->context);
   FREE(VM, vm);
 }
 
@@ -134,6 +241,7 @@ static InterpretResult run(VM *vm) {
 
    CallFrame *frame = vm->frames + (vm->frame_count -1);
    register uint8_t *ip = frame->ip;
+   register Stack *stack = vm->stack;
 
 #define READ_CHUNK_BYTE() (*ip++)
 #define READ_CHUNK_CONSTANT() (frame->closure->func->chunk.constants.values[READ_CHUNK_BYTE()])
@@ -179,13 +287,14 @@ static InterpretResult run(VM *vm) {
 #ifdef DEBUG_TRACE_EXECUTION
     /* address to index, get the relative offset */
     int32_t offset = (int32_t)(ip - frame->closure->func->chunk.code);
-    ant_debug.disassemble_instruction(&vm->compiler, &frame->closure->func->chunk, offset);
-    print_stack();
+    ant_debug.disassemble_instruction(NULL, &frame->closure->func->chunk, offset);
+    print_stack(stack);
 #endif
 
-    uint8_t instruction;
+    uint8_t instruction = READ_CHUNK_BYTE();
+    STATS_RECORD(vm->stats, instruction);
 
-    switch ((instruction = READ_CHUNK_BYTE())) {
+    switch (instruction) {
 
     case OP_JUMP: {
       uint16_t offset = READ_16BIT_OPERANDS();
@@ -206,24 +315,74 @@ static InterpretResult run(VM *vm) {
 
     case OP_LOOP: {
       uint16_t offset = READ_16BIT_OPERANDS();
+      PROFILE_SAFEPOINT(vm, frame, ip);
       ip -= offset;
       break;
     }
 
+    /* slots hold [counter][limit][loop variable], enter the loop or jump past it */
+    case OP_FOR_RANGE: {
+      Value *range = frame->slots + READ_CHUNK_BYTE();
+      uint16_t offset = READ_16BIT_OPERANDS();
+
+      if (!VALUE_IS_NUMBER(range[0]) || !VALUE_IS_NUMBER(range[1])) {
+        runtime_error(vm, "Range bounds must be numbers");
+        return INTERPRET_RUNTIME_ERROR;
+      }
+
+      if (VALUE_AS_NUMBER(range[0]) < VALUE_AS_NUMBER(range[1])) {
+        range[2] = range[0];
+      } else {
+        ip += offset;
+      }
+
+      break;
+    }
+
+    /* the hidden counter and limit were checked by OP_FOR_RANGE and can't be reassigned,
+     * so they are read unchecked. The body may freely overwrite the loop variable. */
+    case OP_FOR_STEP: {
+      Value *range = frame->slots + READ_CHUNK_BYTE();
+      uint16_t offset = READ_16BIT_OPERANDS();
+      double counter = ++range[0].as.number;
+
+      if (counter < range[1].as.number) {
+        PROFILE_SAFEPOINT(vm, frame, ip);
+        range[2] = VALUE_FROM_NUMBER(counter);
+        ip -= offset;
+      }
+
+      break;
+    }
+
    /* NOTE: Compiler and vm are setup so that arguments and parameters line up perfectly in the stack 
     *       so there is no need for binding the arguments to the parameters here.
     */
     case OP_CALL: {
       int32_t arg_count = (int32_t)READ_CHUNK_BYTE();
       frame->ip = ip; // sync frame ip with ip
+      PROFILE_SAFEPOINT(vm, frame, ip);
                       
       /* note how arg_count will be the number of arguments on the stack. we grab the last one */
       if(!call_value(vm, STACK_PEEK(arg_count), arg_count)){
          return INTERPRET_RUNTIME_ERROR;
       }
-      /* if call_value is successful there will be a new frame */
+      /* if call_value is successful there will be a new frame,
+       * or another fiber when the callee was resume() or yield() */
+      /* back to a native running a fiber, it may have no frames left, see run_fiber */
+      if (vm->fiber == vm->host) {
+        return INTERPRET_OK;
+      }
+
+      CallFrame *caller = frame;
+      stack = vm->stack;
       frame = vm->frames + (vm->frame_count - 1);
       ip    = frame->ip;
+
+      /* a native returned to the same frame, its ticks go to the line calling it */
+      if (frame == caller) {
+        PROFILE_SAFEPOINT(vm, frame, ip);
+      }
       break;
    }
 
@@ -305,6 +464,8 @@ static InterpretResult run(VM *vm) {
 #undef CAPTURE_UPVALUES
 
     case OP_RETURN:{
+         PROFILE_SAFEPOINT(vm, frame, ip);
+         TRACE_LEAVE(vm->fiber, TRACE_FUNCTION_NAME(frame->closure->func));
          Value result = STACK_POP();
 
          /* close upvalues for the function when it returns */
@@ -313,9 +474,29 @@ static InterpretResult run(VM *vm) {
          
       /* script main function */
        if(vm->frame_count == 0){
-        STACK_POP();
         ip = frame->ip;
-        return INTERPRET_OK;
+
+        /* left for execute or call to pop, the window goes with its arguments */
+        if (vm->fiber == vm->root) {
+          STACK_SET_TOP(frame->slots);
+          STACK_PUSH(result);
+          return INTERPRET_OK;
+        }
+
+        STACK_POP();
+
+        /* a fiber function, the result goes to the resume() waiting on it */
+        ant_fiber.finish(vm, result);
+        PERF_SYNC(vm, false);
+
+        if (vm->fiber == vm->host) {
+          return INTERPRET_OK;
+        }
+
+        stack = vm->stack;
+        frame = vm->frames + (vm->frame_count - 1);
+        ip    = frame->ip;
+        break;
        }
 
        /*  set the stack top to begining of the current frame stack window, 
@@ -331,8 +512,9 @@ static InterpretResult run(VM *vm) {
         *                 ^ stack top
         * */
 
-       stack.top = frame->slots;
+       STACK_SET_TOP(frame->slots);
        STACK_PUSH(result);
+       PERF_SYNC(vm, false);
        frame = vm->frames + (vm->frame_count - 1);
        ip = frame->ip;
        break;
@@ -351,7 +533,10 @@ static InterpretResult run(VM *vm) {
     }
 
     case OP_POSITIVE:
-      STACK_PUSH(STACK_POP());
+      if (!VALUE_IS_NUMBER(STACK_PEEK(0))) {
+        runtime_error(vm, "Operand must be a number");
+        return INTERPRET_RUNTIME_ERROR;
+      }
       break;
 
     case OP_ADD: {
@@ -367,6 +552,190 @@ static InterpretResult run(VM *vm) {
       break;
     }
 
+    /* interpolated strings: all parts are on the stack, we allocate and intern only once */
+    case OP_BUILD_STRING: {
+      int32_t part_count = (int32_t)READ_CHUNK_BYTE();
+      ObjectString *str  = ant_string.build(STACK_TOP() - part_count, part_count);
+
+      STACK_DECREMENT_TOP(part_count);
+      STACK_PUSH(VALUE_FROM_OBJECT(STRING_AS_OBJECT(str)));
+      break;
+    }
+
+    /* [path] -> [exports] when the module ran before, [path][module] and its frame otherwise */
+    case OP_IMPORT: {
+      ObjectString *path = STRING_FROM_VALUE(STACK_PEEK(0));
+      Value exports;
+
+      if (ant_module.find(vm, path, &exports)) {
+        STACK_POP();
+        STACK_PUSH(exports);
+        ip++; /* over OP_IMPORT_END */
+        break;
+      }
+
+      frame->ip = ip;
+      ObjectClosure *module = ant_module.load(vm, path);
+
+      if (module == NULL) {
+        return INTERPRET_RUNTIME_ERROR;
+      }
+
+      STACK_PUSH(VALUE_FROM_OBJECT(CLOSURE_AS_OBJECT(module)));
+
+      if (!call(vm, module, 0)) {
+        return INTERPRET_RUNTIME_ERROR;
+      }
+
+      frame = vm->frames + (vm->frame_count - 1);
+      ip    = frame->ip;
+      break;
+    }
+
+    /* [path][exports] -> [exports] */
+    case OP_IMPORT_END: {
+      Value exports = STACK_POP();
+      ant_module.loaded(vm, STRING_FROM_VALUE(STACK_PEEK(0)), exports);
+      STACK_POP();
+      STACK_PUSH(exports);
+      break;
+    }
+
+    case OP_LIST: {
+      ObjectList *list = ant_list.new();
+      STACK_PUSH(VALUE_FROM_OBJECT(LIST_AS_OBJECT(list)));
+      break;
+    }
+
+    /* only emitted by list literals, so the list is always below the item */
+    case OP_LIST_APPEND: {
+      Value item = STACK_POP();
+      ant_list.append(LIST_FROM_VALUE(STACK_PEEK(0)), item);
+      break;
+    }
+
+    case OP_MAP: {
+      ObjectMap *map = ant_map.new();
+      STACK_PUSH(VALUE_FROM_OBJECT(MAP_AS_OBJECT(map)));
+      break;
+    }
+
+    /* only emitted by map literals: [map][key][value] -> [map] */
+    case OP_MAP_INSERT: {
+      Value key = STACK_PEEK(1);
+
+      if (!ant_table.is_hashable(key)) {
+        runtime_error(vm, "Map key cannot be NaN");
+        return INTERPRET_RUNTIME_ERROR;
+      }
+
+      ant_map.set(MAP_FROM_VALUE(STACK_PEEK(2)), key, STACK_PEEK(0));
+      STACK_DECREMENT_TOP(2);
+      break;
+    }
+
+    /* [target][index] -> [value] */
+    case OP_INDEX_GET: {
+      Value target = STACK_PEEK(1);
+      int32_t index;
+
+      if (OBJECT_IS_LIST(target)) {
+        ObjectList *list = LIST_FROM_VALUE(target);
+
+        if (!resolve_index(vm, STACK_PEEK(0), list->items.count, &index)) {
+          return INTERPRET_RUNTIME_ERROR;
+        }
+
+        STACK_DECREMENT_TOP(2);
+        STACK_PUSH(list->items.values[index]);
+        break;
+      }
+
+      /* f64arrays box the raw double directly */
+      if (OBJECT_IS_F64ARRAY(target)) {
+        ObjectF64Array *array = F64_ARRAY_FROM_VALUE(target);
+
+        if (!resolve_index(vm, STACK_PEEK(0), array->length, &index)) {
+          return INTERPRET_RUNTIME_ERROR;
+        }
+
+        STACK_DECREMENT_TOP(2);
+        STACK_PUSH(VALUE_FROM_NUMBER(array->values[index]));
+        break;
+      }
+
+      /* missing keys read as nil */
+      if (OBJECT_IS_MAP(target)) {
+        Value value;
+
+        if (!ant_map.get(MAP_FROM_VALUE(target), STACK_PEEK(0), &value)) {
+          value = VALUE_FROM_NIL();
+        }
+
+        STACK_DECREMENT_TOP(2);
+        STACK_PUSH(value);
+        break;
+      }
+
+      runtime_error(vm, "Only lists, f64arrays and maps can be indexed");
+      return INTERPRET_RUNTIME_ERROR;
+    }
+
+    /* [target][index][value] -> [value] */
+    case OP_INDEX_SET: {
+      Value target = STACK_PEEK(2);
+      Value value  = STACK_PEEK(0);
+      int32_t index;
+
+      if (OBJECT_IS_LIST(target)) {
+        ObjectList *list = LIST_FROM_VALUE(target);
+
+        if (!resolve_index(vm, STACK_PEEK(1), list->items.count, &index)) {
+          return INTERPRET_RUNTIME_ERROR;
+        }
+
+        list->items.values[index] = value;
+        STACK_DECREMENT_TOP(3);
+        STACK_PUSH(value);
+        break;
+      }
+
+      if (OBJECT_IS_F64ARRAY(target)) {
+        ObjectF64Array *array = F64_ARRAY_FROM_VALUE(target);
+
+        if (!VALUE_IS_NUMBER(value)) {
+          runtime_error(vm, "f64array items must be numbers");
+          return INTERPRET_RUNTIME_ERROR;
+        }
+
+        if (!resolve_index(vm, STACK_PEEK(1), array->length, &index)) {
+          return INTERPRET_RUNTIME_ERROR;
+        }
+
+        array->values[index] = VALUE_AS_NUMBER(value);
+        STACK_DECREMENT_TOP(3);
+        STACK_PUSH(value);
+        break;
+      }
+
+      if (OBJECT_IS_MAP(target)) {
+        Value key = STACK_PEEK(1);
+
+        if (!ant_table.is_hashable(key)) {
+          runtime_error(vm, "Map key cannot be NaN");
+          return INTERPRET_RUNTIME_ERROR;
+        }
+
+        ant_map.set(MAP_FROM_VALUE(target), key, value);
+        STACK_DECREMENT_TOP(3);
+        STACK_PUSH(value);
+        break;
+      }
+
+      runtime_error(vm, "Only lists, f64arrays and maps can be indexed");
+      return INTERPRET_RUNTIME_ERROR;
+    }
+
     case OP_SUBTRACT:
       BINARY_OP(VALUE_FROM_NUMBER, -);
       break;
@@ -562,7 +931,63 @@ static InterpretResult run(VM *vm) {
 }
 
 
+/* The native calling this is on top of the stack of the host fiber, below it a slot for the
+ * value passed back by yield or return, as for a resume() call. Hosts nest, each run()
+ * returns to its own.
+ */
+
+static InterpretResult run_fiber(VM *vm, ObjectFiber *fiber, Value value) {
+  Stack *stack      = vm->stack;
+  ObjectFiber *host = vm->host;
+
+  STACK_PUSH(VALUE_FROM_NIL());
+
+  if (!ant_fiber.resume(vm, fiber, value)) {
+    return INTERPRET_RUNTIME_ERROR;
+  }
+
+  vm->host               = fiber->caller;
+  InterpretResult result = run(vm);
+  vm->host               = host;
+
+  if (result == INTERPRET_OK) {
+    STACK_POP();
+  }
+
+  return result;
+}
+
+/* the function runs as the root does a script, its return value is left on the stack */
+
+static InterpretResult call_closure(VM *vm, ObjectClosure *closure, int32_t arg_count, Value *args, Value *result) {
+  Stack *stack = vm->stack;
+  ant_context.make_current(vm->context);
+
+  STACK_PUSH(VALUE_FROM_OBJECT(CLOSURE_AS_OBJECT(closure)));
+
+  for (int32_t i = 0; i < arg_count; i++) {
+    STACK_PUSH(args[i]);
+  }
+
+  if (!call(vm, closure, arg_count)) {
+    return INTERPRET_RUNTIME_ERROR;
+  }
+
+  InterpretResult status = run(vm);
+
+  if (status == INTERPRET_OK) {
+    *result = STACK_POP();
+  }
+
+  return status;
+}
+
+/* */
+
 static bool call_value(VM *vm, Value callee, int32_t arg_count) {
+   /* the caller stack, resume() and yield() switch vm->stack */
+   Stack *stack = vm->stack;
+
    if(ant_value.is_object(callee)){
       switch(ant_object.type(callee)){
 
@@ -575,7 +1000,24 @@ static bool call_value(VM *vm, Value callee, int32_t arg_count) {
             
          case OBJ_NATIVE:{
             ObjectNative *native = ant_native.from_value(callee);
-            Value result         = native->func(arg_count, STACK_TOP() - arg_count);
+
+            if(arg_count != native->arity){
+               runtime_error(vm, "Expected %d arguments but got %d", native->arity, arg_count);
+               return false;
+            }
+
+            /* on the fiber calling it, resume() and yield() switch vm->fiber */
+            ObjectFiber *fiber = vm->fiber;
+            uint64_t started   = TRACE_CLOCK();
+
+            Value result = native->func(vm, arg_count, STACK_TOP() - arg_count);
+            TRACE_SPAN(fiber, ant_native.name(native), started);
+            PERF_SYNC(vm, false);
+
+            /* natives report their own errors and return undefined */
+            if(VALUE_IS_UNDEFINED(result)){
+               return false;
+            }
 
             STACK_DECREMENT_TOP(arg_count + 1);
             STACK_PUSH(result);
@@ -593,14 +1035,15 @@ static bool call_value(VM *vm, Value callee, int32_t arg_count) {
 /* */
 
 static bool call(VM *vm, ObjectClosure *closure, int32_t arg_count) {
+   Stack *stack = vm->stack;
 
    if(arg_count != closure->func->arity){
       runtime_error(vm, "Expected %d arguments but got %d", closure->func->arity, arg_count);
       return false;
    }
 
-   if(vm->frame_count == OPTION_FRAMES_MAX){
-      runtime_error(vm, "Reached maximum call stack depth of %d", OPTION_FRAMES_MAX);
+   if(vm->frame_count == vm->fiber->frame_max){
+      runtime_error(vm, "Reached maximum call stack depth of %d", vm->fiber->frame_max);
       return false;
    }
 
@@ -618,6 +1061,29 @@ static bool call(VM *vm, ObjectClosure *closure, int32_t arg_count) {
    // -1 is to account for stack slot 0 which is reserved for the VM/method calls.
    frame->slots = STACK_TOP() - arg_count - 1;
    vm->frame_count++;
+
+   TRACE_ENTER(vm->fiber, TRACE_FUNCTION_NAME(closure->func));
+   PERF_SYNC(vm, true);
+   return true;
+}
+
+/* checks the index is an integer within [0, count) */
+
+static bool resolve_index(VM *vm, Value index_value, int32_t count, int32_t *index) {
+
+   if(!VALUE_IS_NUMBER(index_value)){
+      runtime_error(vm, "Index must be a number");
+      return false;
+   }
+
+   double number = VALUE_AS_NUMBER(index_value);
+
+   if(number < 0 || number >= count || number != (double)(int32_t)number){
+      runtime_error(vm, "Index %g out of bounds for length %d", number, count);
+      return false;
+   }
+
+   *index = (int32_t)number;
    return true;
 }
 
@@ -628,26 +1094,45 @@ static void runtime_error(VM *vm, const char *format, ...) {
   va_end(args);
   fputs("\n", stderr);
 
-  for(int32_t i = vm->frame_count -1; i >=0; i--){
+  /* the running fiber first, then the fibers waiting on it down to the script */
+  ObjectFiber *fiber  = vm->fiber;
+  CallFrame *frames   = vm->frames;
+  int32_t frame_count = vm->frame_count;
+
+  while (fiber != NULL) {
 
-    CallFrame *frame = &vm->frames[i];
+    for(int32_t i = frame_count -1; i >=0; i--){
 
-    ObjectFunction *func = frame->closure->func;
-    /* -1 because interpreter is one step ahead when error occurs */
-    size_t instruction   = frame->ip - frame->closure->func->chunk.code - 1;  
-    int32_t line         = ant_line.get(&frame->closure->func->chunk.lines, instruction);
+      CallFrame *frame = &frames[i];
 
-    fprintf(stderr, "[line %d] in ", line);
-   
-    if(func->name == NULL){
-       fprintf(stderr, "script\n");
+      ObjectFunction *func = frame->closure->func;
+      /* -1 because interpreter is one step ahead when error occurs */
+      size_t instruction   = frame->ip - frame->closure->func->chunk.code - 1;  
+      int32_t line         = ant_line.get(&frame->closure->func->chunk.lines, instruction);
+
+      fprintf(stderr, "[line %d] in ", line);
+     
+      if(func->name == NULL){
+         fprintf(stderr, "script\n");
+
+      } else {
+         fprintf(stderr, "%s()\n", func->name->chars);
+      }
 
-    } else {
-       fprintf(stderr, "%s()\n", func->name->chars);
     }
 
+    fiber = fiber->caller;
+
+    if (fiber != NULL) {
+      frames      = fiber->frames;
+      frame_count = fiber->frame_count;
+    }
   }
 
+  ant_fiber.unwind(vm);
+
+  Stack *stack = vm->stack;
   STACK_RESET();
+  vm->frame_count        = 0;
+  vm->open_upvalues.head = NULL;
 }
-